@@ -1,226 +1,737 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#include "calc.h"
-#include "vec.h"
-#include "kernel.h"
-#include "eos.h"
-#include "iobin.h"
-#include "common.h"
-#include <cstring>
-#include <cstdio>
-#include <cstdlib>
-#include <cmath>
-#include <ctime>
-#include <omp.h>
-using namespace std;
-
-// external force field
-const float Calc::externalForce[] = { 0.0f, -0.00981f, 0.0f };
-// D factor to calculate repulsive Lennard-Jones forces
-const float Calc::LenJonD  = 10.0f;
-// P1 power to calculate repulsive Lennard-Jones forces
-const float Calc::LenJonP1 = 4.0f;
-// P2 power to calculate repulsive Lennard-Jones forces
-const float Calc::LenJonP2 = 2.0f;
-
-// kernel and equation of state 
-KernelBase* Calc::kernel = NULL;
-EOSBase* Calc::eos = NULL;
-
-// Constructor.
-// Initialize calculation module - choose appropriate 
-// kernel, equation of state, etc. according to parameters.
-Calc::Calc()
-{
-    // search for the required kernel
-    char *kernelType = parameters.kernelType;
-    if ( !strcmp( kernelType, "SPLINE") )
-        kernel = new KernelSpline();
-    else if ( !strcmp( kernelType, "SPIKY") )
-        kernel = new KernelSpiky();
-
-    // search for the required EOS
-    char *eosType = parameters.eosType;
-    if ( !strcmp( eosType, "BATCHELOR") )
-        eos = new EOSBatchelor();
-    else if ( !strcmp( eosType, "DESBRUN") )
-        eos = new EOSDesbrun();
-}
-
-// Destructor.
-Calc::~Calc()
-{
-    // deallocate
-    delete kernel;
-    delete eos;
-}
-
-// Run simulator.
-void 
-Calc::run()
-{
-    int nfile = 1;
-
-#ifdef YAPS_TIME
-    time_t t1, t2;
-    time( &t1);
-#endif
-
-    for ( int i = 0; i < parameters.nsteps; i++ )
-    {
-        doCalcStep();
-
-        if ( !(i % parameters.outFreq) )
-        {
-            IOBin().writeData( nfile++);
-
-#ifdef YAPS_TIME
-            time( &t2);
-            printf( "timing : %6.0f seconds\n", difftime( t2, t1));
-            time( &t1);
-#endif
-        }
-    }
-}
-
-// Do one calculation step.
-void
-Calc::doCalcStep()
-{
-    float gradKernel[3];
-    float pressTerm;
-    float viscTerm;
-    float viscNu;
-    float Vij[3];
-    float Rij[3];
-    float tmp1, tmp2;
-    int   i, j, d;
-
-    // parameters
-    float sos               = parameters.sos;
-    float smoothR           = parameters.smoothR;
-    float viscAlpha         = parameters.viscAlpha;
-    float viscBeta          = parameters.viscBeta;
-    float particlesDistrib  = parameters.particlesDistrib;
-    
-    // Nu factor to calculate viscosity
-    viscNu = 0.01f * smoothR * smoothR;
-    
-    // calculate the particles' pressures
-    eos->calcPress();
-
-    // calculate the rates of change of velocities and the 
-    // rates of change of densities for all the particles
-    // J.J.Monaghan, Simulating Free Surface Flows with SPH, 
-    // J.Comput.Phys., 110, 399-406, 1994.
-#pragma omp parallel for schedule(dynamic,50) private(gradKernel,pressTerm,viscTerm,Vij,Rij,tmp1,tmp2,j,d)
-    for ( i = 0; i < (int)particles.size(); i++ )
-    {
-        // take into account the external force field
-        memcpy( particles[i].accel, externalForce, sizeof(externalForce));
-        
-        particles[i].dervDens = 0.0f;
-
-        // calculate forces between smoothing particles 
-        // and update the rate of change of the density
-        for ( j = 0; j < (int)particles.size(); j++ )
-        {
-            if ( j == i )
-                continue;
-
-            vectorSubstraction( Rij, particles[i].pos, particles[j].pos);
-
-            // get the kernel's gradient at the point Rij
-            if ( kernel->getGrad( gradKernel, Rij) )
-                continue;
-            
-            // take into account the viscocity of the medium
-            vectorSubstraction( Vij, particles[i].vel, particles[j].vel);
-            tmp1 = vectorInnerproduct( Rij, Vij);
-            if ( tmp1 < 0.0f )
-            {
-                tmp2 = vectorInnerproduct( Rij, Rij);
-                tmp1 = smoothR * tmp1 / (tmp2 + viscNu);
-                viscTerm = 2.0f * tmp1 * (-viscAlpha * sos + viscBeta * tmp1) / 
-                          (particles[i].dens + particles[j].dens);
-            }
-            else
-            {
-                viscTerm = 0.0f;
-            }
-
-            // take into account the difference of the particles' pressures
-            pressTerm = 
-                particles[i].press / (particles[i].dens * particles[i].dens) +
-                particles[j].press / (particles[j].dens * particles[j].dens);
-            
-            // update the acceleration of the particle
-            tmp1 = particles[j].mass * (pressTerm + viscTerm);
-            for ( d = 0; d < dimension; d++ )
-                particles[i].accel[d] -= tmp1 * gradKernel[d];
-
-            // update the rate of change of the density for the particle
-            tmp1 = vectorInnerproduct( Vij, gradKernel);
-            particles[i].dervDens += particles[j].mass * tmp1;
-        }
-
-        // calculate the Lennard-Jones forces between 
-        // the particle and the boundary particles
-        for ( j = 0; j < (int)bparticles.size(); j++ )
-        {
-            vectorSubstraction( Rij, particles[i].pos, bparticles[j].pos);
-            tmp1 = vectorInnerproduct( Rij, Rij);
-            tmp2 = particlesDistrib / sqrt( tmp1);
-            // only repulsive forces are taken into account
-            if ( tmp2 > 1.0f )
-            {
-                tmp1 = (pow( tmp2, LenJonP1) - pow( tmp2, LenJonP2)) * 
-                       LenJonD / tmp1;
-                for ( d = 0; d < dimension; d++ )
-                    particles[i].accel[d] += Rij[d] * tmp1;
-            }
-        }
-    }
-
-    // time integration
-    leapfrogIntegration();
-    
-    return;
-} // doCalcStep
-
-// 'leap-frog' integration scheme
-// M.P.Allen and D.J.Tildesley, Computer Simulation 
-// of Liquids, Oxford Univ.Press, 1987.
-void
-Calc::leapfrogIntegration()
-{
-    int i;
-    int d;
-
-    float timeStep = parameters.timeStep;
-    
-    // calculate new positions, velocities and densities for all the particles
-    for ( i = 0; i < (int)particles.size(); i++ )
-    {
-        for ( d = 0; d < dimension; d++ )
-        {
-            // new interval velocity (t+dt/2)
-            particles[i].ivalVel[d] += particles[i].accel[d] * timeStep;
-            // new position (t+dt)
-            particles[i].pos[d] += particles[i].ivalVel[d] * timeStep;
-            // new velocity (t+dt)
-            particles[i].vel[d] = particles[i].ivalVel[d] + 
-                                  particles[i].accel[d] * timeStep / 2.0f;
-        }
-        // new interval density (t+dt/2)
-        particles[i].ivalDens += particles[i].dervDens * timeStep;
-        // new density (t+dt)
-        particles[i].dens = particles[i].ivalDens +
-                            particles[i].dervDens * timeStep / 2.0f;
-    }
-    
-    return;
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "calc.h"
+#include "vec.h"
+#include "kernel.h"
+#include "eos.h"
+#include "iobin.h"
+#include "profile.h"
+#include "telemetry.h"
+#include "framering.h"
+#include "common.h"
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <omp.h>
+using namespace std;
+
+// external force field
+const float Calc::externalForce[] = { 0.0f, -0.00981f, 0.0f };
+// D factor to calculate repulsive Lennard-Jones forces
+const float Calc::LenJonD  = 10.0f;
+// P1 power to calculate repulsive Lennard-Jones forces
+const float Calc::LenJonP1 = 4.0f;
+// P2 power to calculate repulsive Lennard-Jones forces
+const float Calc::LenJonP2 = 2.0f;
+// number of particles in a chunk of parallel loops
+int Calc::chunkSize = 50;
+// size of the cells of the neighbor grids (in units of the radius 
+// of the lists) and skin of the lists (in units of 2*smoothR)
+float Calc::cellFactor = 1.0f;
+float Calc::skinFactor = 0.1f;
+// relative margin of the radius of the lists against rounding
+const float Calc::listSlack = 1.0e-4f;
+
+// neighbor grids and lists
+CellGrid Calc::prtsGrid;
+CellGrid Calc::bprtsGrid;
+vector<int> Calc::nbrStart;
+vector<int> Calc::nbrList;
+vector<int> Calc::bnbrStart;
+vector<int> Calc::bnbrList;
+vector<float> Calc::nbrPos;
+int Calc::nbrBuilds = 0;
+
+// kernel and equation of state 
+KernelBase* Calc::kernel = NULL;
+EOSBase* Calc::eos = NULL;
+
+// Constructor.
+// Initialize calculation module - choose appropriate 
+// kernel, equation of state, etc. according to parameters.
+Calc::Calc()
+{
+    // search for the required kernel
+    char *kernelType = parameters.kernelType;
+    if ( !strcmp( kernelType, "SPLINE") )
+        kernel = new KernelSpline();
+    else if ( !strcmp( kernelType, "SPIKY") )
+        kernel = new KernelSpiky();
+
+    // search for the required EOS
+    char *eosType = parameters.eosType;
+    if ( !strcmp( eosType, "BATCHELOR") )
+        eos = new EOSBatchelor();
+    else if ( !strcmp( eosType, "DESBRUN") )
+        eos = new EOSDesbrun();
+
+    // settings of the neighbor search and the parallel loops
+    if ( parameters.cellSize > 0.0f )
+        cellFactor = parameters.cellSize;
+    if ( parameters.skin > 0.0f )
+        skinFactor = parameters.skin;
+    if ( parameters.chunkSize > 0 )
+        chunkSize = parameters.chunkSize;
+    if ( parameters.threads > 0 )
+        omp_set_num_threads( parameters.threads);
+}
+
+// Destructor.
+Calc::~Calc()
+{
+    // deallocate
+    delete kernel;
+    delete eos;
+}
+
+// Run simulator. The function returns 0 if succeeded and 1 if the 
+// calculation has been stopped.
+int 
+Calc::run( int firstStep,   // first step to perform
+           int firstFile)   // number of the first output file
+{
+    int nfile = firstFile;
+    int chkptFreq = parameters.chkptFreq;
+    int stopped = 0;
+
+#ifdef YAPS_TIME
+    double t1, t2;
+#endif
+
+    // choose the settings before the timers are started
+    if ( parameters.tuneSteps > 0 )
+        tune( parameters.tuneSteps);
+    printf( "settings : cell size %.2f (of cutoff plus skin), skin %.2f "
+            "(of 2*smoothR), chunk size %d, threads %d\n", cellFactor, 
+            skinFactor, chunkSize, omp_get_max_threads());
+    nbrBuilds = 0;
+
+#ifdef YAPS_TIME
+    t1 = omp_get_wtime();
+#endif
+    PROFILE_INIT();
+    Telemetry::open( firstStep, nfile);
+    FrameRing::create();
+
+    for ( int i = firstStep; i < parameters.nsteps; i++ )
+    {
+        if ( doCalcStep() )
+        {
+            printf( "Calculation stopped at step %d\n", i + 1);
+            stopped = 1;
+            break;
+        }
+        PROFILE_STEP();
+
+        PROFILE_START( PHASE_OUTPUT);
+        if ( !(i % parameters.outFreq) )
+        {
+            PROFILE_EVENT_START( TRACE_WRITE);
+            Telemetry::startOutput();
+            if ( !parameters.liveOnly )
+                IOBin().writeData( nfile);
+            FrameRing::publish( nfile, i + 1);
+            nfile++;
+            Telemetry::stopOutput();
+            PROFILE_EVENT_STOP( TRACE_WRITE, PHASE_OUTPUT, nfile - 1);
+
+#ifdef YAPS_TIME
+            t2 = omp_get_wtime();
+            printf( "timing : %10.3f seconds\n", t2 - t1);
+            t1 = t2;
+#endif
+        }
+
+        // save the full state to be able to restart from the next step
+        if ( chkptFreq > 0 && 
+             (!((i + 1) % chkptFreq) || i + 1 == parameters.nsteps) )
+        {
+            PROFILE_EVENT_START( TRACE_CHECKPOINT);
+            if ( IOBin().writeCheckpoint( i + 1, nfile) )
+                printf( "Can't write checkpoint at step %d\n", i + 1);
+            PROFILE_EVENT_STOP( TRACE_CHECKPOINT, PHASE_OUTPUT, i + 1);
+        }
+        PROFILE_STOP( PHASE_OUTPUT);
+
+        Telemetry::update( i + 1, nfile);
+    }
+    FrameRing::destroy();
+    Telemetry::close();
+    printf( "neighbors : lists built %d times in %d steps\n", 
+            nbrBuilds, parameters.nsteps - firstStep);
+
+    // summary of timers
+    PROFILE_REPORT();
+
+    return stopped;
+}
+
+// Choose the settings which make the steps the fastest. The settings 
+// are tuned one after another (threads, cells of the grids, skin of 
+// the lists, chunks of the parallel loops) and the fastest candidate 
+// of each one is kept for the next ones. The settings given in the 
+// input file aren't tuned. Each candidate is timed over 'steps' trial 
+// steps from the current state, which is restored after the trial. 
+// The candidates whose trial fails are skipped.
+void
+Calc::tune( int steps)   // number of trial steps per candidate
+{
+    // candidates
+    static const float cellFactors[] = { 0.5f, 0.75f, 1.0f, 1.5f };
+    static const float skinFactors[] = { 0.0f, 0.05f, 0.1f, 0.2f, 0.4f };
+    static const int chunkSizes[] = { 10, 25, 50, 100, 200, 400 };
+    int cellsNum = sizeof(cellFactors) / sizeof(cellFactors[0]);
+    int skinsNum = sizeof(skinFactors) / sizeof(skinFactors[0]);
+    int chunksNum = sizeof(chunkSizes) / sizeof(chunkSizes[0]);
+
+    double start = omp_get_wtime();
+    double t, best;
+    int c, n;
+
+    // threads: 1, 2, 4, ... and all of them
+    int maxThreads = omp_get_max_threads();
+    if ( parameters.threads <= 0 && maxThreads > 1 )
+    {
+        int bestThreads = maxThreads;
+        best = -1.0;
+        for ( n = 1; ; n = min( 2 * n, maxThreads) )
+        {
+            omp_set_num_threads( n);
+            t = timeSteps( steps);
+            if ( t < 0.0 )
+                printf( "tuning : threads %d : failed\n", n);
+            else
+                printf( "tuning : threads %d : %.3f seconds\n", n, t);
+            if ( t >= 0.0 && ( best < 0.0 || t < best ) )
+            {
+                best = t;
+                bestThreads = n;
+            }
+            if ( n == maxThreads )
+                break;
+        }
+        omp_set_num_threads( bestThreads);
+    }
+
+    // size of the cells of the grids
+    if ( parameters.cellSize <= 0.0f )
+    {
+        float bestFactor = cellFactor;
+        best = -1.0;
+        for ( c = 0; c < cellsNum; c++ )
+        {
+            cellFactor = cellFactors[c];
+            t = timeSteps( steps);
+            if ( t < 0.0 )
+                printf( "tuning : cell size %.2f : failed\n", cellFactor);
+            else
+                printf( "tuning : cell size %.2f : %.3f seconds\n", cellFactor, t);
+            if ( t >= 0.0 && ( best < 0.0 || t < best ) )
+            {
+                best = t;
+                bestFactor = cellFactor;
+            }
+        }
+        cellFactor = bestFactor;
+    }
+
+    // skin of the lists
+    if ( parameters.skin <= 0.0f )
+    {
+        float bestFactor = skinFactor;
+        best = -1.0;
+        for ( c = 0; c < skinsNum; c++ )
+        {
+            skinFactor = skinFactors[c];
+            t = timeSteps( steps);
+            if ( t < 0.0 )
+                printf( "tuning : skin %.2f : failed\n", skinFactor);
+            else
+                printf( "tuning : skin %.2f : %.3f seconds\n", skinFactor, t);
+            if ( t >= 0.0 && ( best < 0.0 || t < best ) )
+            {
+                best = t;
+                bestFactor = skinFactor;
+            }
+        }
+        skinFactor = bestFactor;
+    }
+
+    // chunks only matter if there are several threads
+    if ( parameters.chunkSize <= 0 && omp_get_max_threads() > 1 )
+    {
+        int bestSize = chunkSize;
+        best = -1.0;
+        for ( c = 0; c < chunksNum; c++ )
+        {
+            chunkSize = chunkSizes[c];
+            t = timeSteps( steps);
+            if ( t < 0.0 )
+                printf( "tuning : chunk size %d : failed\n", chunkSize);
+            else
+                printf( "tuning : chunk size %d : %.3f seconds\n", chunkSize, t);
+            if ( t >= 0.0 && ( best < 0.0 || t < best ) )
+            {
+                best = t;
+                bestSize = chunkSize;
+            }
+        }
+        chunkSize = bestSize;
+    }
+
+    printf( "tuning : %.3f seconds\n", omp_get_wtime() - start);
+
+    return;
+} // tune
+
+// Time 'steps' trial steps. They follow an untimed step which builds 
+// the neighbor lists, so the time doesn't depend on the full build 
+// every trial would start with otherwise. The particles are restored 
+// afterwards and the lists are built anew by the next step. The 
+// function returns -1 if a step has failed.
+double
+Calc::timeSteps( int steps)   // number of steps
+{
+    Particles saved = particles;
+
+    nbrStart.clear();
+    int failed = doCalcStep();
+    double t = omp_get_wtime();
+    for ( int i = 0; i < steps && !failed; i++ )
+        failed = doCalcStep();
+    t = omp_get_wtime() - t;
+
+    particles = saved;
+    nbrStart.clear();
+
+    return failed ? -1.0 : t;
+} // timeSteps
+
+// Do one calculation step. The function returns 0 if 
+// succeeded and 1 if the neighbors can't be found.
+int
+Calc::doCalcStep()
+{
+    int c;
+
+    // parallel loops over the particles are split in chunks by hand 
+    // to be able to see them on the timeline
+    int prtsNum = (int)particles.size();
+    int chunksNum = (prtsNum + chunkSize - 1) / chunkSize;
+
+    // neighbors of the particles
+    PROFILE_START( PHASE_NEIGHBORS);
+    int res = updateNeighbors();
+    PROFILE_STOP( PHASE_NEIGHBORS);
+    if ( res )
+        return 1;
+    
+    // calculate the particles' pressures
+    PROFILE_START( PHASE_EOS);
+    eos->calcPress();
+    PROFILE_STOP( PHASE_EOS);
+
+    // calculate the rates of change of velocities and the 
+    // rates of change of densities for all the particles
+    PROFILE_START( PHASE_FLUID);
+#pragma omp parallel private(c)
+    {
+        PROFILE_THREAD_START( PHASE_FLUID);
+#pragma omp for schedule(dynamic) nowait
+        for ( c = 0; c < chunksNum; c++ )
+        {
+            PROFILE_EVENT_START( TRACE_CHUNK);
+            int first = c * chunkSize;
+            calcFluidForces( first, min( first + chunkSize, prtsNum));
+            PROFILE_EVENT_STOP( TRACE_CHUNK, PHASE_FLUID, first);
+        }
+        PROFILE_THREAD_STOP( PHASE_FLUID);
+    }
+    PROFILE_STOP( PHASE_FLUID);
+
+    // calculate the Lennard-Jones forces between 
+    // the particles and the boundary particles
+    PROFILE_START( PHASE_BOUNDARY);
+#pragma omp parallel private(c)
+    {
+        PROFILE_THREAD_START( PHASE_BOUNDARY);
+#pragma omp for schedule(dynamic) nowait
+        for ( c = 0; c < chunksNum; c++ )
+        {
+            PROFILE_EVENT_START( TRACE_CHUNK);
+            int first = c * chunkSize;
+            calcBoundaryForces( first, min( first + chunkSize, prtsNum));
+            PROFILE_EVENT_STOP( TRACE_CHUNK, PHASE_BOUNDARY, first);
+        }
+        PROFILE_THREAD_STOP( PHASE_BOUNDARY);
+    }
+    PROFILE_STOP( PHASE_BOUNDARY);
+
+    // time integration
+    PROFILE_START( PHASE_INTEGRATION);
+    leapfrogIntegration();
+    PROFILE_STOP( PHASE_INTEGRATION);
+    
+    return 0;
+} // doCalcStep
+
+// Rebuild the neighbor lists if there are none yet or some particle 
+// has moved further than a half of the skin since they were built 
+// (two particles could have got closer by the whole skin then). 
+// The function returns 0 if succeeded and 1 otherwise.
+int
+Calc::updateNeighbors()
+{
+    int prtsNum = (int)particles.size();
+    float halfSkin = skinFactor * parameters.smoothR;
+    float maxDist2 = 0.0f;
+    int i;
+
+    if ( (int)nbrStart.size() == prtsNum + 1 )
+    {
+#pragma omp parallel private(i)
+        {
+            float dist2, tmp;
+            float local = 0.0f;
+#pragma omp for
+            for ( i = 0; i < prtsNum; i++ )
+            {
+                dist2 = 0.0f;
+                for ( int d = 0; d < dimension; d++ )
+                {
+                    tmp = particles[i].pos[d] - nbrPos[3 * i + d];
+                    dist2 += tmp * tmp;
+                }
+                if ( dist2 > local )
+                    local = dist2;
+            }
+#pragma omp critical
+            if ( local > maxDist2 )
+                maxDist2 = local;
+        }
+        if ( maxDist2 <= halfSkin * halfSkin )
+            return 0;
+    }
+
+    return buildNeighbors();
+} // updateNeighbors
+
+// Build the neighbor lists. The particles and the boundary particles 
+// are sorted into the cells of the grids, and the neighbors of each 
+// particle are searched in the cells around it within the cutoff 
+// (the kernel's support or the range of Lennard-Jones forces) plus 
+// the skin. The lists are sorted, so the forces are summed up in the 
+// same order as if all the particles were checked. The function 
+// returns 0 if succeeded and 1 if some particles have non-finite 
+// positions (the calculation has blown up).
+int
+Calc::buildNeighbors()
+{
+    int prtsNum = (int)particles.size();
+    int bprtsNum = (int)bparticles.size();
+    int stride = sizeof(struct Particle) / sizeof(float);
+    int bstride = sizeof(struct BParticle) / sizeof(float);
+    const float *pnts = prtsNum ? particles[0].pos : NULL;
+    const float *bpnts = bprtsNum ? bparticles[0].pos : NULL;
+    int chunksNum = (prtsNum + chunkSize - 1) / chunkSize;
+    int c, i;
+
+    // radii of the search
+    float support = 2.0f * parameters.smoothR;
+    float skin = skinFactor * support;
+    float radius = (support + skin) * (1.0f + listSlack);
+    float bradius = (parameters.particlesDistrib + skin) * (1.0f + listSlack);
+
+    // sort the points into the cells
+    int nonFinite = prtsGrid.build( pnts, stride, prtsNum, 
+                                    cellFactor * radius);
+    nonFinite += bprtsGrid.build( bpnts, bstride, bprtsNum, 
+                                  cellFactor * bradius);
+    if ( nonFinite > 0 )
+    {
+        printf( "neighbors : %d particles have non-finite positions\n", 
+                nonFinite);
+        nbrStart.clear();
+        return 1;
+    }
+
+    // count the neighbors of each particle
+    nbrStart.resize( prtsNum + 1);
+    bnbrStart.resize( prtsNum + 1);
+#pragma omp parallel for schedule(dynamic) private(c, i)
+    for ( c = 0; c < chunksNum; c++ )
+    {
+        for ( i = c * chunkSize; i < min( (c + 1) * chunkSize, prtsNum); i++ )
+        {
+            nbrStart[i + 1] = findNeighbors( prtsGrid, pnts, stride, i, 
+                                             particles[i].pos, radius, NULL);
+            bnbrStart[i + 1] = findNeighbors( bprtsGrid, bpnts, bstride, -1, 
+                                              particles[i].pos, bradius, NULL);
+        }
+    }
+    nbrStart[0] = bnbrStart[0] = 0;
+    for ( i = 0; i < prtsNum; i++ )
+    {
+        nbrStart[i + 1] += nbrStart[i];
+        bnbrStart[i + 1] += bnbrStart[i];
+    }
+
+    // fill the lists and remember the positions
+    nbrList.resize( nbrStart[prtsNum]);
+    bnbrList.resize( bnbrStart[prtsNum]);
+    nbrPos.resize( 3 * prtsNum);
+#pragma omp parallel for schedule(dynamic) private(c, i)
+    for ( c = 0; c < chunksNum; c++ )
+    {
+        for ( i = c * chunkSize; i < min( (c + 1) * chunkSize, prtsNum); i++ )
+        {
+            if ( nbrStart[i + 1] > nbrStart[i] )
+            {
+                int *list = &nbrList[nbrStart[i]];
+                findNeighbors( prtsGrid, pnts, stride, i, 
+                               particles[i].pos, radius, list);
+                sort( list, list + (nbrStart[i + 1] - nbrStart[i]));
+            }
+            if ( bnbrStart[i + 1] > bnbrStart[i] )
+            {
+                int *list = &bnbrList[bnbrStart[i]];
+                findNeighbors( bprtsGrid, bpnts, bstride, -1, 
+                               particles[i].pos, bradius, list);
+                sort( list, list + (bnbrStart[i + 1] - bnbrStart[i]));
+            }
+            memcpy( &nbrPos[3 * i], particles[i].pos, sizeof(particles[i].pos));
+        }
+    }
+    nbrBuilds++;
+
+    return 0;
+} // buildNeighbors
+
+// Search for the points of the grid 'grid' within the radius 'radius' 
+// of the position 'pos' and store their indices in 'list' (if it isn't 
+// NULL), the point 'self' is skipped. The cells are scanned row by row 
+// as the cells of a row are adjacent in the grid. The function returns 
+// the number of the points found.
+int
+Calc::findNeighbors( const CellGrid &grid,  // grid of the points
+                     const float *pnts,     // array of points
+                     int stride,            // stride of the array
+                     int self,              // point to skip (-1 - none)
+                     const float *pos,      // position
+                     float radius,          // radius of the search
+                     int *list)             // found points (NULL - none)
+{
+    int coords[3], lower[3], upper[3];
+    float dist2, tmp;
+    float radius2 = radius * radius;
+    int reach = (int)ceil( radius / grid.cellSize);
+    int iy, iz, j, k, d;
+    int n = 0;
+
+    // range of the cells around the position
+    grid.getCellCoords( pos, coords);
+    for ( d = 0; d < 3; d++ )
+    {
+        lower[d] = max( coords[d] - reach, 0);
+        upper[d] = min( coords[d] + reach, grid.dims[d] - 1);
+    }
+    if ( lower[0] > upper[0] )
+        return 0;
+
+    for ( iz = lower[2]; iz <= upper[2]; iz++ )
+    {
+        for ( iy = lower[1]; iy <= upper[1]; iy++ )
+        {
+            int first = grid.getCell( lower[0], iy, iz);
+            int last = grid.getCell( upper[0], iy, iz);
+            for ( k = grid.cellStart[first]; k < grid.cellStart[last + 1]; k++ )
+            {
+                j = grid.index[k];
+                if ( j == self )
+                    continue;
+                const float *pnt = pnts + (size_t)j * stride;
+                dist2 = 0.0f;
+                for ( d = 0; d < dimension; d++ )
+                {
+                    tmp = pos[d] - pnt[d];
+                    dist2 += tmp * tmp;
+                }
+                if ( dist2 > radius2 )
+                    continue;
+                if ( list != NULL )
+                    list[n] = j;
+                n++;
+            }
+        }
+    }
+
+    return n;
+} // findNeighbors
+
+// Calculate the rates of change of velocities and the rates of 
+// change of densities for the particles from 'first' to 'last' 
+// (not included) taking into account the smoothing particles of 
+// their neighbor lists.
+// J.J.Monaghan, Simulating Free Surface Flows with SPH, 
+// J.Comput.Phys., 110, 399-406, 1994.
+void
+Calc::calcFluidForces( int first,   // first particle
+                       int last)    // last particle (not included)
+{
+    float gradKernel[3];
+    float pressTerm;
+    float viscTerm;
+    float viscNu;
+    float Vij[3];
+    float Rij[3];
+    float tmp1, tmp2;
+    int   i, j, k, d;
+    int   neighbors;
+    long long accepted = 0;
+
+    // parameters
+    float sos               = parameters.sos;
+    float smoothR           = parameters.smoothR;
+    float viscAlpha         = parameters.viscAlpha;
+    float viscBeta          = parameters.viscBeta;
+    
+    // Nu factor to calculate viscosity
+    viscNu = 0.01f * smoothR * smoothR;
+
+    for ( i = first; i < last; i++ )
+    {
+        // take into account the external force field
+        memcpy( particles[i].accel, externalForce, sizeof(externalForce));
+        
+        particles[i].dervDens = 0.0f;
+        neighbors = 0;
+
+        // calculate forces between smoothing particles 
+        // and update the rate of change of the density
+        for ( k = nbrStart[i]; k < nbrStart[i + 1]; k++ )
+        {
+            j = nbrList[k];
+            vectorSubstraction( Rij, particles[i].pos, particles[j].pos);
+
+            // get the kernel's gradient at the point Rij
+            if ( kernel->getGrad( gradKernel, Rij) )
+                continue;
+            neighbors++;
+            
+            // take into account the viscocity of the medium
+            vectorSubstraction( Vij, particles[i].vel, particles[j].vel);
+            tmp1 = vectorInnerproduct( Rij, Vij);
+            if ( tmp1 < 0.0f )
+            {
+                tmp2 = vectorInnerproduct( Rij, Rij);
+                tmp1 = smoothR * tmp1 / (tmp2 + viscNu);
+                viscTerm = 2.0f * tmp1 * (-viscAlpha * sos + viscBeta * tmp1) / 
+                          (particles[i].dens + particles[j].dens);
+            }
+            else
+            {
+                viscTerm = 0.0f;
+            }
+
+            // take into account the difference of the particles' pressures
+            pressTerm = 
+                particles[i].press / (particles[i].dens * particles[i].dens) +
+                particles[j].press / (particles[j].dens * particles[j].dens);
+            
+            // update the acceleration of the particle
+            tmp1 = particles[j].mass * (pressTerm + viscTerm);
+            for ( d = 0; d < dimension; d++ )
+                particles[i].accel[d] -= tmp1 * gradKernel[d];
+
+            // update the rate of change of the density for the particle
+            tmp1 = vectorInnerproduct( Vij, gradKernel);
+            particles[i].dervDens += particles[j].mass * tmp1;
+        }
+        accepted += neighbors;
+        PROFILE_NEIGHBORS( neighbors);
+    }
+
+    // all the particles of the lists are checked
+    PROFILE_PAIRS( PHASE_FLUID, nbrStart[last] - nbrStart[first], accepted);
+
+    return;
+} // calcFluidForces
+
+// Calculate the Lennard-Jones forces between the particles from 
+// 'first' to 'last' (not included) and the boundary particles 
+// of their neighbor lists.
+void
+Calc::calcBoundaryForces( int first,    // first particle
+                          int last)     // last particle (not included)
+{
+    float Rij[3];
+    float tmp1, tmp2;
+    int   i, j, k, d;
+    long long accepted = 0;
+
+    float particlesDistrib  = parameters.particlesDistrib;
+
+    for ( i = first; i < last; i++ )
+    {
+        for ( k = bnbrStart[i]; k < bnbrStart[i + 1]; k++ )
+        {
+            j = bnbrList[k];
+            vectorSubstraction( Rij, particles[i].pos, bparticles[j].pos);
+            tmp1 = vectorInnerproduct( Rij, Rij);
+            tmp2 = particlesDistrib / sqrt( tmp1);
+            // only repulsive forces are taken into account
+            if ( tmp2 > 1.0f )
+            {
+                accepted++;
+                tmp1 = (pow( tmp2, LenJonP1) - pow( tmp2, LenJonP2)) * 
+                       LenJonD / tmp1;
+                for ( d = 0; d < dimension; d++ )
+                    particles[i].accel[d] += Rij[d] * tmp1;
+            }
+        }
+    }
+
+    PROFILE_PAIRS( PHASE_BOUNDARY, bnbrStart[last] - bnbrStart[first], 
+                   accepted);
+
+    return;
+} // calcBoundaryForces
+
+// 'leap-frog' integration scheme
+// M.P.Allen and D.J.Tildesley, Computer Simulation 
+// of Liquids, Oxford Univ.Press, 1987.
+void
+Calc::leapfrogIntegration()
+{
+    int i;
+    int d;
+
+    float timeStep = parameters.timeStep;
+    
+    // calculate new positions, velocities and densities for all the particles
+    for ( i = 0; i < (int)particles.size(); i++ )
+    {
+        for ( d = 0; d < dimension; d++ )
+        {
+            // new interval velocity (t+dt/2)
+            particles[i].ivalVel[d] += particles[i].accel[d] * timeStep;
+            // new position (t+dt)
+            particles[i].pos[d] += particles[i].ivalVel[d] * timeStep;
+            // new velocity (t+dt)
+            particles[i].vel[d] = particles[i].ivalVel[d] + 
+                                  particles[i].accel[d] * timeStep / 2.0f;
+        }
+        // new interval density (t+dt/2)
+        particles[i].ivalDens += particles[i].dervDens * timeStep;
+        // new density (t+dt)
+        particles[i].dens = particles[i].ivalDens +
+                            particles[i].dervDens * timeStep / 2.0f;
+    }
+    
+    return;
 } // leapfrogIntegration
\ No newline at end of file
@@ -1,43 +1,83 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#ifndef YAPS_CALC_H
-#define YAPS_CALC_H
-
-#include "kernel.h"
-#include "eos.h"
-
-class Calc
-{
-
-public:
-    // constructor and destructor
-    Calc();
-    ~Calc();
-    // run simulator
-    static void run();
-
-private:
-
-    // external force field
-    static const float externalForce[];
-    // D factor to calculate repulsive Lennard-Jones forces
-    static const float LenJonD;
-    // P1 power to calculate repulsive Lennard-Jones forces
-    static const float LenJonP1;
-    // P2 power to calculate repulsive Lennard-Jones forces
-    static const float LenJonP2;
-    // kernel
-    static KernelBase *kernel;
-    // equation of state
-    static EOSBase *eos;    
-    // do one calculation step
-    static void doCalcStep();
-    // 'leap-frog' integration scheme
-    static void leapfrogIntegration();
-
-};
-
-#endif // YAPS_CALC_H
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_CALC_H
+#define YAPS_CALC_H
+
+#include "kernel.h"
+#include "eos.h"
+#include "grid.h"
+
+class Calc
+{
+    // microbenchmarks use the internals
+    friend class Bench;
+
+public:
+    // constructor and destructor
+    Calc();
+    ~Calc();
+    // run simulator starting from the step 'firstStep',
+    // the first output file gets the number 'firstFile'
+    static int  run( int firstStep = 0, int firstFile = 1);
+
+private:
+
+    // external force field
+    static const float externalForce[];
+    // D factor to calculate repulsive Lennard-Jones forces
+    static const float LenJonD;
+    // P1 power to calculate repulsive Lennard-Jones forces
+    static const float LenJonP1;
+    // P2 power to calculate repulsive Lennard-Jones forces
+    static const float LenJonP2;
+    // number of particles in a chunk of parallel loops
+    static int chunkSize;
+    // size of the cells of the neighbor grids (in units of the radius 
+    // of the lists) and skin of the lists (in units of 2*smoothR)
+    static float cellFactor;
+    static float skinFactor;
+    // relative margin of the radius of the lists against rounding
+    static const float listSlack;
+    // grids of the particles and the boundary particles
+    static CellGrid prtsGrid;
+    static CellGrid bprtsGrid;
+    // neighbors of the particle 'i' are nbrList[nbrStart[i]...
+    // nbrStart[i+1]-1] (sorted), the same for the boundary particles
+    static vector<int> nbrStart;
+    static vector<int> nbrList;
+    static vector<int> bnbrStart;
+    static vector<int> bnbrList;
+    // positions of the particles when the lists were built
+    static vector<float> nbrPos;
+    // number of builds of the lists
+    static int nbrBuilds;
+    // kernel
+    static KernelBase *kernel;
+    // equation of state
+    static EOSBase *eos;    
+    // choose the fastest settings by timing trial steps
+    static void tune( int steps);
+    // time 'steps' trial steps from the current state (-1 if failed)
+    static double timeSteps( int steps);
+    // do one calculation step
+    static int  doCalcStep();
+    // rebuild the neighbor lists if some particle has moved too far
+    static int  updateNeighbors();
+    // build the neighbor lists
+    static int  buildNeighbors();
+    // collect neighbors of a particle within the radius 'radius'
+    static int  findNeighbors( const CellGrid &grid, const float *pnts, 
+                               int stride, int self, const float *pos, 
+                               float radius, int *list);
+    // calculate forces for a range of particles
+    static void calcFluidForces( int first, int last);
+    static void calcBoundaryForces( int first, int last);
+    // 'leap-frog' integration scheme
+    static void leapfrogIntegration();
+
+};
+
+#endif // YAPS_CALC_H
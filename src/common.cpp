@@ -1,24 +1,24 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#include "common.h"
-
-// Dimension of the simulation
-int dimension = -1;
-
-// All parameters
-Parameters parameters;
-
-// All smoothing particles
-Particles particles;
-
-// All boundary particles
-BParticles bparticles;
-
-// All obstacles
-Obstacles obstacles;
-
-// Colors for rendering
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "common.h"
+
+// Dimension of the simulation
+int dimension = -1;
+
+// All parameters
+Parameters parameters;
+
+// All smoothing particles
+Particles particles;
+
+// All boundary particles
+BParticles bparticles;
+
+// All obstacles
+Obstacles obstacles;
+
+// Colors for rendering
 //RendColors rendColors;
\ No newline at end of file
@@ -1,89 +1,120 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#ifndef YAPS_COMMON_H
-#define YAPS_COMMON_H
-
-#include <vector>
-using namespace std;
-
-// Dimension of the simulation
-extern int dimension;
-
-// Parameters
-struct Parameters
-{
-    // initial particle distribution
-    float   particlesDistrib;
-    // initial boundary particle distribution
-    float   bparticlesDistrib;
-    // speed of sound
-    float   sos;
-    // kernel to use in the calculations
-    char    kernelType[20];
-    // kernel smoothing length
-    float   smoothR;
-    // equation of state to calculate pressures
-    char    eosType[20];
-    // alpha factor to calculate viscosity
-    float   viscAlpha;
-    // beta factor to calculate viscosity
-    float   viscBeta;
-    // time step of integration
-    float   timeStep;
-    // number of steps to perform
-    int     nsteps;
-    // output frequence
-    int     outFreq;
-    // clipping volume (the area to render)
-    float   clipVolume;
-    // radius to draw particles
-    float   particlesRadius;
-};
-extern Parameters parameters;
-
-// Smoothing particles
-struct Particle
-{
-    int no;              // material number
-    float pos[3];        // position (x,y,z)
-    float vel[3];        // velocity vector (Vx,Vy,Vz)
-    float ivalVel[3];    // velocity vector (Vx,Vy,Vz) at (t-dt/2)
-    float accel[3];      // acceleration (Ax,Ay,Az) of the particle
-    float dens;          // density at the location of the partile
-    float dens0;         // initial density at the location of the partile 
-    float ivalDens;      // density at (t-dt/2)
-    float dervDens;      // rate of change of the density (dro/dt)
-    float press;         // pressure at the location of the particle
-    float mass;          // mass carried by the particle
-};
-typedef vector<Particle> Particles;
-extern Particles particles;
-
-// Boundary particles
-struct BParticle
-{
-    float pos[3];        // position (x,y,z)
-};
-typedef vector<BParticle> BParticles;
-extern BParticles bparticles;
-
-// Obstacles
-struct Obstacle
-{
-    int no;             // material number
-    float vrtx1[3];     // vertex 1
-    float vrtx2[3];     // vertex 2
-    float vrtx3[3];     // vertex 3
-};
-typedef vector<Obstacle> Obstacles;
-extern Obstacles obstacles;
-
-// RGB colors for rendering
-//struct RendColors {
-//};
-//extern RendColors rendColors;
-
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_COMMON_H
+#define YAPS_COMMON_H
+
+#include <vector>
+using namespace std;
+
+// Dimension of the simulation
+extern int dimension;
+
+// Parameters
+struct Parameters
+{
+    // initial particle distribution
+    float   particlesDistrib;
+    // initial boundary particle distribution
+    float   bparticlesDistrib;
+    // speed of sound
+    float   sos;
+    // kernel to use in the calculations
+    char    kernelType[20];
+    // kernel smoothing length
+    float   smoothR;
+    // equation of state to calculate pressures
+    char    eosType[20];
+    // alpha factor to calculate viscosity
+    float   viscAlpha;
+    // beta factor to calculate viscosity
+    float   viscBeta;
+    // time step of integration
+    float   timeStep;
+    // number of steps to perform
+    int     nsteps;
+    // output frequence
+    int     outFreq;
+    // checkpoint frequence (0 - no checkpoints)
+    int     chkptFreq;
+    // clipping volume (the area to render)
+    float   clipVolume;
+    // radius to draw particles
+    float   particlesRadius;
+    // size of the cache of frames to render (MB)
+    int     cacheSize;
+    // rate of the playback (frames per second)
+    float   playFps;
+    // number of particles to draw while the view is being changed
+    int     lodBudget;
+    // number of frames to draw for each interval between output files
+    int     interpSteps;
+    // collect hardware performance counters (Linux only)
+    int     perfEvents;
+    // number of timeline events kept per thread (0 - no trace)
+    int     traceSize;
+    // publish status of the run in shared memory
+    int     telemetry;
+    // number of output frames kept in shared memory (0 - none)
+    int     liveFrames;
+    // don't write output files (frames are only kept in shared memory)
+    int     liveOnly;
+    // trial steps per candidate of the calibration (0 - no calibration)
+    int     tuneSteps;
+    // size of the cells of neighbor grids (units of cutoff plus skin)
+    float   cellSize;
+    // skin of the neighbor lists (in units of 2*smoothR)
+    float   skin;
+    // number of particles in a chunk of parallel loops
+    int     chunkSize;
+    // number of threads of the simulator
+    int     threads;
+};
+extern Parameters parameters;
+
+// Smoothing particles
+struct Particle
+{
+    int no;              // material number
+    int id;              // identifier (the same in all output files)
+    float pos[3];        // position (x,y,z)
+    float vel[3];        // velocity vector (Vx,Vy,Vz)
+    float ivalVel[3];    // velocity vector (Vx,Vy,Vz) at (t-dt/2)
+    float accel[3];      // acceleration (Ax,Ay,Az) of the particle
+    float dens;          // density at the location of the partile
+    float dens0;         // initial density at the location of the partile 
+    float ivalDens;      // density at (t-dt/2)
+    float dervDens;      // rate of change of the density (dro/dt)
+    float press;         // pressure at the location of the particle
+    float mass;          // mass carried by the particle
+};
+typedef vector<Particle> Particles;
+extern Particles particles;
+
+// Boundary particles
+struct BParticle
+{
+    float pos[3];        // position (x,y,z)
+};
+typedef vector<BParticle> BParticles;
+extern BParticles bparticles;
+
+// Obstacles
+struct Obstacle
+{
+    int no;             // material number
+    float vrtx1[3];     // vertex 1
+    float vrtx2[3];     // vertex 2
+    float vrtx3[3];     // vertex 3
+};
+typedef vector<Obstacle> Obstacles;
+extern Obstacles obstacles;
+
+// RGB colors for rendering
+//struct RendColors {
+//};
+//extern RendColors rendColors;
+
 #endif /* YAPS_COMMON_H */
\ No newline at end of file
@@ -0,0 +1,407 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "framecache.h"
+#include "iobin.h"
+#include "common.h"
+#include <cstdio>
+#include <omp.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+using namespace std;
+
+// Cached frame
+struct FrameCache::Entry
+{
+    int nfile;              // number of the file
+    Particles *prts;        // particles
+    size_t bytes;           // size of the frame
+    unsigned long lastUse;  // when the frame has been used
+};
+
+// number of frames to prefetch in the current direction
+const int FrameCache::prefetchDepth = 4;
+
+// cached frames
+vector<FrameCache::Entry> FrameCache::entries;
+// size of the cache
+size_t FrameCache::maxBytes = 0;
+size_t FrameCache::curBytes = 0;
+// counter to find least recently used frame
+unsigned long FrameCache::useCounter = 0;
+// current frame and direction
+int FrameCache::curFile = 0;
+int FrameCache::curDirection = 1;
+// frame to prefetch from
+int FrameCache::targetFile = 0;
+// average time to read a frame
+double FrameCache::decodeTime = 0.0;
+// frame the loader has failed to read last time
+int FrameCache::missingFile = -1;
+// prefetching is stopped
+char FrameCache::paused = 0;
+
+// lock of the cache
+static omp_lock_t cacheLock;
+
+// Initialize the cache, the memory occupied by 
+// cached frames is limited by 'maxBytes'.
+void
+FrameCache::init( size_t maxBytes)   // size of the cache
+{
+    omp_init_lock( &cacheLock);
+    FrameCache::maxBytes = maxBytes;
+
+    return;
+} // init
+
+// Get frame 'nfile' from the cache. If it isn't cached, it's read 
+// synchronously and put into the cache. The frame is kept while it's 
+// current or it's near the frame the loader prefetches from, so a 
+// frame to show has to be taken by 'getCurrent'. The function returns 
+// NULL if the frame doesn't exist.
+const Particles*
+FrameCache::get( int nfile)   // number of the file
+{
+    return fetch( nfile, 0, 0);
+} // get
+
+// Get frame 'nfile' like 'get' does and make it current with the 
+// direction 'direction' (see 'setCurrent'). It's done under the lock 
+// of the cache, so the loader can't evict the frame in between. The 
+// current frame isn't changed if the frame doesn't exist.
+const Particles*
+FrameCache::getCurrent( int nfile,       // number of the file
+                        int direction)   // direction
+{
+    return fetch( nfile, 1, direction);
+} // getCurrent
+
+// Get frame 'nfile' from the cache or read it, the frame becomes 
+// current with the direction 'direction' if 'current' is set.
+const Particles*
+FrameCache::fetch( int nfile,       // number of the file
+                   char current,    // make the frame current
+                   int direction)   // direction
+{
+    Particles *prts;
+    int i;
+
+    lock();
+    i = find( nfile);
+    if ( i >= 0 )
+    {
+        if ( current )
+        {
+            curFile = targetFile = nfile;
+            curDirection = (direction < 0) ? -1 : 1;
+        }
+        entries[i].lastUse = ++useCounter;
+        prts = entries[i].prts;
+        unlock();
+        return prts;
+    }
+    unlock();
+
+    // read the frame
+    prts = new Particles();
+    if ( IOBin().readData( nfile, *prts) )
+    {
+        delete prts;
+        return NULL;
+    }
+
+    lock();
+    if ( current )
+    {
+        curFile = targetFile = nfile;
+        curDirection = (direction < 0) ? -1 : 1;
+    }
+    // it could be read by the loader in the meantime
+    i = find( nfile);
+    if ( i >= 0 )
+    {
+        delete prts;
+        entries[i].lastUse = ++useCounter;
+        prts = entries[i].prts;
+    }
+    else
+    {
+        insert( nfile, prts);
+    }
+    unlock();
+
+    return prts;
+} // fetch
+
+// Get frame 'nfile' from the cache. The function returns NULL 
+// if it isn't cached, the frame isn't read in this case.
+const Particles*
+FrameCache::peek( int nfile)   // number of the file
+{
+    Particles *prts = NULL;
+    int i;
+
+    lock();
+    i = find( nfile);
+    if ( i >= 0 )
+    {
+        entries[i].lastUse = ++useCounter;
+        prts = entries[i].prts;
+    }
+    unlock();
+
+    return prts;
+} // peek
+
+// Set current frame 'nfile' and the direction of moving through the 
+// frames (+1/-1), the loader prefetches frames in this direction. The 
+// current frame is never evicted from the cache.
+void
+FrameCache::setCurrent( int nfile,       // number of the file
+                        int direction)   // direction
+{
+    lock();
+    curFile = nfile;
+    targetFile = nfile;
+    curDirection = (direction < 0) ? -1 : 1;
+    unlock();
+
+    return;
+} // setCurrent
+
+// Set the frame 'nfile' the loader prefetches frames from, it could be 
+// ahead of the current frame if the playback is behind the schedule.
+void
+FrameCache::setTarget( int nfile)   // number of the file
+{
+    lock();
+    targetFile = nfile;
+    unlock();
+
+    return;
+} // setTarget
+
+// Stop prefetching if 'paused' is set and resume it otherwise, the 
+// frames which aren't cached are still read by get() on demand.
+void
+FrameCache::setPaused( char paused)   // prefetching is stopped
+{
+    lock();
+    FrameCache::paused = paused;
+    unlock();
+
+    return;
+} // setPaused
+
+// Returns average time to read a frame in seconds.
+double
+FrameCache::getDecodeTime()
+{
+    double t;
+
+    lock();
+    t = decodeTime;
+    unlock();
+
+    return t;
+} // getDecodeTime
+
+// Returns 1 if the loader has failed to read frame 'nfile' last 
+// time it has tried (the file doesn't exist), and 0 otherwise.
+char
+FrameCache::isMissing( int nfile)   // number of the file
+{
+    char res;
+
+    lock();
+    res = (missingFile == nfile);
+    unlock();
+
+    return res;
+} // isMissing
+
+// Loop of the background loader - it reads the frames which are 
+// going to be shown next into the cache. The function never returns.
+void
+FrameCache::loaderLoop()
+{
+    Particles *prts;
+    double t;
+    int nfile;
+
+    while ( 1 )
+    {
+        // frame to read
+        lock();
+        nfile = nextToPrefetch();
+        unlock();
+
+        // nothing to do - wait
+        if ( nfile < 0 )
+        {
+#ifdef _WIN32
+            Sleep( 5);
+#else
+            usleep( 5000);
+#endif
+            continue;
+        }
+
+        // read the frame, a missing file is tried 
+        // again later (it could be written yet)
+        prts = new Particles();
+        t = omp_get_wtime();
+        if ( IOBin().readData( nfile, *prts) )
+        {
+            delete prts;
+            lock();
+            missingFile = nfile;
+            unlock();
+#ifdef _WIN32
+            Sleep( 50);
+#else
+            usleep( 50000);
+#endif
+            continue;
+        }
+
+        t = omp_get_wtime() - t;
+
+        lock();
+        if ( missingFile == nfile )
+            missingFile = -1;
+        if ( find( nfile) < 0 )
+            insert( nfile, prts);
+        else
+            delete prts;
+        // moving average of time to read a frame
+        decodeTime = (decodeTime > 0.0) ? 0.9 * decodeTime + 0.1 * t : t;
+        unlock();
+    }
+} // loaderLoop
+
+// Find frame 'nfile' in the cache, its index in the 
+// array of entries is returned or -1 if it isn't cached.
+int
+FrameCache::find( int nfile)   // number of the file
+{
+    for ( int i = 0; i < (int)entries.size(); i++ )
+    {
+        if ( entries[i].nfile == nfile )
+            return i;
+    }
+
+    return -1;
+} // find
+
+// Put frame 'nfile' with particles 'prts' into the cache 
+// and evict least recently used frames if it's full.
+void
+FrameCache::insert( int nfile,         // number of the file
+                    Particles *prts)   // particles
+{
+    Entry entry;
+    entry.nfile = nfile;
+    entry.prts = prts;
+    entry.bytes = prts->capacity() * sizeof(struct Particle);
+    entry.lastUse = ++useCounter;
+    entries.push_back( entry);
+    curBytes += entry.bytes;
+
+    evict();
+
+    return;
+} // insert
+
+// Returns the next frame to prefetch - the nearest frame starting from 
+// the target one in the current direction (and the previous one) which 
+// isn't cached. If the target frame doesn't exist, the frames following 
+// the current one are prefetched. The function returns -1 if all of them 
+// are cached already or don't fit in the cache.
+int
+FrameCache::nextToPrefetch()
+{
+    int first = (missingFile == targetFile) ? 
+                curFile + curDirection : targetFile;
+    int nfile;
+    int i;
+
+    if ( paused )
+        return -1;
+
+    for ( i = 0; i <= prefetchDepth + 1; i++ )
+    {
+        // the last one is the frame in the opposite direction
+        if ( i <= prefetchDepth )
+            nfile = first + i * curDirection;
+        else
+            nfile = first - curDirection;
+        if ( nfile < 0 || find( nfile) >= 0 )
+            continue;
+        // there is no room for it
+        if ( curBytes > maxBytes )
+            return -1;
+        return nfile;
+    }
+
+    return -1;
+} // nextToPrefetch
+
+// Evict least recently used frames while the cache is overfull. The 
+// current frame, the frames to prefetch and the frame which has just 
+// been used are kept.
+void
+FrameCache::evict()
+{
+    int lru;
+    int i, d;
+
+    while ( curBytes > maxBytes )
+    {
+        // find least recently used frame which isn't needed soon
+        lru = -1;
+        for ( i = 0; i < (int)entries.size(); i++ )
+        {
+            if ( entries[i].nfile == curFile )
+                continue;
+            d = (entries[i].nfile - targetFile) * curDirection;
+            if ( d >= -1 && d <= prefetchDepth )
+                continue;
+            // the frame which has just been used
+            if ( entries[i].lastUse == useCounter )
+                continue;
+            if ( lru < 0 || entries[i].lastUse < entries[lru].lastUse )
+                lru = i;
+        }
+        if ( lru < 0 )
+            break;
+
+        // evict it
+        curBytes -= entries[lru].bytes;
+        delete entries[lru].prts;
+        entries[lru] = entries.back();
+        entries.pop_back();
+    }
+
+    return;
+} // evict
+
+// Lock the cache.
+void
+FrameCache::lock()
+{
+    omp_set_lock( &cacheLock);
+} // lock
+
+// Unlock the cache.
+void
+FrameCache::unlock()
+{
+    omp_unset_lock( &cacheLock);
+} // unlock
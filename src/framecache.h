@@ -0,0 +1,79 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_FRAMECACHE_H
+#define YAPS_FRAMECACHE_H
+
+#include "common.h"
+
+class FrameCache
+{
+
+public:
+
+    // initialize the cache, its size is limited by 'maxBytes'
+    static void init( size_t maxBytes);
+    // get frame from the cache or read it, NULL if it doesn't exist
+    static const Particles* get( int nfile);
+    // the same, and make the frame current in the same step
+    static const Particles* getCurrent( int nfile, int direction);
+    // get frame from the cache, NULL if it isn't cached
+    static const Particles* peek( int nfile);
+    // set current frame and direction of moving through the frames
+    static void setCurrent( int nfile, int direction);
+    // set the frame to prefetch from
+    static void setTarget( int nfile);
+    // stop/resume prefetching (while the frames come from elsewhere)
+    static void setPaused( char paused);
+    // average time to read a frame (seconds)
+    static double getDecodeTime();
+    // the loader has failed to read the frame last time
+    static char isMissing( int nfile);
+    // loop of the background loader (never returns)
+    static void loaderLoop();
+
+private:
+
+    // number of frames to prefetch in the current direction
+    static const int prefetchDepth;
+
+    // cached frame
+    struct Entry;
+    // cached frames
+    static vector<Entry> entries;
+    // size of the cache
+    static size_t maxBytes;
+    static size_t curBytes;
+    // counter to find least recently used frame
+    static unsigned long useCounter;
+    // current frame and direction
+    static int curFile;
+    static int curDirection;
+    // frame to prefetch from
+    static int targetFile;
+    // average time to read a frame
+    static double decodeTime;
+    // frame the loader has failed to read last time
+    static int missingFile;
+    // prefetching is stopped
+    static char paused;
+
+    // get frame and make it current if 'current' is set
+    static const Particles* fetch( int nfile, char current, int direction);
+    // find frame in the cache
+    static int  find( int nfile);
+    // put frame into the cache
+    static void insert( int nfile, Particles *prts);
+    // next frame to prefetch, -1 if there is nothing to do
+    static int  nextToPrefetch();
+    // evict least recently used frames
+    static void evict();
+    // lock of the cache
+    static void lock();
+    static void unlock();
+
+};
+
+#endif // YAPS_FRAMECACHE_H
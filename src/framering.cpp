@@ -0,0 +1,249 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "framering.h"
+#include "shmem.h"
+#include "common.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#ifdef _WIN32
+#include <process.h>
+#include <direct.h>
+#define getpid _getpid
+#define getcwd _getcwd
+#else
+#include <unistd.h>
+#endif
+using namespace std;
+
+// Header of the ring, the slots follow it
+struct FrameRing::RingHeader
+{
+    char   magic[8];                // "YAPSFRM"
+    int    version;                 // version of the ring
+    int    pid;                     // process identifier
+    int    slotsNum;                // number of slots
+    int    prtsMax;                 // number of particles a slot can hold
+    size_t slotSize;                // size of a slot with its header
+    volatile int state;             // 0 - running, 1 - finished
+    volatile long long latest;      // sequential number of the newest 
+                                    // frame (-1 - none)
+    char   dir[256];                // working directory
+    char   pad[64];
+};
+
+// Header of a slot, the particles follow it
+struct FrameRing::SlotHeader
+{
+    volatile unsigned int seq;      // sequence number
+    int    nfile;                   // number of the output file
+    int    step;                    // steps performed
+    int    prtsNum;                 // number of particles
+    long long frame;                // sequential number of the frame
+    char   pad[40];
+};
+
+// prefix of the names of the rings
+const char* FrameRing::namePrefix = "yaps_frames.";
+// the ring and its size
+FrameRing::RingHeader* FrameRing::ring = NULL;
+size_t FrameRing::ringSize = 0;
+
+// Returns address of slot 'slot'.
+FrameRing::SlotHeader*
+FrameRing::getSlot( long long slot)     // number of the slot
+{
+    return (SlotHeader *)((char *)ring + sizeof(RingHeader) + 
+                          (size_t)slot * ring->slotSize);
+} // getSlot
+
+// Create the ring of LIVE_FRAMES slots for the current particles.
+void
+FrameRing::create()
+{
+    char name[64];
+
+    int slotsNum = parameters.liveFrames;
+    if ( slotsNum <= 0 || ring != NULL )
+        return;
+
+    int prtsMax = (int)particles.size();
+    size_t slotSize = sizeof(SlotHeader) + prtsMax * sizeof(struct Particle);
+    ringSize = sizeof(RingHeader) + slotsNum * slotSize;
+    SharedMemory::getName( namePrefix, getpid(), name);
+    ring = (RingHeader *)SharedMemory::create( name, ringSize);
+    if ( ring == NULL )
+    {
+        printf( "Can't create ring of frames %s (%.1f MB)\n", name, 
+                ringSize / 1048576.0);
+        return;
+    }
+
+    // the ring is zeroed on creation
+    strcpy( ring->magic, "YAPSFRM");
+    ring->version = 1;
+    ring->pid = getpid();
+    ring->slotsNum = slotsNum;
+    ring->prtsMax = prtsMax;
+    ring->slotSize = slotSize;
+    ring->latest = -1;
+    if ( getcwd( ring->dir, sizeof(ring->dir)) == NULL )
+        ring->dir[0] = '\0';
+    printf( "Frames are published in %s (%d frames, %.1f MB)\n", name, 
+            slotsNum, ringSize / 1048576.0);
+
+    return;
+} // create
+
+// Write the particles into the next slot of the ring as frame 'nfile'.
+void
+FrameRing::publish( int nfile,  // number of the output file
+                    int step)   // steps performed
+{
+    if ( ring == NULL )
+        return;
+
+    long long frame = ring->latest + 1;
+    SlotHeader *slot = getSlot( frame % ring->slotsNum);
+    int prtsNum = min( (int)particles.size(), ring->prtsMax);
+
+    slot->seq++;
+    SharedMemory::barrier();
+    slot->nfile = nfile;
+    slot->step = step;
+    slot->prtsNum = prtsNum;
+    slot->frame = frame;
+    if ( prtsNum > 0 )
+        memcpy( slot + 1, &particles[0], prtsNum * sizeof(struct Particle));
+    SharedMemory::barrier();
+    slot->seq++;
+    SharedMemory::barrier();
+    ring->latest = frame;
+
+    return;
+} // publish
+
+// Mark the run finished and remove the ring, the 
+// readers which have attached to it keep the frames.
+void
+FrameRing::destroy()
+{
+    if ( ring == NULL )
+        return;
+
+    char name[64];
+    ring->state = 1;
+    SharedMemory::getName( namePrefix, ring->pid, name);
+    SharedMemory::destroy( ring, ringSize, name);
+    ring = NULL;
+
+    return;
+} // destroy
+
+// Attach to the ring of process 'pid', if 'pid' is 0 the newest ring 
+// (the greatest process identifier) which has been created in the 
+// current directory is taken. The function returns 0 if succeeded 
+// and 1 otherwise.
+int
+FrameRing::attach( int pid)     // process identifier
+{
+    char name[64], dir[256];
+    vector<int> pids;
+    int i;
+
+    if ( pid > 0 )
+        pids.push_back( pid);
+    else
+        SharedMemory::list( namePrefix, pids);
+    if ( getcwd( dir, sizeof(dir)) == NULL )
+        dir[0] = '\0';
+
+    // rings with the greatest identifiers first
+    sort( pids.begin(), pids.end());
+    for ( i = (int)pids.size() - 1; i >= 0; i-- )
+    {
+        SharedMemory::getName( namePrefix, pids[i], name);
+        ring = (RingHeader *)SharedMemory::map( name, &ringSize);
+        if ( ring == NULL )
+            continue;
+        char ok = ringSize >= sizeof(RingHeader) && 
+                  !strcmp( ring->magic, "YAPSFRM") && 
+                  ringSize >= sizeof(RingHeader) + 
+                              ring->slotsNum * ring->slotSize;
+        if ( ok && pid == 0 )
+            ok = !strcmp( ring->dir, dir) && 
+                 SharedMemory::isAlive( ring->pid);
+        if ( ok )
+        {
+            printf( "Attached to %s (%d frames of %d particles)\n", name, 
+                    ring->slotsNum, ring->prtsMax);
+            return 0;
+        }
+        detach();
+    }
+
+    return 1;
+} // attach
+
+// Detach from the ring.
+void
+FrameRing::detach()
+{
+    SharedMemory::unmap( ring, ringSize);
+    ring = NULL;
+    ringSize = 0;
+
+    return;
+} // detach
+
+// Copy the newest frame into 'prts' if it's newer than frame 'last'. 
+// The function returns the sequential number of the frame or -1 if 
+// there is no new frame.
+long long
+FrameRing::readLatest( long long last,      // the last frame read
+                       Particles &prts,     // particles
+                       int *nfile,          // number of the output file
+                       int *step)           // steps performed
+{
+    if ( ring == NULL )
+        return -1;
+
+    // the writer could overwrite the slot while it's being 
+    // copied, then the next newest frame is taken
+    for ( int attempt = 0; attempt < 100; attempt++ )
+    {
+        long long frame = ring->latest;
+        if ( frame < 0 || frame <= last )
+            return -1;
+        SharedMemory::barrier();
+        SlotHeader *slot = getSlot( frame % ring->slotsNum);
+        unsigned int seq = slot->seq;
+        if ( seq & 1 )
+            continue;
+        SharedMemory::barrier();
+        int prtsNum = min( slot->prtsNum, ring->prtsMax);
+        *nfile = slot->nfile;
+        *step = slot->step;
+        prts.resize( prtsNum);
+        if ( prtsNum > 0 )
+            memcpy( &prts[0], slot + 1, prtsNum * sizeof(struct Particle));
+        SharedMemory::barrier();
+        if ( slot->seq == seq && slot->frame == frame )
+            return frame;
+    }
+
+    return -1;
+} // readLatest
+
+// Returns 1 if the simulation has finished (or died) and 0 otherwise.
+int
+FrameRing::isFinished()
+{
+    if ( ring == NULL )
+        return 1;
+
+    return ring->state == 1 || !SharedMemory::isAlive( ring->pid);
+} // isFinished
\ No newline at end of file
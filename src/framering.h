@@ -0,0 +1,58 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_FRAMERING_H
+#define YAPS_FRAMERING_H
+
+#include "common.h"
+#include <cstddef>
+
+// Ring of output frames in shared memory named "yaps_frames.<pid>". 
+// The simulator writes each output frame into the next slot of the 
+// ring and never waits for the readers. A reader copies the newest 
+// frame - each slot is guarded by a sequence number which is odd 
+// while the slot is being written, so the copy is retried if the 
+// slot has been overwritten meanwhile. Slow readers skip frames.
+class FrameRing
+{
+
+public:
+
+    // create the ring of this process (if LIVE_FRAMES is set)
+    static void create();
+    // write particles as frame 'nfile' after step 'step'
+    static void publish( int nfile, int step);
+    // mark the run finished and remove the ring
+    static void destroy();
+
+    // attach to the ring of process 'pid' (0 - the newest ring created 
+    // in the current directory), the function returns 0 if succeeded
+    static int attach( int pid);
+    static void detach();
+    // copy the newest frame if it's newer than frame 'last', the 
+    // function returns its sequential number or -1 if there is none
+    static long long readLatest( long long last, Particles &prts, 
+                                 int *nfile, int *step);
+    // the simulation has finished
+    static int isFinished();
+
+private:
+
+    // header of the ring and header of a slot
+    struct RingHeader;
+    struct SlotHeader;
+
+    // prefix of the names of the rings
+    static const char* namePrefix;
+    // the ring (created or attached) and its size
+    static RingHeader *ring;
+    static size_t ringSize;
+
+    // address of slot 'slot'
+    static SlotHeader* getSlot( long long slot);
+
+};
+
+#endif // YAPS_FRAMERING_H
\ No newline at end of file
@@ -0,0 +1,181 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "grid.h"
+#include "common.h"
+#include <cmath>
+using namespace std;
+
+// limit of cell coordinates, it keeps the coordinates of far 
+// away points and the ranges of cells around them in int
+static const double coordsLimit = (double)(1 << 29);
+
+// Constructor.
+CellGrid::CellGrid()
+{
+    origin[0] = origin[1] = origin[2] = 0.0f;
+    dims[0] = dims[1] = dims[2] = 1;
+    cellSize = 1.0f;
+    cellsNum = 0;
+} // CellGrid
+
+// Sort points 'pnts' into cells of the size 'cellSize', the grid 
+// covers the bounding box of the points. Coordinates of the next 
+// point are 'stride' floats away from the previous one. The points 
+// with non-finite coordinates are left out of the bounding box and 
+// put into the first cell as the points outside of the grid. The 
+// function returns the number of such points.
+int
+CellGrid::build( const float *pnts,    // array of points
+                 int stride,           // stride of the array
+                 int pntsNum,          // number of points
+                 float cellSize)       // size of a cell
+{
+    float upper[3];
+    double extent[3], num[3];
+    int nonFinite = 0;
+    int found = 0;
+    int i, d, c;
+
+    // bounding box of the points
+    for ( d = 0; d < 3; d++ )
+    {
+        origin[d] = 0.0f;
+        upper[d] = 0.0f;
+    }
+    for ( i = 0; i < pntsNum; i++ )
+    {
+        const float *pnt = pnts + (size_t)i * stride;
+        for ( d = 0; d < dimension; d++ )
+            if ( pnt[d] - pnt[d] != 0.0f )
+                break;
+        if ( d < dimension )
+        {
+            nonFinite++;
+            continue;
+        }
+        for ( d = 0; d < dimension; d++ )
+        {
+            if ( !found || pnt[d] < origin[d] )
+                origin[d] = pnt[d];
+            if ( !found || pnt[d] > upper[d] )
+                upper[d] = pnt[d];
+        }
+        found = 1;
+    }
+
+    // number of cells, it's limited to keep the grid small 
+    // even if some points have gone far away, the extents are 
+    // computed in double as they could overflow floats and ints
+    if ( !(cellSize > 0.0f) )
+        cellSize = 1.0f;
+    for ( d = 0; d < 3; d++ )
+        extent[d] = (d < dimension) ? (double)upper[d] - origin[d] : 0.0;
+    double size = cellSize;
+    for ( ;; )
+    {
+        for ( d = 0; d < 3; d++ )
+            num[d] = floor( extent[d] / size) + 1.0;
+        if ( num[0] * num[1] * num[2] <= 4.0 * pntsNum + 1024.0 )
+            break;
+        size *= 2.0;
+    }
+    this->cellSize = (float)size;
+    for ( d = 0; d < 3; d++ )
+        dims[d] = (int)num[d];
+    cellsNum = dims[0] * dims[1] * dims[2];
+
+    // count points in cells
+    vector<int> cells( pntsNum);
+    cellStart.assign( cellsNum + 1, 0);
+    for ( i = 0; i < pntsNum; i++ )
+    {
+        cells[i] = getCell( pnts + (size_t)i * stride);
+        if ( cells[i] < 0 )
+            cells[i] = 0;
+        cellStart[cells[i] + 1]++;
+    }
+    for ( c = 0; c < cellsNum; c++ )
+        cellStart[c + 1] += cellStart[c];
+
+    // sort indices of points by cells
+    vector<int> pos( cellStart.begin(), cellStart.end() - 1);
+    index.resize( pntsNum);
+    for ( i = 0; i < pntsNum; i++ )
+        index[pos[cells[i]]++] = i;
+
+    return nonFinite;
+} // build
+
+// Returns the cell containing point 'pnt', -1 
+// if the point is outside of the grid.
+int
+CellGrid::getCell( const float *pnt) const   // point
+{
+    int coords[3];
+
+    getCellCoords( pnt, coords);
+
+    return getCell( coords[0], coords[1], coords[2]);
+} // getCell
+
+// Returns the cell with coordinates 'ix', 'iy', 'iz' 
+// in the grid, -1 if it's outside of the grid.
+int
+CellGrid::getCell( int ix, int iy, int iz) const   // coordinates
+{
+    if ( ix < 0 || iy < 0 || iz < 0 ||
+         ix >= dims[0] || iy >= dims[1] || iz >= dims[2] )
+        return -1;
+
+    return (iz * dims[1] + iy) * dims[0] + ix;
+} // getCell
+
+// Returns coordinates 'coords' in the grid of the cell containing 
+// point 'pnt' (they could be outside of the grid). They are computed 
+// in double as the size of the grid, the coordinates of far away and 
+// non-finite points are clamped to the limit.
+void
+CellGrid::getCellCoords( const float *pnt,     // point
+                         int *coords) const    // coordinates
+{
+    for ( int d = 0; d < 3; d++ )
+    {
+        coords[d] = 0;
+        if ( d >= dimension )
+            continue;
+        double coord = floor( ((double)pnt[d] - origin[d]) / cellSize);
+        if ( !(coord > -coordsLimit) )
+            coords[d] = -(int)coordsLimit;
+        else if ( coord > coordsLimit )
+            coords[d] = (int)coordsLimit;
+        else
+            coords[d] = (int)coord;
+    }
+
+    return;
+} // getCellCoords
+
+// Returns bounds 'lower' and 'upper' of the cell 'cell'.
+void
+CellGrid::getCellBounds( int cell,             // cell
+                         float *lower,         // lower bound
+                         float *upper) const   // upper bound
+{
+    int coords[3];
+
+    coords[0] = cell % dims[0];
+    coords[1] = (cell / dims[0]) % dims[1];
+    coords[2] = cell / (dims[0] * dims[1]);
+    for ( int d = 0; d < 3; d++ )
+    {
+        lower[d] = origin[d] + coords[d] * cellSize;
+        upper[d] = lower[d] + cellSize;
+        if ( d >= dimension )
+            lower[d] = upper[d] = 0.0f;
+    }
+
+    return;
+} // getCellBounds
@@ -0,0 +1,48 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_GRID_H
+#define YAPS_GRID_H
+
+#include "common.h"
+
+// Uniform grid of cells over a set of points - indices 
+// of the points are sorted by cells (counting sort).
+class CellGrid
+{
+
+public:
+
+    // constructor
+    CellGrid();
+    // sort points into cells of the size 'cellSize', 
+    // returns the number of points with non-finite coordinates
+    int  build( const float *pnts, int stride, int pntsNum, 
+                float cellSize);
+
+    // cell containing point, -1 if it's outside of the grid
+    int  getCell( const float *pnt) const;
+    // cell by its coordinates in the grid
+    int  getCell( int ix, int iy, int iz) const;
+    // coordinates of the cell containing point
+    void getCellCoords( const float *pnt, int *coords) const;
+    // bounds of cell
+    void getCellBounds( int cell, float *lower, float *upper) const;
+
+    // origin of the grid
+    float origin[3];
+    // size of a cell
+    float cellSize;
+    // number of cells along each axis
+    int dims[3];
+    // total number of cells
+    int cellsNum;
+    // points of the cell 'c' are index[cellStart[c]...cellStart[c+1]-1]
+    vector<int> cellStart;
+    vector<int> index;
+
+};
+
+#endif // YAPS_GRID_H
@@ -0,0 +1,95 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "interp.h"
+#include "common.h"
+using namespace std;
+
+// Returns time between output files 'nfile' and 'nfile+1'. The initial 
+// state is written before the first step, then the files are written 
+// after steps 0, OUT_FREQ, 2*OUT_FREQ, ... (see Calc::run).
+float
+Interp::getInterval( int nfile)   // number of the file
+{
+    int steps = (nfile == 0) ? 1 : parameters.outFreq;
+
+    return steps * parameters.timeStep;
+} // getInterval
+
+// Build in-between frame 'res' of frames 'prts1' and 'prts2' at the 
+// fraction 's' (0...1) of the interval between them. Particles are 
+// matched by their identifiers. Positions are interpolated by cubic 
+// Hermite splines using velocities (or linearly), the other values are 
+// interpolated linearly. Particles which are absent in 'prts2' are 
+// kept as is. The function returns 1 if no particles are matched.
+int
+Interp::interpolate( const Particles &prts1,   // first frame
+                     const Particles &prts2,   // second frame
+                     float s,                  // fraction of interval
+                     float interval,           // time between frames
+                     char hermite,             // use Hermite splines
+                     Particles &res)           // in-between frame
+{
+    int n = (int)prts1.size();
+    int matched = 0;
+    int i, j, d;
+
+    // usually particles are stored in the same order, 
+    // otherwise find them by their identifiers
+    vector<int> lookup;
+    char sameOrder = (prts1.size() == prts2.size());
+    for ( i = 0; sameOrder && i < n; i++ )
+        sameOrder = (prts1[i].id == prts2[i].id);
+    if ( !sameOrder )
+    {
+        int maxId = -1;
+        for ( j = 0; j < (int)prts2.size(); j++ )
+            if ( prts2[j].id > maxId )
+                maxId = prts2[j].id;
+        lookup.assign( maxId + 1, -1);
+        for ( j = 0; j < (int)prts2.size(); j++ )
+            if ( prts2[j].id >= 0 )
+                lookup[prts2[j].id] = j;
+    }
+
+    // Hermite basis functions
+    float h00 = (2.0f * s - 3.0f) * s * s + 1.0f;
+    float h10 = ((s - 2.0f) * s + 1.0f) * s * interval;
+    float h01 = (3.0f - 2.0f * s) * s * s;
+    float h11 = (s - 1.0f) * s * s * interval;
+
+    res = prts1;
+#pragma omp parallel for reduction(+:matched) private(j,d)
+    for ( i = 0; i < n; i++ )
+    {
+        const Particle &prt1 = prts1[i];
+        Particle &prt = res[i];
+
+        if ( sameOrder )
+            j = i;
+        else if ( prt1.id >= 0 && prt1.id < (int)lookup.size() )
+            j = lookup[prt1.id];
+        else
+            j = -1;
+        if ( j < 0 )
+            continue;
+        const Particle &prt2 = prts2[j];
+        matched++;
+
+        for ( d = 0; d < 3; d++ )
+        {
+            if ( hermite )
+                prt.pos[d] = h00 * prt1.pos[d] + h10 * prt1.vel[d] + 
+                             h01 * prt2.pos[d] + h11 * prt2.vel[d];
+            else
+                prt.pos[d] = prt1.pos[d] + s * (prt2.pos[d] - prt1.pos[d]);
+            prt.vel[d] = prt1.vel[d] + s * (prt2.vel[d] - prt1.vel[d]);
+        }
+        prt.dens  = prt1.dens  + s * (prt2.dens  - prt1.dens);
+        prt.press = prt1.press + s * (prt2.press - prt1.press);
+    }
+
+    return (n > 0 && matched == 0) ? 1 : 0;
+} // interpolate
\ No newline at end of file
@@ -0,0 +1,27 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_INTERP_H
+#define YAPS_INTERP_H
+
+#include "common.h"
+
+// Interpolation between output files
+class Interp
+{
+
+public:
+
+    // time between output files 'nfile' and 'nfile+1'
+    static float getInterval( int nfile);
+    // build in-between frame of frames 'prts1' and 'prts2'
+    static int   interpolate( const Particles &prts1, 
+                              const Particles &prts2, 
+                              float s, float interval, char hermite, 
+                              Particles &res);
+
+};
+
+#endif // YAPS_INTERP_H
\ No newline at end of file
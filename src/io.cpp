@@ -1,736 +1,1001 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#include "io.h"
-#include "common.h"
-#include "vec.h"
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-#include <cctype>
-#include <cmath>
-using namespace std;
-
-// name of the input file
-const char* IO::inputFileName       = "input";
-// maximum length of the file's string (with line feed)
-const int   IO::fileLineLength      = 1024;
-// maximum length of a section's name
-const int   IO::sectionNameLength   = 16;
-// keyword to end a section
-const char* IO::sectionEnd          = "$END";
-// maximum length of a parameter-string
-const int   IO::stringParamLength   = 16;
-// maximum length of a parameter's name
-const int   IO::paramNameLength     = 16;
-
-// read everythig by default
-char IO::doReadParticles  = 1;
-char IO::doReadBParticles = 1;
-char IO::doReadObstacles  = 1;
-
-// Section info
-struct IO::Section
-{
-    const char *name;               // name in the input file
-    int firstLine;                  // first line of the section
-    int endLine;                    // end line of the section
-    int (*func)( char **input, 
-                 Section *info);    // function to read the section
-};
-
-// Read the description file and initialize
-// all objects used in simulation and rendering.
-void
-IO::readInput()
-{
-    FILE *file;
-    char **input;
-    char str[fileLineLength + 1];
-    char name[sectionNameLength + 1];
-    char fmt[6];
-    int linesNum;
-    char searchEnd;
-    int i, j, n;
-
-    // open the input file
-    file = fopen( inputFileName, "r");
-    if ( file == NULL )
-        return;
-
-    // read the input file
-    linesNum = 0;
-    input = NULL;
-    while ( feof( file) == 0 )
-    {
-        // read next string
-        fgets( str, fileLineLength, file);
-        n = (int)strlen( str);
-
-        // empty strings or strings with comments 
-        // aren't stored (comments begin with '#')
-        for ( i = 0; i < n; i++ )
-        {
-            if ( isgraph( str[i]) )
-                break;
-        }
-        if ( i == n || str[i] == '#' )
-            continue;
-            
-        // allocate memory and store the string
-        i = linesNum++;
-        input = (char **)realloc( input, linesNum * sizeof(char *));
-        input[i] = (char *)malloc( (n + 1) * sizeof(char));
-        strcpy( input[i], str);
-    }
-
-    // possible sections in the scene description file, 
-    // they are processed in the order they follow here
-    Section sections[] =
-    {
-        // parameters section - contains simulator's parameters
-        "$PARAMS",    -1, -1, readParamsSection,
-        // clouds section - set up clouds of particles
-        "$CLOUDS",    -1, -1, readCloudsSection,
-        // obstacles section - set up obstacles in the scene
-        "$OBSTACLES", -1, -1, readObstaclesSection,
-    };
-    // number of sections
-    int sectsNum = sizeof(sections) / sizeof(sections[0]);
-
-    // find sections in the input file
-    searchEnd = 0;
-    sprintf( fmt, "%%%ds", sectionNameLength);
-    for ( i = 0; i < linesNum; i++ )
-    {
-        // read next string
-        sscanf( input[i], fmt, name);
-
-        // section starts/ends with '$'
-        if ( name[0] != '$' )
-            continue;
-
-        if ( searchEnd )
-        {
-            // first line has been found already -
-            // it's necessary to find the section's end
-            if ( strcmp( sectionEnd, name) )
-                continue;
-            sections[j].endLine = i;
-            searchEnd = 0;
-            continue;
-        }
-        
-        for ( j = 0; j < sectsNum; j++ )
-        {
-            // some section has been found in the 
-            // input file - check if it is valid
-            if ( strcmp( sections[j].name, name) )
-                continue;
-            sections[j].firstLine = i + 1;
-            // now it's necessary to find the end
-            searchEnd = 1;
-            break;
-        }
-    }
-    
-    // read and process the sections of the input file
-    for ( i = 0; i < sectsNum; i++ )
-        sections[i].func( input, &sections[i]);
-
-    // close the file and free the memory
-    if ( file != NULL )
-    {
-        fclose( file);
-        for ( i = 0; i < linesNum; i++ )
-            free( input[i]);
-        free( input);
-    }
-
-    return;
-} // readInput
-
-// Read obstacles section which is specified by 'info' from array with 
-// input data 'input', initialize corresponding data structures
-// and create boundary particles. The function returns 0 if succeeded 
-// and the number of string containing an error otherwise.
-//
-int
-IO::readObstaclesSection( char **input,     // array with input data
-                          Section *info)    // section's info
-{
-    if (doReadObstacles == 0 && doReadBParticles == 0)
-        return 0;
-
-    Obstacle obstacle;
-    float **pnts;
-    int pntsNum;
-    int res;
-    int i, n;
-    
-    pnts = NULL;
-    pntsNum = 0;
-    res = 0;
-
-    // obstacle's specification occupies one string
-    int obstaclesNumber = info->endLine - info->firstLine;
-
-    if ( dimension == 2 )
-    {
-        float vec[2];
-        
-        for ( i = 0; i < obstaclesNumber; i++ )
-        {
-            // in 2D simulation segment-obstacles are used
-            memset( &obstacle, 0, sizeof(struct Obstacle));
-            n = sscanf( input[info->firstLine + i], "%d %f %f %f %f", 
-                        &(obstacle.no),
-                        &(obstacle.vrtx1[0]), &(obstacle.vrtx1[1]), 
-                        &(obstacle.vrtx2[0]), &(obstacle.vrtx2[1]));
-            // error has occured
-            if ( n != 5 )
-                break;
-            // store
-            obstacles.push_back( obstacle);
-            // fill segment with points
-            vectorSubstraction( vec, obstacle.vrtx2, obstacle.vrtx1);
-            fillSegmentWithPoints( obstacle.vrtx1, vec, &pnts, 
-                                   &pntsNum, parameters.bparticlesDistrib);
-        }
-    }
-    else if ( dimension == 3 )
-    {
-        for ( i = 0; i < obstaclesNumber; i++ )
-        {
-            // in 3D simulation triangle-obstacles are used
-            memset( &obstacle, 0, sizeof(struct Obstacle));
-            n = sscanf( input[info->firstLine + i], 
-                        "%d %f %f %f %f %f %f %f %f %f", &(obstacle.no),
-                        &(obstacle.vrtx1[0]), &(obstacle.vrtx1[1]), 
-                        &(obstacle.vrtx1[2]), &(obstacle.vrtx2[0]), 
-                        &(obstacle.vrtx2[1]), &(obstacle.vrtx2[2]), 
-                        &(obstacle.vrtx3[0]), &(obstacle.vrtx3[1]), 
-                        &(obstacle.vrtx3[2]));
-            // error has occured
-            if ( n != 10 )
-                break;
-            // store
-            obstacles.push_back( obstacle);
-            // fill triangle with points
-            fillTriangleWithPoints( obstacle.vrtx1, obstacle.vrtx2, 
-                                    obstacle.vrtx3, &pnts, &pntsNum, 
-                                    parameters.bparticlesDistrib);
-        }
-    }
-
-    if ( i != obstaclesNumber )
-    {
-        // error has occured
-        res = i;
-    }
-    else if (doReadBParticles)
-    {
-        // create boundary particles using coordinates of 
-        // points which the obstacles have been filled with
-        BParticle bparticle;
-        unifyPoints( 0, &pnts, &pntsNum);
-        for ( i = 0; i < pntsNum; i++ )
-        {
-            memset( &bparticle, 0, sizeof(struct BParticle));
-            // boundary particle's position
-            memcpy( bparticle.pos, pnts[i], dimension * sizeof(float));
-            // store
-            bparticles.push_back( bparticle);
-        }
-    }
-
-    // delete points
-    for ( i = 0; i < pntsNum; i++ )
-        free( pnts[i]);
-    free( pnts);
-
-    // clear obstacles
-    if (doReadObstacles == 0)
-        obstacles.clear();
-
-    return res;
-} // readObstaclesSection
-
-// Read clouds section which is specified by 'info' from array with 
-// input data 'input', initialize corresponding data structures
-// and create smoothing particles. The function returns 0 if succeeded 
-// and the number of string containing an error otherwise.
-int
-IO::readCloudsSection( char **input,    // array with input data
-                       Section *info)   // section's info
-{
-    if (doReadParticles == 0)
-        return 0;
-
-    Particle particle;
-    float **pnts;
-    int pntsNum;
-    int res;
-    int i, j, n, no;
-    
-    pnts = NULL;
-    pntsNum = 0;
-    res = 0;
-    
-    if ( dimension == 2 )
-    {
-        float vrtx1[2], vrtx2[2], vrtx3[2];
-        float dens0, vel[2];
-        
-        for ( i = info->firstLine; i < info->endLine; i++ )
-        {
-            // in 2D simulation cloud of particle 
-            // has the form of a parallelogram
-            n = sscanf( input[i], "%d %f  %f %f  %f %f  %f %f  %f %f", 
-                                   &no, &dens0,
-                                   &vrtx1[0], &vrtx1[1], 
-                                   &vrtx2[0], &vrtx2[1], 
-                                   &vrtx3[0], &vrtx3[1], 
-                                   &vel[0], &vel[1]);
-            // error has occured
-            if ( n != 10 )
-                break;
-            // fill parallelogram with points
-            n = pntsNum;
-            fillParlgramWithPoints( vrtx1, vrtx2, vrtx3, &pnts, 
-                                    &pntsNum, parameters.particlesDistrib);
-            unifyPoints( n, &pnts, &pntsNum);
-            // create new particles using coordinates of points 
-            // which the parallelogram has been filled with
-            for ( j = n; j < pntsNum; j++ )
-            {
-                memset( &particle, 0, sizeof(struct Particle));
-                // material number
-                particle.no = no;
-                // position
-                memcpy( particle.pos, pnts[j], dimension * sizeof(float));
-                // velocity
-                memcpy( particle.vel, vel, dimension * sizeof(float));
-                memcpy( particle.ivalVel, vel, dimension * sizeof(float));
-                // density
-                particle.dens = dens0;
-                particle.dens0 = dens0;
-                particle.ivalDens = dens0;
-                // mass
-                particle.mass = pow( parameters.particlesDistrib, 3) * dens0;
-                // store
-                particles.push_back( particle);
-            }
-        }
-    }
-    else if ( dimension == 3 )
-    {
-        float vrtx1[3], vrtx2[3], vrtx3[3], vrtx4[3];
-        float dens0, vel[3];
-        
-        for ( i = info->firstLine; i < info->endLine; i++ )
-        {
-            // in 3D simulation cloud of particle 
-            // has the form of a parallelepiped
-            n = sscanf( input[i], "%d %f  %f %f %f  %f %f %f \
-                                   %f %f %f  %f %f %f  %f %f %f", 
-                                   &no, &dens0,
-                                   &vrtx1[0], &vrtx1[1], &vrtx1[2], 
-                                   &vrtx2[0], &vrtx2[1], &vrtx2[2], 
-                                   &vrtx3[0], &vrtx3[1], &vrtx3[2], 
-                                   &vrtx4[0], &vrtx4[1], &vrtx4[2], 
-                                   &vel[0], &vel[1], &vel[2]);
-            // error has occured
-            if ( n != 17 )
-                break;
-            // fill parallelepiped with points
-            n = pntsNum;
-            fillParlpipedWithPoints( vrtx1, vrtx2, vrtx3, vrtx4, &pnts, 
-                                     &pntsNum, parameters.particlesDistrib);
-            unifyPoints( n, &pnts, &pntsNum);
-            // create new particles using coordinates of points 
-            // which the parallelepiped has been filled with
-            for ( j = n; j < pntsNum; j++ )
-            {
-                memset( &particle, 0, sizeof(struct Particle));
-                // material number
-                particle.no = no;
-                // position
-                memcpy( particle.pos, pnts[j], dimension * sizeof(float));
-                // velocity
-                memcpy( particle.vel, vel, dimension * sizeof(float));
-                memcpy( particle.ivalVel, vel, dimension * sizeof(float));
-                // density
-                particle.dens = dens0;
-                particle.dens0 = dens0;
-                particle.ivalDens = dens0;
-                // mass
-                particle.mass = pow( parameters.particlesDistrib, 3) * dens0;
-                // store
-                particles.push_back( particle);
-            }
-        }
-    }
-
-    // error has occured
-    if ( i != info->endLine )
-        res = i;
-
-    // delete points
-    for ( i = 0; i < pntsNum; i++ )
-        free( pnts[i]);
-    free( pnts);
-
-    return res;
-} // readCloudsSection
-
-// Read parameters section which is specified by 'info' from array with 
-// input data 'input', and initialize corresponding variables and 
-// data structures. The function returns 0 if succeeded and the number 
-// of string containing an error otherwise.
-int
-IO::readParamsSection( char **input,    // array with input data
-                       Section *info)   // section's info
-{
-    char name[paramNameLength + 1];
-    char fmt[10];
-    int i, j, n;
-    int res = 0;
-
-    // parameter's info
-    struct Param
-    {
-        const char *name; // name of the parameter
-        int  type;        // type of the parameter
-        void *var;        // pointer to a var the parameter's value to store in
-    };
-
-    // possible types of parameters
-    enum { INT_PARAM, FLOAT_PARAM, STRING_PARAM };
-
-    // possible parameters in the parameters section
-    Param params[] =
-    {
-        // dimension of the simulation
-        "DIM",          INT_PARAM,    (void *)(&dimension),
-        // initial particle distribution
-        "PRTS_DISTR",   FLOAT_PARAM,  (void *)(&parameters.particlesDistrib),
-        // initial boundary particle distribution
-        "BPRTS_DISTR",  FLOAT_PARAM,  (void *)(&parameters.bparticlesDistrib),
-        // speed of sound
-        "SOS",          FLOAT_PARAM,  (void *)(&parameters.sos),
-        // kernel to use in the calculations
-        "KERNEL",       STRING_PARAM, (void *)(parameters.kernelType),
-        // kernel's smoothing length
-        "SMOOTH_LEN",   FLOAT_PARAM,  (void *)(&parameters.smoothR),
-        // equation of state to calculate pressures
-        "EOS",          STRING_PARAM, (void *)(parameters.eosType),
-        // alpha factor to calculate viscosity
-        "VISC_ALPHA",   FLOAT_PARAM,  (void *)(&parameters.viscAlpha),
-        // beta factor to calculate viscosity
-        "VISC_BETA",    FLOAT_PARAM,  (void *)(&parameters.viscBeta),
-        // time step of integration
-        "TIME_STEP",    FLOAT_PARAM,  (void *)(&parameters.timeStep),
-        // number of steps to perform
-        "NSTEPS",       INT_PARAM,    (void *)(&parameters.nsteps),
-        // output frequence
-        "OUT_FREQ",     INT_PARAM,    (void *)(&parameters.outFreq),
-        // clipping volume (the area to render)
-        "CLIP_VOL",     FLOAT_PARAM,  (void *)(&parameters.clipVolume),
-        // radius to draw particles
-        "PRADIUS",      FLOAT_PARAM,  (void *)(&parameters.particlesRadius),
-    };
-
-    // number of parameters
-    int paramsNum = sizeof(params) / sizeof(params[0]);
-
-    // read parameters from the parameters section
-    for ( i = info->firstLine; i < info->endLine; i++ )
-    {
-        sprintf( fmt, "%%%ds %%n", paramNameLength);
-        sscanf( input[i], fmt, name, &n);
-
-        for ( j = 0; j < paramsNum; j++ )
-        {
-            if ( strcmp( params[j].name, name) )
-                continue;
-
-            // some parameter has been found - read and store its value
-            if ( params[j].type == INT_PARAM )
-            {
-                // type of the parameter is integer
-                sscanf( input[i] + n, "%d", (int *)params[j].var);
-                break;
-            }
-            else if ( params[j].type == FLOAT_PARAM )
-            {
-                // type of the parameter is float
-                sscanf( input[i] + n, "%f", (float *)params[j].var);
-                break;
-            }
-            else if ( params[j].type == STRING_PARAM )
-            {
-                // type of the parameter is string (char *)
-                sprintf( fmt, "%%%ds", stringParamLength);
-                sscanf( input[i] + n, fmt, (char *)params[j].var);
-                break;
-            }
-        }
-        
-        if ( j == paramsNum )
-        {
-            // parameter isn't valid
-            res = i;
-            break;
-        }
-    }
-
-    return res;
-} // readParamsSection
-
-// Unification of array of points - the function searches for identical 
-// points in the array 'pnts' of the size 'pntsNum', eliminates all of 
-// them but one, and shift the array. New size of the array is returned 
-// through 'pntsNum'. The size of the part of the array which is already 
-// unified is set through 'unifiedPart'.
-void
-IO::unifyPoints( int unifiedPart, // unified part of the array
-                 float ***pnts,   // array of points
-                 int *pntsNum)    // size of the array
-{
-    float **p;
-    int i, j, k;
-    int n;
-
-    // array of points
-    p = *pnts;
-    // current size of the array
-    n = *pntsNum;
-    
-    // unify the array
-    for ( i = 0; i < n - 1; i++ )
-    {
-        // search from current position for point which is identical to p[i]
-        for ( j = ((unifiedPart > i) ? unifiedPart : i) + 1; j < n; j++ )
-        {
-            // is point identical to p[i]?
-            if ( memcmp( p[i], p[j], dimension * sizeof(float)) )
-                continue;
-            // eliminate p[j]
-            free (p[j]);
-            n--;
-            // search from the end of the array for point to replace p[j]
-            for ( k = n; k > j; k-- )
-            {
-                // is point identical to p[j]?
-                if ( memcmp( p[i], p[k], dimension * sizeof(float)) )
-                {
-                    // replace
-                    p[j] = p[k];
-                    p[k] = NULL;
-                    break;
-                }
-                // eliminate p[k]
-                free (p[k]);
-                n--;
-            }
-        }
-    }
-    
-    // new size of the array
-    *pntsNum = n;
-    // reallocate the array
-    p = (float **)realloc( p, n * sizeof(float *));
-    *pnts = p;
-
-    return;
-} // unifyPoints
-
-// The function fills triangle given by 'vrtx1', 'vrtx2' and 'vrtx3' with 
-// points, the interval between points is set by 'ival'. At the moment of 
-// function invocation, the array 'pnts' could already contain some points 
-// and in this case 'pntsNum' has to contain its current size; if the 
-// array is empty, 'pnts' has to be set to NULL, and 'pntsNum' has to be 
-// set to 0. New points are stored in the end of reallocated array 'pnts', 
-// new size of the array is returned through 'pntsNum'.
-void
-IO::fillTriangleWithPoints( float *vrtx1,   // vertex 1
-                            float *vrtx2,   // vertex 2
-                            float *vrtx3,   // vertex 3
-                            float ***pnts,  // array of points
-                            int *pntsNum,   // size of the array
-                            float ival)     // interval between points
-{
-    float vec[3], vec1[3], vec2[3];
-    float pnt1[3], pnt2[3];
-    float offset;
-    float param;
-    float r;
-    int i, j;
-    
-    // reference vectors
-    vectorSubstraction( vec1, vrtx2, vrtx1);
-    vectorSubstraction( vec2, vrtx3, vrtx1);
-    // length of the triangle's side
-    r = vectorNorm( vec1);
-    // number of points the triangle's side can be filled with
-    j = (int)(r / ival);
-    // fill triangle with points
-    offset = (r - (float)(j - 1) * ival) / 2;
-    for ( i = 0; i < j; i++ )
-    {
-        // get point1 on one triangle's side and point2 on another
-        param = r ? ((ival * (float)i + offset) / r) : 0;
-        getPointOnSegmentByParam( vrtx1, vec1, pnt1, param);
-        getPointOnSegmentByParam( vrtx1, vec2, pnt2, param);
-        // fill the resulting segment with points
-        vectorSubstraction( vec, pnt2, pnt1);
-        fillSegmentWithPoints( pnt1, vec, pnts, pntsNum, ival);
-    }
-    
-    return;
-} /* fillTriangleWithPoints */
-
-// The function fills parallelepiped given by origin 'vrtx' and reference 
-// vectors 'vec1', 'vec2' and 'vec3' with with points, the interval between 
-// points is set by 'ival'. At the moment of function invocation, the array 
-// 'pnts' could already contain some points and in this case 'pntsNum' has 
-// to contain its current size; if the array is empty, 'pnts' has to be 
-// set to NULL, and 'pntsNum' has to be set to 0. New points are stored in 
-// the end of reallocated array 'pnts', new size of the array is returned 
-// through 'pntsNum'.
-void
-IO::fillParlpipedWithPoints( float *vrtx,    // origin
-                             float *vec1,    // vector 1
-                             float *vec2,    // vector 2
-                             float *vec3,    // vector 3
-                             float ***pnts,  // array of points
-                             int *pntsNum,   // size of the array
-                             float ival)     // interval between points
-{
-    float pnt[3];
-    float param;
-    float offset;
-    float r;
-    int i, j;
-    
-    // length of the parallelepiped's edge
-    r = vectorNorm( vec1);
-    // number of points the parallelepiped's edge can be filled with
-    j = (int)(r / ival);
-    // fill parallelepiped with points
-    offset = (r - (float)(j - 1) * ival) / 2;
-    for ( i = 0; i < j; i++ )
-    {
-        // get point on the parallelepiped's edge
-        param = r ? ((ival * (float)i + offset) / r) : 0;
-        getPointOnSegmentByParam( vrtx, vec1, pnt, param);
-        // fill the parallelogram with points
-        fillParlgramWithPoints( pnt, vec2, vec3, pnts, pntsNum, ival);
-    }
-    
-    return;
-} // fillParlpipedWithPoints
-
-// The function fills parallelogram given by origin 'vrtx' and reference 
-// vectors 'vec1' and 'vec2' with points, the interval between points is 
-// set by 'ival'. At the moment of function invocation, the array 'pnts' 
-// could already contain some points and in this case 'pntsNum' has to 
-// contain its current size; if the array is empty, 'pnts' has to be set 
-// to NULL, and 'pntsNum' has to be set to 0. New points are stored in the 
-// end of reallocated array 'pnts', new size of the array is returned 
-// through 'pntsNum'.
-void
-IO::fillParlgramWithPoints( float *vrtx,    // origin
-                            float *vec1,    // vector 1
-                            float *vec2,    // vector 2
-                            float ***pnts,  // array of points
-                            int *pntsNum,   // size of the array
-                            float ival)     // interval between points
-{
-    float pnt[3];
-    float param;
-    float offset;
-    float r;
-    int i, j;
-    
-    // length of the parallelogram's side
-    r = vectorNorm( vec1);
-    // number of points the parallelogram's side can be filled with
-    j = (int)(r / ival);
-    // fill parallelogram with points
-    offset = (r - (float)(j - 1) * ival) / 2;
-    for ( i = 0; i < j; i++ )
-    {
-        // get point on the parallelogram's side
-        param = r ? ((ival * (float)i + offset) / r) : 0;
-        getPointOnSegmentByParam( vrtx, vec1, pnt, param);
-        // fill the segment with points
-        fillSegmentWithPoints( pnt, vec2, pnts, pntsNum, ival);
-    }
-    
-    return;
-} // fillParlgramWithPoints
-
-// The function fills segment given by origin 'vrtx' and reference 
-// vector 'vec' with points, the interval between points is set by 
-// 'ival'. At the moment of function invocation, the array 'pnts' 
-// could already contain some points and in this case 'pntsNum' has 
-// to contain its current size; if the array is empty, 'pnts' has 
-// to be set to NULL, and 'pntsNum' has to be set to 0. New points 
-// are stored in the end of reallocated array 'pnts', new size of 
-// the array is returned through 'pntsNum'. 
-void
-IO::fillSegmentWithPoints( float *vrtx,    // origin
-                           float *vec,     // vector
-                           float ***pnts,  // array of points
-                           int *pntsNum,   // size of the array
-                           float ival)     // interval between points
-{
-    float param;
-    float offset;
-    float r;
-    int i, j, n;
-    
-    // length of the segment
-    r = vectorNorm( vec);
-    // current size of the array
-    n = *pntsNum;
-    // number of points the segment can be filled with
-    j = (int)(r / ival);
-    // new size of the array
-    *pntsNum += j;
-    // reallocate the array
-    *pnts = (float **)realloc( *pnts, *pntsNum * sizeof(float *));
-    // fill segment with points
-    offset = (r - (float)(j - 1) * ival) / 2;
-    for ( i = 0; i < j; i++ )
-    {
-        // allocate memory for new point
-        (*pnts)[i + n] = (float *)malloc( dimension * sizeof(float));
-        // get next point on the segment by parameter and store it
-        param = r ? ((ival * (float)i + offset) / r): 0;
-        getPointOnSegmentByParam( vrtx, vec, (*pnts)[i + n], param);
-    }
-
-    return;
-} // fillSegmentWithPoints
-
-// Returns point 'pnt' belonging to a segment specified by 
-// origin 'vrtx' and reference vector 'vec', the offset of 
-// point from 'vrtx' is determined by 'param' (should be [0..1]).
-void
-IO::getPointOnSegmentByParam( float *vrtx,    // origin
-                              float *vec,     // vector
-                              float *pnt,     // point
-                              float param)    // parameter
-{
-    int d;
-    
-    for ( d = 0; d < dimension; d++ )
-        pnt[d] = param * vec[d] + vrtx[d];
-
-    return;
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "io.h"
+#include "iobin.h"
+#include "common.h"
+#include "vec.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <sys/stat.h>
+#include <omp.h>
+using namespace std;
+
+// name of the input file
+const char* IO::inputFileName       = "input";
+// maximum length of the file's string (with line feed)
+const int   IO::fileLineLength      = 1024;
+// maximum length of a section's name
+const int   IO::sectionNameLength   = 16;
+// keyword to end a section
+const char* IO::sectionEnd          = "$END";
+// maximum length of a parameter-string
+const int   IO::stringParamLength   = 16;
+// maximum length of a parameter's name
+const int   IO::paramNameLength     = 16;
+// version of the generator of boundary particles
+const int   IO::generatorVersion    = 2;
+
+// read everythig by default
+char IO::doReadParticles  = 1;
+char IO::doReadBParticles = 1;
+char IO::doReadObstacles  = 1;
+
+// Section info
+struct IO::Section
+{
+    const char *name;               // name in the input file
+    int firstLine;                  // first line of the section
+    int endLine;                    // end line of the section
+    int (*func)( char **input, 
+                 Section *info);    // function to read the section
+};
+
+// Read the description file and initialize all objects used in 
+// simulation and rendering. The function returns 0 if succeeded 
+// and -1 if the file can't be opened.
+int
+IO::readInput( const char *fileName)    // name of the input file
+{
+    FILE *file;
+    char **input;
+    char str[fileLineLength + 1];
+    char name[sectionNameLength + 1];
+    char fmt[6];
+    int linesNum;
+    int linesMax;
+    char searchEnd;
+    int i, j, n;
+
+    // open the input file
+    if ( fileName == NULL )
+        fileName = inputFileName;
+    file = fopen( fileName, "r");
+    if ( file == NULL )
+        return -1;
+
+    // read the input file
+    linesNum = 0;
+    linesMax = 0;
+    input = NULL;
+    while ( fgets( str, fileLineLength, file) != NULL )
+    {
+        // length of the string
+        n = (int)strlen( str);
+
+        // empty strings or strings with comments 
+        // aren't stored (comments begin with '#')
+        for ( i = 0; i < n; i++ )
+        {
+            if ( isgraph( str[i]) )
+                break;
+        }
+        if ( i == n || str[i] == '#' )
+            continue;
+            
+        // allocate memory and store the string
+        i = linesNum++;
+        if ( linesNum > linesMax )
+        {
+            linesMax = (linesMax > 0) ? 2 * linesMax : 256;
+            input = (char **)realloc( input, linesMax * sizeof(char *));
+        }
+        input[i] = (char *)malloc( (n + 1) * sizeof(char));
+        strcpy( input[i], str);
+    }
+
+    // possible sections in the scene description file, 
+    // they are processed in the order they follow here
+    Section sections[] =
+    {
+        // parameters section - contains simulator's parameters
+        "$PARAMS",    -1, -1, readParamsSection,
+        // clouds section - set up clouds of particles
+        "$CLOUDS",    -1, -1, readCloudsSection,
+        // obstacles section - set up obstacles in the scene
+        "$OBSTACLES", -1, -1, readObstaclesSection,
+    };
+    // number of sections
+    int sectsNum = sizeof(sections) / sizeof(sections[0]);
+
+    // find sections in the input file
+    searchEnd = 0;
+    sprintf( fmt, "%%%ds", sectionNameLength);
+    for ( i = 0; i < linesNum; i++ )
+    {
+        // read next string
+        sscanf( input[i], fmt, name);
+
+        // section starts/ends with '$'
+        if ( name[0] != '$' )
+            continue;
+
+        if ( searchEnd )
+        {
+            // first line has been found already -
+            // it's necessary to find the section's end
+            if ( strcmp( sectionEnd, name) )
+                continue;
+            sections[j].endLine = i;
+            searchEnd = 0;
+            continue;
+        }
+        
+        for ( j = 0; j < sectsNum; j++ )
+        {
+            // some section has been found in the 
+            // input file - check if it is valid
+            if ( strcmp( sections[j].name, name) )
+                continue;
+            sections[j].firstLine = i + 1;
+            // now it's necessary to find the end
+            searchEnd = 1;
+            break;
+        }
+    }
+    
+    // read and process the sections of the input file
+    for ( i = 0; i < sectsNum; i++ )
+        sections[i].func( input, &sections[i]);
+
+    // close the file and free the memory
+    if ( file != NULL )
+    {
+        fclose( file);
+        for ( i = 0; i < linesNum; i++ )
+            free( input[i]);
+        free( input);
+    }
+
+    return 0;
+} // readInput
+
+// Read obstacles section which is specified by 'info' from array with 
+// input data 'input', initialize corresponding data structures
+// and create boundary particles. The function returns 0 if succeeded 
+// and the number of string containing an error otherwise.
+// In 3D simulation triangles could be imported from binary STL file:
+//   <no> STL <file> [<scale> [<tx> <ty> <tz>]]
+// vertices of the triangles are scaled and then translated.
+int
+IO::readObstaclesSection( char **input,     // array with input data
+                          Section *info)    // section's info
+{
+    if (doReadObstacles == 0 && doReadBParticles == 0)
+        return 0;
+
+    Obstacle obstacle;
+    int res;
+    int i, n;
+    char genPoints;
+    
+    res = 0;
+
+    // obstacle's specification occupies one string
+    int obstaclesNumber = info->endLine - info->firstLine;
+
+    // boundary particles are taken from the cache if it has 
+    // been created for the same obstacles and parameters
+    unsigned long long key = hashSection( input, info);
+    genPoints = doReadBParticles;
+    if ( genPoints && IOBin().readBParticles( key) == 0 )
+    {
+        genPoints = 0;
+        if ( doReadObstacles == 0 )
+            return 0;
+    }
+
+    // obstacles are read first, boundary particles are created afterwards
+    int firstObstacle = (int)obstacles.size();
+    obstacles.reserve( firstObstacle + obstaclesNumber);
+
+    if ( dimension == 2 )
+    {
+        for ( i = 0; i < obstaclesNumber; i++ )
+        {
+            // in 2D simulation segment-obstacles are used
+            memset( &obstacle, 0, sizeof(struct Obstacle));
+            n = sscanf( input[info->firstLine + i], "%d %f %f %f %f", 
+                        &(obstacle.no),
+                        &(obstacle.vrtx1[0]), &(obstacle.vrtx1[1]), 
+                        &(obstacle.vrtx2[0]), &(obstacle.vrtx2[1]));
+            // error has occured
+            if ( n != 5 )
+                break;
+            // store
+            obstacles.push_back( obstacle);
+        }
+    }
+    else if ( dimension == 3 )
+    {
+        for ( i = 0; i < obstaclesNumber; i++ )
+        {
+            // triangles from STL file
+            n = readSTL( input[info->firstLine + i]);
+            if ( n == 0 )
+                continue;
+            else if ( n > 0 )
+                break;
+            // in 3D simulation triangle-obstacles are used
+            memset( &obstacle, 0, sizeof(struct Obstacle));
+            n = sscanf( input[info->firstLine + i], 
+                        "%d %f %f %f %f %f %f %f %f %f", &(obstacle.no),
+                        &(obstacle.vrtx1[0]), &(obstacle.vrtx1[1]), 
+                        &(obstacle.vrtx1[2]), &(obstacle.vrtx2[0]), 
+                        &(obstacle.vrtx2[1]), &(obstacle.vrtx2[2]), 
+                        &(obstacle.vrtx3[0]), &(obstacle.vrtx3[1]), 
+                        &(obstacle.vrtx3[2]));
+            // error has occured
+            if ( n != 10 )
+                break;
+            // store
+            obstacles.push_back( obstacle);
+        }
+    }
+
+    if ( i != obstaclesNumber )
+    {
+        // error has occured
+        res = i;
+    }
+    else if ( genPoints )
+    {
+        // create boundary particles using coordinates of 
+        // points which the obstacles are filled with
+        fillObstaclesWithPoints( firstObstacle);
+        // save them for the next start
+        IOBin().writeBParticles( key);
+    }
+
+    // clear obstacles
+    if (doReadObstacles == 0)
+        obstacles.clear();
+
+    return res;
+} // readObstaclesSection
+
+// Read triangle-obstacles from binary STL file referenced by the string 
+// 'str' of the obstacles section. The file is read by blocks of facets 
+// directly into obstacles. The function returns -1 if the string doesn't 
+// reference STL file, 0 if succeeded and 1 if an error has occured.
+int
+IO::readSTL( const char *str)   // string of the obstacles section
+{
+    char fname[fileLineLength + 1];
+    char keyword[stringParamLength + 1];
+    char fmt[20];
+    float scale = 1.0f;
+    float trans[3] = { 0.0f, 0.0f, 0.0f };
+    unsigned int facetsNum;
+    long fsize;
+    int no;
+    int i, n;
+
+    // <no> STL <file> [<scale> [<tx> <ty> <tz>]]
+    sprintf( fmt, "%%d %%%ds %%n", stringParamLength);
+    n = -1;
+    if ( sscanf( str, fmt, &no, keyword, &n) != 2 || n < 0 ||
+         strcmp( keyword, "STL") )
+        return -1;
+    sprintf( fmt, "%%%ds %%f %%f %%f %%f", fileLineLength);
+    if ( sscanf( str + n, fmt, fname, &scale, 
+                 &trans[0], &trans[1], &trans[2]) < 1 )
+        return 1;
+
+    // open the file
+    FILE *file = fopen( fname, "rb");
+    if ( file == NULL )
+    {
+        printf( "Can't open STL file %s\n", fname);
+        return 1;
+    }
+
+    // 80 bytes of header and the number of facets, 
+    // binary file consists of 50 bytes per facet
+    unsigned char header[84];
+    fseek( file, 0, SEEK_END);
+    fsize = ftell( file);
+    fseek( file, 0, SEEK_SET);
+    if ( fread( header, 1, 84, file) != 84 )
+    {
+        fclose( file);
+        return 1;
+    }
+    facetsNum = header[80] | (header[81] << 8) | 
+                (header[82] << 16) | ((unsigned int)header[83] << 24);
+    if ( fsize != 84 + 50 * (long)facetsNum )
+    {
+        printf( "%s isn't binary STL file\n", fname);
+        fclose( file);
+        return 1;
+    }
+
+    // read facets by blocks
+    const int blockSize = 4096;
+    vector<unsigned char> block( blockSize * 50);
+    Obstacle obstacle;
+    float *vrtx[3];
+    memset( &obstacle, 0, sizeof(struct Obstacle));
+    obstacle.no = no;
+    vrtx[0] = obstacle.vrtx1;
+    vrtx[1] = obstacle.vrtx2;
+    vrtx[2] = obstacle.vrtx3;
+    obstacles.reserve( obstacles.size() + facetsNum);
+    while ( facetsNum > 0 )
+    {
+        n = (facetsNum < (unsigned int)blockSize) ? 
+            (int)facetsNum : blockSize;
+        if ( fread( &block[0], 50, n, file) != (size_t)n )
+            break;
+        facetsNum -= n;
+        for ( i = 0; i < n; i++ )
+        {
+            // normal (skipped), 3 vertices and attribute (skipped)
+            const unsigned char *facet = &block[0] + 50 * i + 12;
+            for ( int v = 0; v < 3; v++ )
+            {
+                memcpy( vrtx[v], facet + 12 * v, 3 * sizeof(float));
+                for ( int d = 0; d < 3; d++ )
+                    vrtx[v][d] = vrtx[v][d] * scale + trans[d];
+            }
+            obstacles.push_back( obstacle);
+        }
+    }
+
+    // close the file
+    fclose( file);
+
+    return (facetsNum > 0) ? 1 : 0;
+} // readSTL
+
+// Create boundary particles for the obstacles starting from 
+// 'firstObstacle'. The number of points each obstacle is filled 
+// with is counted first, so the particles are stored in place 
+// and the obstacles are processed in parallel.
+void
+IO::fillObstaclesWithPoints( int firstObstacle)   // first obstacle
+{
+    float vec[3];
+    float ival = parameters.bparticlesDistrib;
+    int obstaclesNumber = (int)obstacles.size() - firstObstacle;
+    int i;
+
+    if ( obstaclesNumber <= 0 )
+        return;
+
+    // offsets of the obstacles' points in the array
+    vector<int> offsets( obstaclesNumber + 1, 0);
+    int n = (int)bparticles.size();
+
+    // count points
+#pragma omp parallel for private(vec)
+    for ( i = 0; i < obstaclesNumber; i++ )
+    {
+        Obstacle *obstacle = &obstacles[firstObstacle + i];
+        if ( dimension == 2 )
+        {
+            vectorSubstraction( vec, obstacle->vrtx2, obstacle->vrtx1);
+            offsets[i + 1] = fillSegmentWithPoints( obstacle->vrtx1, vec, 
+                                 NULL, 0, ival);
+        }
+        else
+        {
+            offsets[i + 1] = fillTriangleWithPoints( obstacle->vrtx1, 
+                                 obstacle->vrtx2, obstacle->vrtx3, 
+                                 NULL, 0, ival);
+        }
+    }
+    offsets[0] = n;
+    for ( i = 0; i < obstaclesNumber; i++ )
+        offsets[i + 1] += offsets[i];
+
+    // fill obstacles with points
+    BParticle bparticle;
+    memset( &bparticle, 0, sizeof(struct BParticle));
+    bparticles.resize( offsets[obstaclesNumber], bparticle);
+    int stride = sizeof(struct BParticle) / sizeof(float);
+#pragma omp parallel for schedule(dynamic) private(vec)
+    for ( i = 0; i < obstaclesNumber; i++ )
+    {
+        Obstacle *obstacle = &obstacles[firstObstacle + i];
+        float *pnts = bparticles[offsets[i]].pos;
+        if ( dimension == 2 )
+        {
+            vectorSubstraction( vec, obstacle->vrtx2, obstacle->vrtx1);
+            fillSegmentWithPoints( obstacle->vrtx1, vec, 
+                                   pnts, stride, ival);
+        }
+        else
+        {
+            fillTriangleWithPoints( obstacle->vrtx1, obstacle->vrtx2, 
+                                    obstacle->vrtx3, pnts, stride, ival);
+        }
+    }
+
+    // neighbouring obstacles share points
+    n = unifyPoints( n, (char *)&bparticles[0], sizeof(struct BParticle), 
+                     (int)offsetof(struct BParticle, pos), 
+                     (int)bparticles.size());
+    bparticles.resize( n);
+
+    return;
+} // fillObstaclesWithPoints
+
+// Returns hash value of the section which is specified by 'info' 
+// from array with input data 'input', the dimension of the simulation, 
+// the boundary particle distribution and the version of the generator 
+// are hashed too (FNV-1a).
+// Files referenced from the section are identified by their sizes 
+// and modification times.
+unsigned long long
+IO::hashSection( char **input,     // array with input data
+                 Section *info)    // section's info
+{
+    unsigned long long h = 14695981039346656037ull;
+    const unsigned char *p;
+    int i, k;
+
+    // parameters which boundary particles depend on
+    for ( k = 0; k < 3; k++ )
+    {
+        if ( k == 0 )
+            p = (const unsigned char *)&dimension;
+        else if ( k == 1 )
+            p = (const unsigned char *)&parameters.bparticlesDistrib;
+        else
+            p = (const unsigned char *)&generatorVersion;
+        for ( i = 0; i < 4; i++ )
+            h = (h ^ p[i]) * 1099511628211ull;
+    }
+
+    // lines of the section
+    for ( i = info->firstLine; i < info->endLine; i++ )
+    {
+        for ( p = (const unsigned char *)input[i]; *p; p++ )
+            h = (h ^ *p) * 1099511628211ull;
+
+        // STL files are identified by their sizes and modification times
+        char fname[fileLineLength + 1];
+        char fmt[20];
+        struct stat st;
+        sprintf( fmt, "%%*d STL %%%ds", fileLineLength);
+        if ( sscanf( input[i], fmt, fname) == 1 && 
+             stat( fname, &st) == 0 )
+        {
+            long long id[2] = { (long long)st.st_size, 
+                                (long long)st.st_mtime };
+            p = (const unsigned char *)id;
+            for ( k = 0; k < (int)sizeof(id); k++ )
+                h = (h ^ p[k]) * 1099511628211ull;
+        }
+    }
+
+    return h;
+} // hashSection
+
+// Read clouds section which is specified by 'info' from array with 
+// input data 'input', initialize corresponding data structures
+// and create smoothing particles. The function returns 0 if succeeded 
+// and the number of string containing an error otherwise.
+int
+IO::readCloudsSection( char **input,    // array with input data
+                       Section *info)   // section's info
+{
+    if (doReadParticles == 0)
+        return 0;
+
+    Particle particle;
+    float vrtx1[3], vrtx2[3], vrtx3[3], vrtx4[3];
+    float dens0, vel[3];
+    int res;
+    int i, j, k, n, no;
+    
+    res = 0;
+
+    // particles are stored in place, 
+    // so the stride is given in floats
+    int stride = sizeof(struct Particle) / sizeof(float);
+    float ival = parameters.particlesDistrib;
+    
+    for ( i = info->firstLine; i < info->endLine; i++ )
+    {
+        memset( vrtx1, 0, sizeof(vrtx1));
+        memset( vel, 0, sizeof(vel));
+
+        if ( dimension == 2 )
+        {
+            // in 2D simulation cloud of particle 
+            // has the form of a parallelogram
+            n = sscanf( input[i], "%d %f  %f %f  %f %f  %f %f  %f %f", 
+                                   &no, &dens0,
+                                   &vrtx1[0], &vrtx1[1], 
+                                   &vrtx2[0], &vrtx2[1], 
+                                   &vrtx3[0], &vrtx3[1], 
+                                   &vel[0], &vel[1]);
+            // error has occured
+            if ( n != 10 )
+                break;
+            // number of points
+            k = fillParlgramWithPoints( vrtx1, vrtx2, vrtx3, 
+                                        NULL, 0, ival);
+        }
+        else if ( dimension == 3 )
+        {
+            // in 3D simulation cloud of particle 
+            // has the form of a parallelepiped
+            n = sscanf( input[i], "%d %f  %f %f %f  %f %f %f \
+                                   %f %f %f  %f %f %f  %f %f %f", 
+                                   &no, &dens0,
+                                   &vrtx1[0], &vrtx1[1], &vrtx1[2], 
+                                   &vrtx2[0], &vrtx2[1], &vrtx2[2], 
+                                   &vrtx3[0], &vrtx3[1], &vrtx3[2], 
+                                   &vrtx4[0], &vrtx4[1], &vrtx4[2], 
+                                   &vel[0], &vel[1], &vel[2]);
+            // error has occured
+            if ( n != 17 )
+                break;
+            // number of points
+            k = fillParlpipedWithPoints( vrtx1, vrtx2, vrtx3, vrtx4, 
+                                         NULL, 0, ival);
+        }
+        else
+        {
+            break;
+        }
+
+        // new particles
+        memset( &particle, 0, sizeof(struct Particle));
+        // material number
+        particle.no = no;
+        // velocity
+        memcpy( particle.vel, vel, dimension * sizeof(float));
+        memcpy( particle.ivalVel, vel, dimension * sizeof(float));
+        // density
+        particle.dens = dens0;
+        particle.dens0 = dens0;
+        particle.ivalDens = dens0;
+        // mass
+        particle.mass = pow( parameters.particlesDistrib, 3) * dens0;
+        // store
+        n = (int)particles.size();
+        particles.resize( n + k, particle);
+        if ( k == 0 )
+            continue;
+
+        // set positions of new particles using coordinates of points 
+        // which the parallelogram/parallelepiped is filled with
+        if ( dimension == 2 )
+            fillParlgramWithPoints( vrtx1, vrtx2, vrtx3, 
+                                    particles[n].pos, stride, ival);
+        else
+            fillParlpipedWithPoints( vrtx1, vrtx2, vrtx3, vrtx4, 
+                                     particles[n].pos, stride, ival);
+
+        // the cloud could intersect the clouds created before
+        j = unifyPoints( n, (char *)&particles[0], sizeof(struct Particle),
+                         (int)offsetof(struct Particle, pos), n + k);
+        particles.resize( j);
+    }
+
+    // identifiers of particles
+    for ( j = 0; j < (int)particles.size(); j++ )
+        particles[j].id = j;
+
+    // error has occured
+    if ( i != info->endLine )
+        res = i;
+
+    return res;
+} // readCloudsSection
+
+// Read parameters section which is specified by 'info' from array with 
+// input data 'input', and initialize corresponding variables and 
+// data structures. The function returns 0 if succeeded and the number 
+// of string containing an error otherwise.
+int
+IO::readParamsSection( char **input,    // array with input data
+                       Section *info)   // section's info
+{
+    char name[paramNameLength + 1];
+    char fmt[10];
+    int i, j, n;
+    int res = 0;
+
+    // parameter's info
+    struct Param
+    {
+        const char *name; // name of the parameter
+        int  type;        // type of the parameter
+        void *var;        // pointer to a var the parameter's value to store in
+    };
+
+    // possible types of parameters
+    enum { INT_PARAM, FLOAT_PARAM, STRING_PARAM };
+
+    // possible parameters in the parameters section
+    Param params[] =
+    {
+        // dimension of the simulation
+        "DIM",          INT_PARAM,    (void *)(&dimension),
+        // initial particle distribution
+        "PRTS_DISTR",   FLOAT_PARAM,  (void *)(&parameters.particlesDistrib),
+        // initial boundary particle distribution
+        "BPRTS_DISTR",  FLOAT_PARAM,  (void *)(&parameters.bparticlesDistrib),
+        // speed of sound
+        "SOS",          FLOAT_PARAM,  (void *)(&parameters.sos),
+        // kernel to use in the calculations
+        "KERNEL",       STRING_PARAM, (void *)(parameters.kernelType),
+        // kernel's smoothing length
+        "SMOOTH_LEN",   FLOAT_PARAM,  (void *)(&parameters.smoothR),
+        // equation of state to calculate pressures
+        "EOS",          STRING_PARAM, (void *)(parameters.eosType),
+        // alpha factor to calculate viscosity
+        "VISC_ALPHA",   FLOAT_PARAM,  (void *)(&parameters.viscAlpha),
+        // beta factor to calculate viscosity
+        "VISC_BETA",    FLOAT_PARAM,  (void *)(&parameters.viscBeta),
+        // time step of integration
+        "TIME_STEP",    FLOAT_PARAM,  (void *)(&parameters.timeStep),
+        // number of steps to perform
+        "NSTEPS",       INT_PARAM,    (void *)(&parameters.nsteps),
+        // output frequence
+        "OUT_FREQ",     INT_PARAM,    (void *)(&parameters.outFreq),
+        // checkpoint frequence
+        "CHKPT_FREQ",   INT_PARAM,    (void *)(&parameters.chkptFreq),
+        // clipping volume (the area to render)
+        "CLIP_VOL",     FLOAT_PARAM,  (void *)(&parameters.clipVolume),
+        // radius to draw particles
+        "PRADIUS",      FLOAT_PARAM,  (void *)(&parameters.particlesRadius),
+        // size of the cache of frames to render (MB)
+        "CACHE_MB",     INT_PARAM,    (void *)(&parameters.cacheSize),
+        // rate of the playback (frames per second)
+        "PLAY_FPS",     FLOAT_PARAM,  (void *)(&parameters.playFps),
+        // number of particles to draw while the view is being changed
+        "LOD_BUDGET",   INT_PARAM,    (void *)(&parameters.lodBudget),
+        // number of frames to draw for each interval between output files
+        "INTERP_STEPS", INT_PARAM,    (void *)(&parameters.interpSteps),
+        // collect hardware performance counters (Linux only)
+        "PERF_EVENTS",  INT_PARAM,    (void *)(&parameters.perfEvents),
+        // number of timeline events kept per thread (0 - no trace)
+        "TRACE",        INT_PARAM,    (void *)(&parameters.traceSize),
+        // publish status of the run in shared memory
+        "TELEMETRY",    INT_PARAM,    (void *)(&parameters.telemetry),
+        // number of output frames kept in shared memory (0 - none)
+        "LIVE_FRAMES",  INT_PARAM,    (void *)(&parameters.liveFrames),
+        // don't write output files (frames are only kept in shared memory)
+        "LIVE_ONLY",    INT_PARAM,    (void *)(&parameters.liveOnly),
+        // trial steps per candidate of the calibration (0 - no calibration)
+        "TUNE_STEPS",   INT_PARAM,    (void *)(&parameters.tuneSteps),
+        // size of the cells of neighbor grids (units of cutoff plus skin)
+        "CELL_SIZE",    FLOAT_PARAM,  (void *)(&parameters.cellSize),
+        // skin of the neighbor lists (in units of 2*smoothR)
+        "NBR_SKIN",     FLOAT_PARAM,  (void *)(&parameters.skin),
+        // number of particles in a chunk of parallel loops
+        "CHUNK_SIZE",   INT_PARAM,    (void *)(&parameters.chunkSize),
+        // number of threads of the simulator
+        "THREADS",      INT_PARAM,    (void *)(&parameters.threads),
+    };
+
+    // number of parameters
+    int paramsNum = sizeof(params) / sizeof(params[0]);
+
+    // read parameters from the parameters section
+    for ( i = info->firstLine; i < info->endLine; i++ )
+    {
+        sprintf( fmt, "%%%ds %%n", paramNameLength);
+        sscanf( input[i], fmt, name, &n);
+
+        for ( j = 0; j < paramsNum; j++ )
+        {
+            if ( strcmp( params[j].name, name) )
+                continue;
+
+            // some parameter has been found - read and store its value
+            if ( params[j].type == INT_PARAM )
+            {
+                // type of the parameter is integer
+                sscanf( input[i] + n, "%d", (int *)params[j].var);
+                break;
+            }
+            else if ( params[j].type == FLOAT_PARAM )
+            {
+                // type of the parameter is float
+                sscanf( input[i] + n, "%f", (float *)params[j].var);
+                break;
+            }
+            else if ( params[j].type == STRING_PARAM )
+            {
+                // type of the parameter is string (char *)
+                sprintf( fmt, "%%%ds", stringParamLength);
+                sscanf( input[i] + n, fmt, (char *)params[j].var);
+                break;
+            }
+        }
+        
+        if ( j == paramsNum )
+        {
+            // parameter isn't valid
+            res = i;
+            break;
+        }
+    }
+
+    return res;
+} // readParamsSection
+
+// Unification of array of points - the function searches for identical 
+// points in the array 'recs' of 'recsNum' records of the size 'recSize', 
+// coordinates of the point are stored at 'posOffset' in the record. It 
+// eliminates all of them but the first one, shifts the array and returns 
+// its new size. The size of the part of the array which is already 
+// unified is set through 'unifiedPart'. Points are looked up in an open 
+// addressing hash table, so the unification takes linear time.
+int
+IO::unifyPoints( int unifiedPart, // unified part of the array
+                 char *recs,      // array of records
+                 int recSize,     // size of a record
+                 int posOffset,   // offset of coordinates in a record
+                 int recsNum)     // size of the array
+{
+    unsigned int mask;
+    unsigned int h;
+    float *pnt;
+    int i, k;
+    int m;
+
+    // hash table with indices of unique points, it's 
+    // kept at most half full to make the probing short
+    mask = 1;
+    while ( (int)mask < 2 * recsNum )
+        mask <<= 1;
+    vector<int> table( mask, -1);
+    mask--;
+
+    // unify the array
+    m = 0;
+    for ( i = 0; i < recsNum; i++ )
+    {
+        // search for point which is identical to the i-th one
+        pnt = (float *)(recs + (size_t)i * recSize + posOffset);
+        for ( h = hashPoint( pnt) & mask; ; h = (h + 1) & mask )
+        {
+            k = table[h];
+            if ( k < 0 || !memcmp( recs + (size_t)k * recSize + posOffset, 
+                                   pnt, dimension * sizeof(float)) )
+                break;
+        }
+        // eliminate it (points of the unified part are never eliminated)
+        if ( k >= 0 && i >= unifiedPart )
+            continue;
+        // keep it
+        if ( m != i )
+            memcpy( recs + (size_t)m * recSize, 
+                    recs + (size_t)i * recSize, recSize);
+        table[h] = m++;
+    }
+
+    // new size of the array
+    return m;
+} // unifyPoints
+
+// Returns hash value of the point 'pnt' computed 
+// from the bit patterns of its coordinates.
+unsigned int
+IO::hashPoint( const float *pnt)   // point
+{
+    unsigned int h = 2166136261u;
+    unsigned int bits;
+    int d;
+
+    for ( d = 0; d < dimension; d++ )
+    {
+        memcpy( &bits, pnt + d, sizeof(unsigned int));
+        h = (h ^ bits) * 16777619u;
+        h ^= h >> 15;
+    }
+
+    return h;
+} // hashPoint
+
+// The function fills triangle given by 'vrtx1', 'vrtx2' and 'vrtx3' with 
+// points, the interval between points is set by 'ival'. The points are 
+// stored in the array 'pnts', coordinates of the next point are 'stride' 
+// floats away from the previous one. If 'pnts' is NULL, the points are 
+// only counted. The number of points is returned.
+int
+IO::fillTriangleWithPoints( float *vrtx1,   // vertex 1
+                            float *vrtx2,   // vertex 2
+                            float *vrtx3,   // vertex 3
+                            float *pnts,    // array of points
+                            int stride,     // stride of the array
+                            float ival)     // interval between points
+{
+    float vec[3], vec1[3], vec2[3];
+    float pnt1[3], pnt2[3];
+    float offset;
+    float param;
+    float r;
+    int i, j, n;
+    
+    // reference vectors
+    vectorSubstraction( vec1, vrtx2, vrtx1);
+    vectorSubstraction( vec2, vrtx3, vrtx1);
+    // length of the triangle's side
+    r = vectorNorm( vec1);
+    // number of points the triangle's side can be filled with
+    j = (int)(r / ival);
+    // fill triangle with points
+    n = 0;
+    offset = (r - (float)(j - 1) * ival) / 2;
+    for ( i = 0; i < j; i++ )
+    {
+        // get point1 on one triangle's side and point2 on another
+        param = r ? ((ival * (float)i + offset) / r) : 0;
+        getPointOnSegmentByParam( vrtx1, vec1, pnt1, param);
+        getPointOnSegmentByParam( vrtx1, vec2, pnt2, param);
+        // fill the resulting segment with points
+        vectorSubstraction( vec, pnt2, pnt1);
+        n += fillSegmentWithPoints( pnt1, vec, 
+                                    pnts ? pnts + n * stride : NULL, 
+                                    stride, ival);
+    }
+    
+    return n;
+} /* fillTriangleWithPoints */
+
+// The function fills parallelepiped given by origin 'vrtx' and reference 
+// vectors 'vec1', 'vec2' and 'vec3' with with points, the interval between 
+// points is set by 'ival'. The points are stored in the array 'pnts', 
+// coordinates of the next point are 'stride' floats away from the previous 
+// one. If 'pnts' is NULL, the points are only counted. The number of points 
+// is returned. Slices of the parallelepiped are filled in parallel.
+int
+IO::fillParlpipedWithPoints( float *vrtx,    // origin
+                             float *vec1,    // vector 1
+                             float *vec2,    // vector 2
+                             float *vec3,    // vector 3
+                             float *pnts,    // array of points
+                             int stride,     // stride of the array
+                             float ival)     // interval between points
+{
+    float pnt[3];
+    float param;
+    float offset;
+    float r;
+    int i, j, n;
+    
+    // length of the parallelepiped's edge
+    r = vectorNorm( vec1);
+    // number of points the parallelepiped's edge can be filled with
+    j = (int)(r / ival);
+    // number of points in each slice
+    n = fillParlgramWithPoints( vrtx, vec2, vec3, NULL, 0, ival);
+    if ( pnts == NULL || j <= 0 )
+        return (j > 0) ? j * n : 0;
+    // fill parallelepiped with points
+    offset = (r - (float)(j - 1) * ival) / 2;
+#pragma omp parallel for private(pnt,param)
+    for ( i = 0; i < j; i++ )
+    {
+        // get point on the parallelepiped's edge
+        param = r ? ((ival * (float)i + offset) / r) : 0;
+        getPointOnSegmentByParam( vrtx, vec1, pnt, param);
+        // fill the parallelogram with points
+        fillParlgramWithPoints( pnt, vec2, vec3, 
+                                pnts + (size_t)i * n * stride, stride, ival);
+    }
+    
+    return j * n;
+} // fillParlpipedWithPoints
+
+// The function fills parallelogram given by origin 'vrtx' and reference 
+// vectors 'vec1' and 'vec2' with points, the interval between points is 
+// set by 'ival'. The points are stored in the array 'pnts', coordinates 
+// of the next point are 'stride' floats away from the previous one. If 
+// 'pnts' is NULL, the points are only counted. The number of points is 
+// returned. Rows of the parallelogram are filled in parallel (unless it's 
+// a slice of a parallelepiped which is being filled in parallel already).
+int
+IO::fillParlgramWithPoints( float *vrtx,    // origin
+                            float *vec1,    // vector 1
+                            float *vec2,    // vector 2
+                            float *pnts,    // array of points
+                            int stride,     // stride of the array
+                            float ival)     // interval between points
+{
+    float pnt[3];
+    float param;
+    float offset;
+    float r;
+    int i, j, n;
+    
+    // length of the parallelogram's side
+    r = vectorNorm( vec1);
+    // number of points the parallelogram's side can be filled with
+    j = (int)(r / ival);
+    // number of points in each row
+    n = fillSegmentWithPoints( vrtx, vec2, NULL, 0, ival);
+    if ( pnts == NULL || j <= 0 )
+        return (j > 0) ? j * n : 0;
+    // fill parallelogram with points
+    offset = (r - (float)(j - 1) * ival) / 2;
+#pragma omp parallel for private(pnt,param) if(!omp_in_parallel())
+    for ( i = 0; i < j; i++ )
+    {
+        // get point on the parallelogram's side
+        param = r ? ((ival * (float)i + offset) / r) : 0;
+        getPointOnSegmentByParam( vrtx, vec1, pnt, param);
+        // fill the segment with points
+        fillSegmentWithPoints( pnt, vec2, 
+                               pnts + (size_t)i * n * stride, stride, ival);
+    }
+    
+    return j * n;
+} // fillParlgramWithPoints
+
+// The function fills segment given by origin 'vrtx' and reference 
+// vector 'vec' with points, the interval between points is set by 
+// 'ival'. The points are stored in the array 'pnts', coordinates of 
+// the next point are 'stride' floats away from the previous one. If 
+// 'pnts' is NULL, the points are only counted. The number of points 
+// is returned.
+int
+IO::fillSegmentWithPoints( float *vrtx,    // origin
+                           float *vec,     // vector
+                           float *pnts,    // array of points
+                           int stride,     // stride of the array
+                           float ival)     // interval between points
+{
+    float param;
+    float offset;
+    float r;
+    int i, j;
+    
+    // length of the segment
+    r = vectorNorm( vec);
+    // number of points the segment can be filled with
+    j = (int)(r / ival);
+    if ( pnts == NULL || j <= 0 )
+        return (j > 0) ? j : 0;
+    // fill segment with points
+    offset = (r - (float)(j - 1) * ival) / 2;
+    for ( i = 0; i < j; i++ )
+    {
+        // get next point on the segment by parameter and store it
+        param = r ? ((ival * (float)i + offset) / r): 0;
+        getPointOnSegmentByParam( vrtx, vec, pnts + i * stride, param);
+    }
+
+    return j;
+} // fillSegmentWithPoints
+
+// Returns point 'pnt' belonging to a segment specified by 
+// origin 'vrtx' and reference vector 'vec', the offset of 
+// point from 'vrtx' is determined by 'param' (should be [0..1]).
+void
+IO::getPointOnSegmentByParam( float *vrtx,    // origin
+                              float *vec,     // vector
+                              float *pnt,     // point
+                              float param)    // parameter
+{
+    int d;
+    
+    for ( d = 0; d < dimension; d++ )
+        pnt[d] = param * vec[d] + vrtx[d];
+
+    return;
 } // getPointOnSegmentByParam
\ No newline at end of file
@@ -1,76 +1,91 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#ifndef YAPS_IO_H
-#define YAPS_IO_H
-
-class IO
-{
-
-public:
-
-    // read input file
-    static void readInput();
-
-    // flags
-    static char doReadParticles;
-    static char doReadBParticles;
-    static char doReadObstacles;
-
-private:
-
-    // name of the input file
-    static const char* inputFileName;
-    // maximum length of the file's string (with line feed)
-    static const int fileLineLength;
-    // maximum length of a section's name
-    static const int sectionNameLength;
-    // keyword to end a section
-    static const char* sectionEnd;
-    // maximum length of a parameter-string
-    static const int stringParamLength;
-    // maximum length of a parameter's name
-    static const int paramNameLength;
-
-    // section info
-    struct Section;
-
-    // read and process obstacles section
-    static int   readObstaclesSection       ( char **input, 
-                                              Section *info);
-    // read and process clouds section
-    static int   readCloudsSection          ( char **input, 
-                                              Section *info);
-    // read and process the section containing parameters
-    static int   readParamsSection          ( char **input, 
-                                              Section *Info);
-    // unification of array of points
-    static void  unifyPoints                ( int unifiedPart,
-                                              float ***pnts, 
-                                              int *pntsNum);
-    // fill triangle with points
-    static void  fillTriangleWithPoints     ( float *vrtx1, float *vrtx2, 
-                                              float *vrtx3, float ***pnts, 
-                                              int *pntsNum, float ival);
-    // fill parallelepiped with points
-    static void  fillParlpipedWithPoints    ( float *vrtx, float *vec1, 
-                                              float *vec2, float *vec3, 
-                                              float ***pnts, int *pntsNum, 
-                                              float ival);
-    // fill parallelogram with points
-    static void  fillParlgramWithPoints     ( float *vrtx, float *vec1, 
-                                              float *vec2, float ***pnts, 
-                                              int *pntsNum, float ival);
-    // fill segment with points
-    static void  fillSegmentWithPoints      ( float *vrtx, float *vec, 
-                                              float ***pnts, int *pntsNum, 
-                                              float ival);
-    // get point on segment
-    static void  getPointOnSegmentByParam   ( float *vrtx, float *vec, 
-                                              float *Pnt, float Param);
-
-};
-
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_IO_H
+#define YAPS_IO_H
+
+#include <cstddef>
+
+class IO
+{
+
+public:
+
+    // read input file (default input file if 'fileName' isn't set), 
+    // returns non-zero if the file can't be opened
+    static int  readInput( const char *fileName = NULL);
+
+    // flags
+    static char doReadParticles;
+    static char doReadBParticles;
+    static char doReadObstacles;
+
+private:
+
+    // name of the input file
+    static const char* inputFileName;
+    // maximum length of the file's string (with line feed)
+    static const int fileLineLength;
+    // maximum length of a section's name
+    static const int sectionNameLength;
+    // keyword to end a section
+    static const char* sectionEnd;
+    // maximum length of a parameter-string
+    static const int stringParamLength;
+    // maximum length of a parameter's name
+    static const int paramNameLength;
+    // version of the generator of boundary particles (a part of the 
+    // key of their cache, increase it whenever the points change)
+    static const int generatorVersion;
+
+    // section info
+    struct Section;
+
+    // read and process obstacles section
+    static int   readObstaclesSection       ( char **input, 
+                                              Section *info);
+    // read and process clouds section
+    static int   readCloudsSection          ( char **input, 
+                                              Section *info);
+    // read and process the section containing parameters
+    static int   readParamsSection          ( char **input, 
+                                              Section *Info);
+    // read triangles from binary STL file
+    static int   readSTL                    ( const char *str);
+    // hash value of section
+    static unsigned long long hashSection   ( char **input,
+                                              Section *info);
+    // unification of array of points
+    static int   unifyPoints                ( int unifiedPart,
+                                              char *recs, int recSize,
+                                              int posOffset, int recsNum);
+    // hash value of point
+    static unsigned int hashPoint           ( const float *pnt);
+    // create boundary particles for obstacles
+    static void  fillObstaclesWithPoints    ( int firstObstacle);
+    // fill triangle with points
+    static int   fillTriangleWithPoints     ( float *vrtx1, float *vrtx2, 
+                                              float *vrtx3, float *pnts, 
+                                              int stride, float ival);
+    // fill parallelepiped with points
+    static int   fillParlpipedWithPoints    ( float *vrtx, float *vec1, 
+                                              float *vec2, float *vec3, 
+                                              float *pnts, int stride, 
+                                              float ival);
+    // fill parallelogram with points
+    static int   fillParlgramWithPoints     ( float *vrtx, float *vec1, 
+                                              float *vec2, float *pnts, 
+                                              int stride, float ival);
+    // fill segment with points
+    static int   fillSegmentWithPoints      ( float *vrtx, float *vec, 
+                                              float *pnts, int stride, 
+                                              float ival);
+    // get point on segment
+    static void  getPointOnSegmentByParam   ( float *vrtx, float *vec, 
+                                              float *Pnt, float Param);
+
+};
+
 #endif // YAPS_IO_H
\ No newline at end of file
@@ -1,57 +1,473 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#include "iobin.h"
-#include "common.h"
-#include <cstdio>
-using namespace std;
-
-// filename
-const char* IOBin::fname = "output";
-
-// Read data in binary form
-int
-IOBin::readData(int nfile)
-{
-    // open file for reading
-    char ffname[20];
-    sprintf( ffname, "%s_%05d.bin", fname, nfile);
-    FILE *file = fopen( ffname, "rb");
-    if ( file == NULL )
-        return 1;
- 
-    // read particles data
-    Particle particle;
-    particles.clear();
-    while ( fread( (void *)&particle, sizeof(struct Particle), 1, file) )
-        particles.push_back( particle);
-
-    // close the file
-    fclose( file);
-
-    return 0;
-} // readData
-
-// Write data in binary form
-int
-IOBin::writeData(int nfile)
-{
-    // open file for writing
-    char ffname[20];
-    sprintf( ffname, "%s_%05d.bin", fname, nfile);
-    FILE *file = fopen( ffname, "wb");
-    if ( file == NULL )
-        return 1;
- 
-    // write particles data
-    for ( int i = 0; i < (int)particles.size(); i++ )
-        fwrite( &(particles[i]), sizeof(struct Particle), 1, file);
-
-    // close the file
-    fclose( file);
-
-    return 0;
-
-} // writeData
\ No newline at end of file
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "iobin.h"
+#include "common.h"
+#include <cstdio>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+// filename
+const char* IOBin::fname = "output";
+// checkpoint filename
+const char* IOBin::chkptName = "checkpoint.bin";
+// boundary particles' cache filename
+const char* IOBin::cacheName = "bparticles.cache";
+
+// version of the format of output files
+const int IOBin::dataVersion = 1;
+
+// Output file's header, the particles follow it. The files written 
+// before the header was introduced (bare arrays of particles) have 
+// another layout of the particles and aren't read.
+struct IOBin::DataHeader
+{
+    char magic[8];      // "YAPSOUT"
+    int version;        // version of the format
+    int prtSize;        // size of particle's structure
+    int prtsNum;        // number of particles
+};
+
+// Checkpoint's header
+struct IOBin::ChkptHeader
+{
+    char magic[8];      // "YAPSCHK"
+    int version;        // version of the format
+    int dimension;      // dimension of the simulation
+    int step;           // next step to perform
+    int nfile;          // next output file
+    int prtsNum;        // number of smoothing particles
+    int bprtsNum;       // number of boundary particles
+    int obstsNum;       // number of obstacles
+    int paramsSize;     // size of parameters' structure
+    int prtSize;        // size of particle's structure
+};
+
+// Cache's header
+struct IOBin::CacheHeader
+{
+    char magic[8];              // "YAPSBPC"
+    int version;                // version of the format
+    int bprtsNum;               // number of boundary particles
+    unsigned long long key;     // obstacles and parameters
+};
+
+// Read data in binary form
+int
+IOBin::readData(int nfile)
+{
+    return readData( nfile, particles);
+} // readData
+
+// Read data in binary form into 'prts', the file is read at once. 
+// The function doesn't touch global data, so it could be called 
+// from another thread.
+int
+IOBin::readData(int nfile, Particles &prts)
+{
+    char ffname[20];
+    sprintf( ffname, "%s_%05d.bin", fname, nfile);
+
+    return readData( ffname, prts);
+} // readData
+
+// Read output file 'ffname' into 'prts'. The function returns 0 if 
+// succeeded and 1 if the file doesn't exist or has another format.
+int
+IOBin::readData( const char *ffname,    // filename
+                 Particles &prts)       // particles
+{
+    // open file for reading
+    FILE *file = fopen( ffname, "rb");
+    if ( file == NULL )
+        return 1;
+
+    // size of the file and header
+    DataHeader header;
+    fseek( file, 0, SEEK_END);
+    long long size = (long long)ftell( file);
+    fseek( file, 0, SEEK_SET);
+    if ( fread( &header, sizeof(struct DataHeader), 1, file) != 1 ||
+         checkHeader( &header, ffname, size) )
+    {
+        fclose( file);
+        return 1;
+    }
+ 
+    // read particles data
+    int n = header.prtsNum;
+    prts.resize( n);
+    if ( n > 0 && 
+         fread( (void *)&prts[0], sizeof(struct Particle), n, file) != 
+         (size_t)n )
+    {
+        prts.clear();
+        fclose( file);
+        return 1;
+    }
+
+    // close the file
+    fclose( file);
+
+    return 0;
+} // readData
+
+// Write data in binary form
+int
+IOBin::writeData(int nfile)
+{
+    // open file for writing
+    char ffname[20];
+    sprintf( ffname, "%s_%05d.bin", fname, nfile);
+    FILE *file = fopen( ffname, "wb");
+    if ( file == NULL )
+        return 1;
+
+    // header
+    DataHeader header;
+    memset( &header, 0, sizeof(struct DataHeader));
+    strcpy( header.magic, "YAPSOUT");
+    header.version = dataVersion;
+    header.prtSize = (int)sizeof(struct Particle);
+    header.prtsNum = (int)particles.size();
+    fwrite( &header, sizeof(struct DataHeader), 1, file);
+ 
+    // write particles data
+    for ( int i = 0; i < (int)particles.size(); i++ )
+        fwrite( &(particles[i]), sizeof(struct Particle), 1, file);
+
+    // close the file
+    fclose( file);
+
+    return 0;
+
+} // writeData
+
+// Check header 'header' of output file 'ffname' of the size 'fileSize' 
+// bytes. The function returns 0 if the file has the current format and 
+// holds the whole number of particles written in the header, otherwise 
+// it warns (once) and returns 1.
+int
+IOBin::checkHeader( const DataHeader *header,    // header
+                    const char *ffname,          // filename
+                    long long fileSize)          // size of the file
+{
+    static char warned = 0;
+
+    if ( !strcmp( header->magic, "YAPSOUT") && 
+         header->version == dataVersion && 
+         header->prtSize == (int)sizeof(struct Particle) && 
+         header->prtsNum >= 0 && 
+         fileSize == (long long)sizeof(struct DataHeader) + 
+                     (long long)header->prtsNum * 
+                     (long long)sizeof(struct Particle) )
+        return 0;
+
+#pragma omp critical (iobin_warning)
+    {
+        if ( !warned )
+            printf( "%s isn't an output file of this version "
+                    "(or it's truncated), it's skipped\n", ffname);
+        warned = 1;
+    }
+
+    return 1;
+} // checkHeader
+
+// Map data file 'nfile' into memory, particles 'prts' are valid 
+// until 'unmapData' is called. The pages are read on demand, so 
+// the function is cheap and could be called from several threads.
+// The function returns 0 if succeeded and 1 otherwise (the file 
+// doesn't exist or has another format).
+int
+IOBin::mapData( int nfile,               // number of the file
+                const Particle **prts,   // mapped particles
+                int *prtsNum)            // number of particles
+{
+    char ffname[20];
+    sprintf( ffname, "%s_%05d.bin", fname, nfile);
+    *prts = NULL;
+    *prtsNum = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA( ffname, GENERIC_READ, FILE_SHARE_READ, NULL, 
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if ( file == INVALID_HANDLE_VALUE )
+        return 1;
+    long long size = (long long)GetFileSize( file, NULL);
+    void *addr = NULL;
+    if ( size >= (long long)sizeof(struct DataHeader) )
+    {
+        HANDLE mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 
+                                            0, 0, NULL);
+        addr = (mapping != NULL) ? 
+               MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        // the view keeps the mapping open
+        if ( mapping != NULL )
+            CloseHandle( mapping);
+    }
+    CloseHandle( file);
+    if ( addr == NULL )
+        return 1;
+#else
+    int fd = open( ffname, O_RDONLY);
+    if ( fd < 0 )
+        return 1;
+    struct stat st;
+    long long size = (fstat( fd, &st) == 0) ? (long long)st.st_size : 0;
+    void *addr = NULL;
+    if ( size >= (long long)sizeof(struct DataHeader) )
+    {
+        addr = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( addr == MAP_FAILED )
+            addr = NULL;
+        else
+            madvise( addr, size, MADV_SEQUENTIAL);
+    }
+    close( fd);
+    if ( addr == NULL )
+        return 1;
+#endif
+
+    // the particles follow the header
+    const DataHeader *header = (const DataHeader *)addr;
+    int res = checkHeader( header, ffname, size);
+    if ( res || header->prtsNum == 0 )
+    {
+#ifdef _WIN32
+        UnmapViewOfFile( addr);
+#else
+        munmap( addr, size);
+#endif
+        return res;
+    }
+    *prts = (const Particle *)(header + 1);
+    *prtsNum = header->prtsNum;
+
+    return 0;
+} // mapData
+
+// Unmap particles 'prts' mapped by 'mapData'.
+void
+IOBin::unmapData( const Particle *prts,   // mapped particles
+                  int prtsNum)            // number of particles
+{
+    if ( prts == NULL )
+        return;
+
+    // the mapping starts with the header
+    const DataHeader *header = (const DataHeader *)prts - 1;
+#ifdef _WIN32
+    UnmapViewOfFile( (void *)header);
+#else
+    munmap( (void *)header, sizeof(struct DataHeader) + 
+                            prtsNum * sizeof(struct Particle));
+#endif
+
+    return;
+} // unmapData
+
+// Write the full state of the simulation - parameters, smoothing 
+// and boundary particles, obstacles, the number of the next step 
+// 'step' and of the next output file 'nfile'. The checkpoint is 
+// written to a temporary file first and then renamed, so the 
+// previous checkpoint survives if the writing is interrupted.
+int
+IOBin::writeCheckpoint( int step,     // next step to perform
+                        int nfile)    // next output file
+{
+    // open temporary file for writing
+    char tmpname[64];
+    sprintf( tmpname, "%s.tmp", chkptName);
+    FILE *file = fopen( tmpname, "wb");
+    if ( file == NULL )
+        return 1;
+
+    // header
+    ChkptHeader header;
+    memset( &header, 0, sizeof(struct ChkptHeader));
+    strcpy( header.magic, "YAPSCHK");
+    header.version = 3;
+    header.dimension = dimension;
+    header.step = step;
+    header.nfile = nfile;
+    header.prtsNum = (int)particles.size();
+    header.bprtsNum = (int)bparticles.size();
+    header.obstsNum = (int)obstacles.size();
+    header.paramsSize = (int)sizeof(struct Parameters);
+    header.prtSize = (int)sizeof(struct Particle);
+
+    // write header, parameters and data
+    int res = 0;
+    if ( fwrite( &header, sizeof(struct ChkptHeader), 1, file) != 1 ||
+         fwrite( &parameters, sizeof(struct Parameters), 1, file) != 1 )
+        res = 1;
+    if ( res == 0 && header.prtsNum > 0 &&
+         fwrite( &particles[0], sizeof(struct Particle), 
+                 header.prtsNum, file) != (size_t)header.prtsNum )
+        res = 1;
+    if ( res == 0 && header.bprtsNum > 0 &&
+         fwrite( &bparticles[0], sizeof(struct BParticle), 
+                 header.bprtsNum, file) != (size_t)header.bprtsNum )
+        res = 1;
+    if ( res == 0 && header.obstsNum > 0 &&
+         fwrite( &obstacles[0], sizeof(struct Obstacle), 
+                 header.obstsNum, file) != (size_t)header.obstsNum )
+        res = 1;
+
+    // close the file
+    if ( fclose( file) != 0 )
+        res = 1;
+    if ( res )
+    {
+        remove( tmpname);
+        return 1;
+    }
+
+    // replace previous checkpoint
+#ifdef _WIN32
+    remove( chkptName);
+#endif
+    if ( rename( tmpname, chkptName) != 0 )
+        return 1;
+
+    return 0;
+} // writeCheckpoint
+
+// Read the full state of the simulation from the checkpoint 'ckname'. 
+// The number of the next step and of the next output file are returned 
+// through 'step' and 'nfile'. The function returns 0 if succeeded.
+int
+IOBin::readCheckpoint( const char *ckname,   // checkpoint filename
+                       int *step,            // next step to perform
+                       int *nfile)           // next output file
+{
+    // open file for reading
+    FILE *file = fopen( ckname, "rb");
+    if ( file == NULL )
+        return 1;
+
+    // read and check header
+    ChkptHeader header;
+    if ( fread( &header, sizeof(struct ChkptHeader), 1, file) != 1 ||
+         strcmp( header.magic, "YAPSCHK") || header.version != 3 || 
+         header.paramsSize != (int)sizeof(struct Parameters) || 
+         header.prtSize != (int)sizeof(struct Particle) )
+    {
+        fclose( file);
+        return 1;
+    }
+
+    // read parameters and data
+    int res = 0;
+    if ( fread( &parameters, sizeof(struct Parameters), 1, file) != 1 )
+        res = 1;
+    particles.resize( header.prtsNum);
+    bparticles.resize( header.bprtsNum);
+    obstacles.resize( header.obstsNum);
+    if ( res == 0 && header.prtsNum > 0 &&
+         fread( &particles[0], sizeof(struct Particle), 
+                header.prtsNum, file) != (size_t)header.prtsNum )
+        res = 1;
+    if ( res == 0 && header.bprtsNum > 0 &&
+         fread( &bparticles[0], sizeof(struct BParticle), 
+                header.bprtsNum, file) != (size_t)header.bprtsNum )
+        res = 1;
+    if ( res == 0 && header.obstsNum > 0 &&
+         fread( &obstacles[0], sizeof(struct Obstacle), 
+                header.obstsNum, file) != (size_t)header.obstsNum )
+        res = 1;
+
+    // close the file
+    fclose( file);
+    if ( res )
+        return 1;
+
+    dimension = header.dimension;
+    *step = header.step;
+    *nfile = header.nfile;
+
+    return 0;
+} // readCheckpoint
+
+// Read boundary particles from the cache if it has been created 
+// with the same 'key'. The function returns 0 if succeeded.
+int
+IOBin::readBParticles( unsigned long long key)   // key of the cache
+{
+    // open file for reading
+    FILE *file = fopen( cacheName, "rb");
+    if ( file == NULL )
+        return 1;
+
+    // read and check header
+    CacheHeader header;
+    if ( fread( &header, sizeof(struct CacheHeader), 1, file) != 1 ||
+         strcmp( header.magic, "YAPSBPC") || header.version != 1 || 
+         header.key != key )
+    {
+        fclose( file);
+        return 1;
+    }
+
+    // read boundary particles
+    BParticles bprts( header.bprtsNum);
+    if ( header.bprtsNum > 0 &&
+         fread( &bprts[0], sizeof(struct BParticle), 
+                header.bprtsNum, file) != (size_t)header.bprtsNum )
+    {
+        fclose( file);
+        return 1;
+    }
+    bparticles.swap( bprts);
+
+    // close the file
+    fclose( file);
+
+    return 0;
+} // readBParticles
+
+// Write boundary particles to the cache with the key 'key'.
+int
+IOBin::writeBParticles( unsigned long long key)   // key of the cache
+{
+    // open file for writing
+    FILE *file = fopen( cacheName, "wb");
+    if ( file == NULL )
+        return 1;
+
+    // header
+    CacheHeader header;
+    memset( &header, 0, sizeof(struct CacheHeader));
+    strcpy( header.magic, "YAPSBPC");
+    header.version = 1;
+    header.bprtsNum = (int)bparticles.size();
+    header.key = key;
+
+    // write header and boundary particles
+    int res = 0;
+    if ( fwrite( &header, sizeof(struct CacheHeader), 1, file) != 1 )
+        res = 1;
+    if ( res == 0 && header.bprtsNum > 0 &&
+         fwrite( &bparticles[0], sizeof(struct BParticle), 
+                 header.bprtsNum, file) != (size_t)header.bprtsNum )
+        res = 1;
+
+    // close the file, incomplete cache is removed
+    if ( fclose( file) != 0 )
+        res = 1;
+    if ( res )
+        remove( cacheName);
+
+    return res;
+} // writeBParticles
\ No newline at end of file
@@ -1,21 +1,53 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#ifndef YAPS_IOBIN_H
-#define YAPS_IOBIN_H
-
-class IOBin
-{
-
-public:
-    // filename
-    static const char* fname;
-    // read and write transient data in binary form
-    static int readData  ( int nfile);
-    static int writeData ( int nfile);
-
-};
-
-#endif // YAPS_IOBIN_H
\ No newline at end of file
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_IOBIN_H
+#define YAPS_IOBIN_H
+
+#include "common.h"
+
+class IOBin
+{
+
+public:
+    // filename
+    static const char* fname;
+    // checkpoint filename
+    static const char* chkptName;
+    // boundary particles' cache filename
+    static const char* cacheName;
+    // read and write transient data in binary form
+    static int readData  ( int nfile);
+    static int readData  ( int nfile, Particles &prts);
+    static int readData  ( const char *ffname, Particles &prts);
+    static int writeData ( int nfile);
+    // map transient data into memory (read-only) and unmap it
+    static int mapData   ( int nfile, const Particle **prts, int *prtsNum);
+    static void unmapData( const Particle *prts, int prtsNum);
+    // read and write the full state of the simulation
+    static int readCheckpoint  ( const char *ckname, int *step, int *nfile);
+    static int writeCheckpoint ( int step, int nfile);
+    // read and write cached boundary particles, 'key' identifies 
+    // obstacles and parameters the particles have been created for
+    static int readBParticles  ( unsigned long long key);
+    static int writeBParticles ( unsigned long long key);
+
+private:
+
+    // version of the format of output files
+    static const int dataVersion;
+    // output file's header
+    struct DataHeader;
+    // check header of output file of the size 'fileSize'
+    static int  checkHeader( const DataHeader *header, 
+                             const char *ffname, long long fileSize);
+    // checkpoint's header
+    struct ChkptHeader;
+    // cache's header
+    struct CacheHeader;
+
+};
+
+#endif // YAPS_IOBIN_H
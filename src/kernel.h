@@ -1,36 +1,45 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#ifndef YAPS_KERNEL_H
-#define YAPS_KERNEL_H
-
-class KernelBase
-{
-public:
-    // calculate the kernel's gradient
-    virtual int getGrad( float *grad, float *Rij) = 0;
-protected:
-    // factor to calculate the gradient
-    float gradFactor;
-    static const float PI;
-};
-
-class KernelSpline : public KernelBase {
-public:
-    // constructor
-    KernelSpline();
-    // calculate the kernel's gradient
-    int getGrad( float *grad, float *Rij);
-};
-
-class KernelSpiky : public KernelBase {
-public:
-    // constructor
-    KernelSpiky();
-    // calculate the kernel's gradient
-    int getGrad( float *grad, float *Rij);
-};
-
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_KERNEL_H
+#define YAPS_KERNEL_H
+
+class KernelBase
+{
+public:
+    virtual ~KernelBase() {}
+    // calculate the kernel's gradient
+    virtual int getGrad( float *grad, float *Rij) = 0;
+    // calculate the kernel's value
+    virtual float getValue( float *Rij) = 0;
+protected:
+    // factor to calculate the gradient
+    float gradFactor;
+    // factor to calculate the value
+    float valueFactor;
+    static const float PI;
+};
+
+class KernelSpline : public KernelBase {
+public:
+    // constructor
+    KernelSpline();
+    // calculate the kernel's gradient
+    int getGrad( float *grad, float *Rij);
+    // calculate the kernel's value
+    float getValue( float *Rij);
+};
+
+class KernelSpiky : public KernelBase {
+public:
+    // constructor
+    KernelSpiky();
+    // calculate the kernel's gradient
+    int getGrad( float *grad, float *Rij);
+    // calculate the kernel's value
+    float getValue( float *Rij);
+};
+
 #endif /* YAPS_KERNEL_H */
\ No newline at end of file
@@ -1,22 +1,33 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#ifndef YAPS_OPENGL_H
-#define YAPS_OPENGL_H
-
-#ifndef WIN32_GL
-// X11
-#include <GL/gl.h>
-#include <GL/glu.h>
-#include <GL/glut.h>
-#else
-// Win32
-#include <windows.h>
-#include <gl/gl.h>
-#include <gl/glu.h>
-#include "glut.h"
-#endif
-
-#endif // YAPS_OPENGL_H
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_OPENGL_H
+#define YAPS_OPENGL_H
+
+#ifndef WIN32_GL
+// X11
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glu.h>
+#include <GL/glut.h>
+// vertex buffer objects (OpenGL 1.5) are available
+#define YAPS_GL_VBO
+#else
+// Win32
+#include <windows.h>
+#include <gl/gl.h>
+#include <gl/glu.h>
+#include "glut.h"
+#endif
+
+// point sprites (OpenGL 2.0 / ARB_point_sprite)
+#ifndef GL_POINT_SPRITE
+#define GL_POINT_SPRITE     0x8861
+#endif
+#ifndef GL_COORD_REPLACE
+#define GL_COORD_REPLACE    0x8862
+#endif
+
+#endif // YAPS_OPENGL_H
@@ -0,0 +1,823 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "profile.h"
+#include "common.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <omp.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+// names of the phases
+const char* Profiler::phaseNames[] = { "eos", "fluid", "boundary", 
+                                       "integration", "neighbors", 
+                                       "output" };
+
+// names of the counters
+const char* Profiler::counterNames[] = { "cycles", "instructions", 
+                                         "l1d_misses", "llc_misses", 
+                                         "branch_misses" };
+
+// names of the events which aren't phases
+static const char* eventNames[] = { NULL, NULL, NULL, "write", "checkpoint" };
+// categories of the events
+static const char* eventCats[] = { "phase", "thread", "chunk", "output", 
+                                   "output" };
+
+// summary filename
+const char* Profiler::timingName = "timing";
+// timeline filename
+static const char* traceName = "trace.json";
+// filenames of the pairs of each step and the histogram of neighbors
+static const char* pairsName = "pairs.csv";
+static const char* neighborsName = "neighbors.csv";
+
+// Event of the timeline
+struct Profiler::TraceEvent
+{
+    double start;           // start time
+    double end;             // end time
+    short  type;            // type of the event
+    short  phase;           // phase during which the event happened
+    int    arg;             // first particle of a chunk, number of a file
+};
+
+// Timers of a thread, they are padded 
+// to avoid false sharing between threads
+struct Profiler::ThreadTimers
+{
+    double start[PHASES_NUM];   // start of the thread's share
+    double time[PHASES_NUM];    // total time of the thread's shares
+    // performance counters - the group of the counters which are 
+    // available is read at once, 'slot' is the position of the 
+    // counter in the group (-1 if it isn't available), the total 
+    // time the group was enabled and running in the phases (they 
+    // differ if the kernel multiplexed the counters)
+    int groupFd;
+    int fds[COUNTERS_NUM];
+    int slot[COUNTERS_NUM];
+    int groupSize;
+    unsigned long long enabled;
+    unsigned long long running;
+    unsigned long long countStart[PHASES_NUM][READINGS_NUM];
+    unsigned long long counts[PHASES_NUM][COUNTERS_NUM];
+    // the same for the phases measured by the master thread
+    unsigned long long masterStart[PHASES_NUM][READINGS_NUM];
+    unsigned long long masterCounts[PHASES_NUM][COUNTERS_NUM];
+    // ring buffer of the timeline's events and the number 
+    // of the events added, start of the open events
+    TraceEvent *events;
+    long eventsNum;
+    double eventStart[TRACE_TYPES];
+    // pairs checked and accepted in the current step, 
+    // histogram of neighbors per particle
+    long long pairs[PHASES_NUM][2];
+    long long neighbors[NEIGHBORS_BINS];
+    char pad[64];
+};
+vector<Profiler::ThreadTimers> Profiler::threadTimers;
+
+// wall time of the phases
+double Profiler::phaseStart[PHASES_NUM];
+double Profiler::phaseTime[PHASES_NUM];
+int    Profiler::phaseCalls[PHASES_NUM];
+// start of the run and number of steps performed
+double Profiler::runStart = 0.0;
+int    Profiler::steps = 0;
+// performance counters are collected
+char   Profiler::countersOn = 0;
+// timeline is recorded and number of events kept per thread
+char   Profiler::tracing = 0;
+int    Profiler::traceSize = 0;
+// pairs checked and accepted during the run and the file of the steps
+long long Profiler::pairsTotal[PHASES_NUM][2];
+FILE*  Profiler::pairsFile = NULL;
+
+// Initialize timers, it should be called before the first step.
+void
+Profiler::init()
+{
+    threadTimers.resize( omp_get_max_threads());
+    memset( &threadTimers[0], 0, 
+            threadTimers.size() * sizeof(struct ThreadTimers));
+    memset( phaseTime, 0, sizeof(phaseTime));
+    memset( phaseCalls, 0, sizeof(phaseCalls));
+    for ( int t = 0; t < (int)threadTimers.size(); t++ )
+        threadTimers[t].groupFd = -1;
+    runStart = omp_get_wtime();
+    steps = 0;
+
+    // pairs of each step
+    memset( pairsTotal, 0, sizeof(pairsTotal));
+    pairsFile = fopen( pairsName, "w");
+    if ( pairsFile != NULL )
+        fprintf( pairsFile, "step,fluid_checked,fluid_accepted,"
+                            "fluid_wasted,mean_neighbors,"
+                            "boundary_checked,boundary_accepted\n");
+
+    // ring buffers of the timeline
+    traceSize = parameters.traceSize;
+    tracing = (traceSize > 0);
+    for ( int t = 0; tracing && t < (int)threadTimers.size(); t++ )
+        threadTimers[t].events = new TraceEvent[traceSize];
+
+    // each thread opens its own counters
+    countersOn = 0;
+    if ( parameters.perfEvents )
+    {
+#pragma omp parallel
+        openCounters();
+        for ( int t = 0; t < (int)threadTimers.size(); t++ )
+            if ( threadTimers[t].groupFd >= 0 )
+                countersOn = 1;
+        if ( !countersOn )
+            printf( "Performance counters aren't available\n");
+    }
+
+    return;
+} // init
+
+// Start phase 'phase', it's called by the master thread.
+void
+Profiler::startPhase( int phase)   // phase
+{
+    phaseStart[phase] = omp_get_wtime();
+    if ( countersOn )
+        readCounters( threadTimers[0].masterStart[phase]);
+    if ( tracing )
+        threadTimers[0].eventStart[TRACE_PHASE] = phaseStart[phase];
+
+    return;
+} // startPhase
+
+// Stop phase 'phase', it's called by the master thread.
+void
+Profiler::stopPhase( int phase)   // phase
+{
+    double end = omp_get_wtime();
+    phaseTime[phase] += end - phaseStart[phase];
+    phaseCalls[phase]++;
+    if ( tracing )
+        addEvent( 0, TRACE_PHASE, phase, 0, phaseStart[phase], end);
+    if ( countersOn )
+    {
+        unsigned long long values[READINGS_NUM];
+        ThreadTimers &timers = threadTimers[0];
+        readCounters( values);
+        addCounts( timers, timers.masterCounts[phase], 
+                   timers.masterStart[phase], values);
+    }
+
+    return;
+} // stopPhase
+
+// Start the share of the current thread in phase 'phase', 
+// it's called by each thread inside of parallel region.
+void
+Profiler::startThread( int phase)   // phase
+{
+    int thread = omp_get_thread_num();
+
+    if ( thread >= (int)threadTimers.size() )
+        return;
+    threadTimers[thread].start[phase] = omp_get_wtime();
+    if ( countersOn )
+        readCounters( threadTimers[thread].countStart[phase]);
+
+    return;
+} // startThread
+
+// Stop the share of the current thread in phase 'phase', 
+// it's called by each thread inside of parallel region.
+void
+Profiler::stopThread( int phase)   // phase
+{
+    int thread = omp_get_thread_num();
+
+    if ( thread >= (int)threadTimers.size() )
+        return;
+    ThreadTimers &timers = threadTimers[thread];
+    double end = omp_get_wtime();
+    timers.time[phase] += end - timers.start[phase];
+    if ( tracing )
+        addEvent( thread, TRACE_SHARE, phase, 0, timers.start[phase], end);
+    if ( countersOn )
+    {
+        unsigned long long values[READINGS_NUM];
+        readCounters( values);
+        addCounts( timers, timers.counts[phase], 
+                   timers.countStart[phase], values);
+    }
+
+    return;
+} // stopThread
+
+// Count performed step.
+void
+Profiler::countStep()
+{
+    long long pairs[PHASES_NUM][2];
+    int p, t;
+
+    // pairs of the step
+    memset( pairs, 0, sizeof(pairs));
+    for ( t = 0; t < (int)threadTimers.size(); t++ )
+    {
+        for ( p = 0; p < PHASES_NUM; p++ )
+        {
+            pairs[p][0] += threadTimers[t].pairs[p][0];
+            pairs[p][1] += threadTimers[t].pairs[p][1];
+        }
+        memset( threadTimers[t].pairs, 0, sizeof(threadTimers[t].pairs));
+    }
+    for ( p = 0; p < PHASES_NUM; p++ )
+    {
+        pairsTotal[p][0] += pairs[p][0];
+        pairsTotal[p][1] += pairs[p][1];
+    }
+    if ( pairsFile != NULL )
+    {
+        long long *fluid = pairs[PHASE_FLUID];
+        fprintf( pairsFile, "%d,%lld,%lld,%.6f,%.3f,%lld,%lld\n", steps, 
+                 fluid[0], fluid[1], 
+                 fluid[0] ? 1.0 - (double)fluid[1] / fluid[0] : 0.0, 
+                 particles.size() ? (double)fluid[1] / particles.size() : 0.0, 
+                 pairs[PHASE_BOUNDARY][0], pairs[PHASE_BOUNDARY][1]);
+    }
+
+    steps++;
+
+    return;
+} // countStep
+
+// Count pairs checked and accepted by the current 
+// thread in its share of 'phase'.
+void
+Profiler::countPairs( int phase,            // phase
+                      long long checked,    // pairs checked
+                      long long accepted)   // pairs accepted
+{
+    int thread = omp_get_thread_num();
+    if ( thread < (int)threadTimers.size() )
+    {
+        threadTimers[thread].pairs[phase][0] += checked;
+        threadTimers[thread].pairs[phase][1] += accepted;
+    }
+
+    return;
+} // countPairs
+
+// Count particle which has 'n' neighbors (the particles inside 
+// of the support of the kernel) in the histogram of the thread.
+void
+Profiler::countNeighbors( int n)    // number of neighbors
+{
+    int thread = omp_get_thread_num();
+    if ( thread < (int)threadTimers.size() )
+        threadTimers[thread].neighbors[min( n, NEIGHBORS_BINS - 1)]++;
+
+    return;
+} // countNeighbors
+
+// Print summary of the pairs and write the histogram of neighbors, 
+// a pair is wasted if it has been checked but not accepted.
+void
+Profiler::reportPairs()
+{
+    long long *fluid = pairsTotal[PHASE_FLUID];
+    long long *boundary = pairsTotal[PHASE_BOUNDARY];
+    int s = (steps > 0) ? steps : 1;
+    int b, t;
+
+    printf( "pairs : fluid %.4g checked, %.4g accepted per step, "
+            "%.2f %% wasted\n", (double)fluid[0] / s, (double)fluid[1] / s, 
+            fluid[0] ? 100.0 * (1.0 - (double)fluid[1] / fluid[0]) : 0.0);
+    printf( "pairs : boundary %.4g checked, %.4g inside of the cutoff "
+            "per step, %.2f %% wasted\n", (double)boundary[0] / s, 
+            (double)boundary[1] / s, boundary[0] ? 
+            100.0 * (1.0 - (double)boundary[1] / boundary[0]) : 0.0);
+
+    // histogram over all the steps
+    long long hist[NEIGHBORS_BINS];
+    long long count = 0, sum = 0;
+    int nmin = -1, nmax = 0;
+    for ( b = 0; b < NEIGHBORS_BINS; b++ )
+    {
+        hist[b] = 0;
+        for ( t = 0; t < (int)threadTimers.size(); t++ )
+            hist[b] += threadTimers[t].neighbors[b];
+        count += hist[b];
+        sum += hist[b] * b;
+        if ( hist[b] > 0 )
+        {
+            if ( nmin < 0 )
+                nmin = b;
+            nmax = b;
+        }
+    }
+    if ( count == 0 )
+        return;
+    printf( "pairs : neighbors per particle min %d, mean %.1f, max %d%s\n", 
+            nmin, (double)sum / count, nmax, 
+            (nmax == NEIGHBORS_BINS - 1) ? "+" : "");
+
+    FILE *file = fopen( neighborsName, "w");
+    if ( file == NULL )
+        return;
+    fprintf( file, "neighbors,particles\n");
+    for ( b = 0; b <= nmax; b++ )
+        fprintf( file, "%d,%.3f\n", b, (double)hist[b] / s);
+    fclose( file);
+
+    return;
+} // reportPairs
+
+// Start event of the timeline in the current thread.
+void
+Profiler::startEvent( int type)     // type of the event
+{
+    int thread = omp_get_thread_num();
+    if ( thread < (int)threadTimers.size() )
+        threadTimers[thread].eventStart[type] = omp_get_wtime();
+
+    return;
+} // startEvent
+
+// Stop event of the timeline in the current thread.
+void
+Profiler::stopEvent( int type,      // type of the event
+                     int phase,     // phase
+                     int arg)       // first particle, number of a file
+{
+    int thread = omp_get_thread_num();
+    if ( thread < (int)threadTimers.size() )
+        addEvent( thread, type, phase, arg, 
+                  threadTimers[thread].eventStart[type], omp_get_wtime());
+
+    return;
+} // stopEvent
+
+// Add event to the ring buffer of the thread, only the thread itself 
+// writes to its buffer, so no locking is needed. When the buffer is 
+// full the oldest events are overwritten.
+void
+Profiler::addEvent( int thread,     // thread
+                    int type,       // type of the event
+                    int phase,      // phase
+                    int arg,        // first particle, number of a file
+                    double start,   // start time
+                    double end)     // end time
+{
+    ThreadTimers &timers = threadTimers[thread];
+    TraceEvent &event = timers.events[timers.eventsNum % traceSize];
+    event.start = start;
+    event.end = end;
+    event.type = (short)type;
+    event.phase = (short)phase;
+    event.arg = arg;
+    timers.eventsNum++;
+
+    return;
+} // addEvent
+
+// Write timeline in Chrome trace format (it can be opened by 
+// chrome://tracing or Perfetto UI). Events are written as complete 
+// ("X") events with the time in microseconds from the start of 
+// the run, each OpenMP thread is a separate track.
+void
+Profiler::writeTrace()
+{
+    FILE *file = fopen( traceName, "w");
+    if ( file == NULL )
+    {
+        printf( "Can't write %s\n", traceName);
+        return;
+    }
+
+    fprintf( file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf( file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, "
+                   "\"args\": {\"name\": \"yaps_sim\"}}");
+    for ( int t = 0; t < (int)threadTimers.size(); t++ )
+    {
+        ThreadTimers &timers = threadTimers[t];
+        fprintf( file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", "
+                       "\"pid\": 0, \"tid\": %d, \"args\": {\"name\": "
+                       "\"thread %d\"}}", t, t);
+
+        // the oldest events kept are written first
+        long first = 0;
+        if ( timers.eventsNum > traceSize )
+        {
+            first = timers.eventsNum - traceSize;
+            printf( "trace : %ld oldest events of thread %d are lost, "
+                    "increase TRACE\n", first, t);
+        }
+        for ( long e = first; e < timers.eventsNum; e++ )
+        {
+            TraceEvent &event = timers.events[e % traceSize];
+            const char *name = eventNames[event.type];
+            if ( name == NULL )
+                name = phaseNames[event.phase];
+            fprintf( file, ",\n{\"name\": \"%s\", \"cat\": \"%s\", "
+                           "\"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                           "\"pid\": 0, \"tid\": %d", name, 
+                     eventCats[event.type], 
+                     1.0e6 * (event.start - runStart), 
+                     1.0e6 * (event.end - event.start), t);
+            if ( event.type == TRACE_CHUNK )
+                fprintf( file, ", \"args\": {\"first\": %d}", event.arg);
+            else if ( event.type == TRACE_WRITE )
+                fprintf( file, ", \"args\": {\"file\": %d}", event.arg);
+            else if ( event.type == TRACE_CHECKPOINT )
+                fprintf( file, ", \"args\": {\"step\": %d}", event.arg);
+            fprintf( file, "}");
+        }
+    }
+    fprintf( file, "\n]}\n");
+    fclose( file);
+
+    return;
+} // writeTrace
+
+// Returns total wall time of 'phase'.
+double
+Profiler::getPhaseTime( int phase)  // phase
+{
+    return phaseTime[phase];
+} // getPhaseTime
+
+// Returns peak resident set size of the process in KB (0 if unknown).
+long
+Profiler::getPeakRSS()
+{
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage) )
+        return 0;
+    return usage.ru_maxrss;
+#endif
+} // getPeakRSS
+
+// Print summary of the run and write it in CSV and JSON formats. 
+// For each phase its wall time and the minimum and maximum time 
+// spent in it by a thread are given (for serial phases they are 
+// equal to the wall time), and throughput of the simulation is 
+// given in particle updates per second.
+void
+Profiler::report()
+{
+    double tmin[PHASES_NUM], tmax[PHASES_NUM];
+    double total = omp_get_wtime() - runStart;
+    double compute = 0.0;
+    int p, t;
+
+    // spread between threads
+    for ( p = 0; p < PHASES_NUM; p++ )
+    {
+        tmin[p] = tmax[p] = 0.0;
+        char parallel = 0;
+        for ( t = 0; t < (int)threadTimers.size(); t++ )
+            if ( threadTimers[t].time[p] > 0.0 )
+                parallel = 1;
+        for ( t = 0; parallel && t < (int)threadTimers.size(); t++ )
+        {
+            double time = threadTimers[t].time[p];
+            if ( t == 0 || time < tmin[p] )
+                tmin[p] = time;
+            if ( t == 0 || time > tmax[p] )
+                tmax[p] = time;
+        }
+        if ( !parallel )
+            tmin[p] = tmax[p] = phaseTime[p];
+        if ( p != PHASE_OUTPUT )
+            compute += phaseTime[p];
+    }
+
+    // throughput
+    double updates = (double)steps * particles.size();
+    double rate = (compute > 0.0) ? updates / compute : 0.0;
+    long rss = getPeakRSS();
+    int threads = (int)threadTimers.size();
+
+    // print
+    printf( "timing : %d steps, %d particles, %d threads, %.3f s, "
+            "%.3g particle updates/s, peak RSS %ld KB\n", steps, 
+            (int)particles.size(), threads, total, rate, rss);
+    for ( p = 0; p < PHASES_NUM; p++ )
+        printf( "timing : %-12s %10.3f s %5.1f %%  thread min/max "
+                "%.3f / %.3f s\n", phaseNames[p], phaseTime[p], 
+                (total > 0.0) ? 100.0 * phaseTime[p] / total : 0.0, 
+                tmin[p], tmax[p]);
+
+    // CSV
+    char ffname[32];
+    sprintf( ffname, "%s.csv", timingName);
+    FILE *file = fopen( ffname, "w");
+    if ( file != NULL )
+    {
+        fprintf( file, "phase,seconds,calls,thread_min,thread_max\n");
+        for ( p = 0; p < PHASES_NUM; p++ )
+            fprintf( file, "%s,%.6f,%d,%.6f,%.6f\n", phaseNames[p], 
+                     phaseTime[p], phaseCalls[p], tmin[p], tmax[p]);
+        fprintf( file, "total,%.6f,%d,,\n", total, steps);
+        fclose( file);
+    }
+
+    // JSON
+    sprintf( ffname, "%s.json", timingName);
+    file = fopen( ffname, "w");
+    if ( file != NULL )
+    {
+        fprintf( file, "{\n  \"steps\": %d,\n  \"particles\": %d,\n"
+                       "  \"bparticles\": %d,\n  \"threads\": %d,\n", 
+                 steps, (int)particles.size(), (int)bparticles.size(), 
+                 threads);
+        fprintf( file, "  \"seconds\": %.6f,\n  \"updates_per_second\": "
+                       "%.6g,\n  \"peak_rss_kb\": %ld,\n  \"phases\": {", 
+                 total, rate, rss);
+        for ( p = 0; p < PHASES_NUM; p++ )
+            fprintf( file, "%s\n    \"%s\": { \"seconds\": %.6f, "
+                           "\"calls\": %d, \"thread_min\": %.6f, "
+                           "\"thread_max\": %.6f }", p ? "," : "", 
+                     phaseNames[p], phaseTime[p], phaseCalls[p], 
+                     tmin[p], tmax[p]);
+        fprintf( file, "\n  }\n}\n");
+        fclose( file);
+    }
+
+    // pairs
+    if ( pairsFile != NULL )
+    {
+        fclose( pairsFile);
+        pairsFile = NULL;
+    }
+    reportPairs();
+
+    // hardware counters
+    if ( countersOn )
+    {
+        reportCounters();
+#pragma omp parallel
+        closeCounters();
+    }
+
+    // timeline
+    if ( tracing )
+    {
+        writeTrace();
+        for ( t = 0; t < (int)threadTimers.size(); t++ )
+        {
+            delete [] threadTimers[t].events;
+            threadTimers[t].events = NULL;
+        }
+        tracing = 0;
+    }
+
+    return;
+} // report
+
+// Open performance counters of the current thread as a group led by 
+// the cycles counter, the counters which can't be opened (they aren't 
+// supported or aren't permitted) are skipped. Only user space of this 
+// thread is counted.
+void
+Profiler::openCounters()
+{
+    int thread = omp_get_thread_num();
+    if ( thread >= (int)threadTimers.size() )
+        return;
+    ThreadTimers &timers = threadTimers[thread];
+    timers.groupFd = -1;
+    timers.groupSize = 0;
+    timers.enabled = timers.running = 0;
+    for ( int c = 0; c < COUNTERS_NUM; c++ )
+        timers.fds[c] = timers.slot[c] = -1;
+
+#ifdef __linux__
+    static const unsigned int types[COUNTERS_NUM] = { 
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, 
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE };
+    static const unsigned long long configs[COUNTERS_NUM] = { 
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, 
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | 
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), 
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+
+    for ( int c = 0; c < COUNTERS_NUM; c++ )
+    {
+        struct perf_event_attr attr;
+        memset( &attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = types[c];
+        attr.config = configs[c];
+        attr.read_format = PERF_FORMAT_GROUP | 
+                           PERF_FORMAT_TOTAL_TIME_ENABLED | 
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = (timers.groupFd < 0) ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        int fd = (int)syscall( __NR_perf_event_open, &attr, 0, -1, 
+                               timers.groupFd, 0);
+        if ( fd < 0 )
+        {
+            // the group can't be created without the leader
+            if ( c == COUNTER_CYCLES )
+                return;
+            continue;
+        }
+        if ( timers.groupFd < 0 )
+            timers.groupFd = fd;
+        timers.fds[c] = fd;
+        timers.slot[c] = timers.groupSize++;
+    }
+    ioctl( timers.groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl( timers.groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+
+    return;
+} // openCounters
+
+// Read performance counters of the current thread into 'values' (raw 
+// counts followed by the time the group has been enabled and running, 
+// see READINGS_NUM), the counters which aren't available are read as 
+// zeros.
+void
+Profiler::readCounters( unsigned long long *values)   // readings
+{
+    int thread = omp_get_thread_num();
+    int c;
+
+    for ( c = 0; c < READINGS_NUM; c++ )
+        values[c] = 0;
+    if ( thread >= (int)threadTimers.size() )
+        return;
+    ThreadTimers &timers = threadTimers[thread];
+    if ( timers.groupFd < 0 )
+        return;
+
+#ifdef __linux__
+    // the number of counters, the time enabled and running, 
+    // and the values of the counters
+    unsigned long long buf[3 + COUNTERS_NUM];
+    if ( read( timers.groupFd, buf, sizeof(buf)) < 
+         (long)((3 + timers.groupSize) * sizeof(unsigned long long)) )
+        return;
+    values[READING_ENABLED] = buf[1];
+    values[READING_RUNNING] = buf[2];
+    for ( c = 0; c < COUNTERS_NUM; c++ )
+        if ( timers.slot[c] >= 0 )
+            values[c] = buf[3 + timers.slot[c]];
+#endif
+
+    return;
+} // readCounters
+
+// Add the counts between the readings 'start' and 'end' to 'counts'. 
+// If the group was multiplexed meanwhile, the raw counts are scaled 
+// by the ratio of the time it was enabled to the time it was running, 
+// nothing is added if it wasn't running at all.
+void
+Profiler::addCounts( ThreadTimers &timers,             // thread's timers
+                     unsigned long long *counts,       // counts
+                     const unsigned long long *start,  // start readings
+                     const unsigned long long *end)    // end readings
+{
+    unsigned long long delta[READINGS_NUM];
+    int c;
+
+    // a failed read gives zeros, so the readings could go back
+    for ( c = 0; c < READINGS_NUM; c++ )
+        delta[c] = (end[c] > start[c]) ? end[c] - start[c] : 0;
+    unsigned long long enabled = delta[READING_ENABLED];
+    unsigned long long running = delta[READING_RUNNING];
+    timers.enabled += enabled;
+    timers.running += running;
+    if ( running == 0 )
+        return;
+
+    double scale = (double)enabled / running;
+    for ( c = 0; c < COUNTERS_NUM; c++ )
+        counts[c] += (running < enabled) ? 
+                     (unsigned long long)(delta[c] * scale + 0.5) : delta[c];
+
+    return;
+} // addCounts
+
+// Close performance counters of the current thread.
+void
+Profiler::closeCounters()
+{
+    int thread = omp_get_thread_num();
+    if ( thread >= (int)threadTimers.size() )
+        return;
+    ThreadTimers &timers = threadTimers[thread];
+    if ( timers.groupFd < 0 )
+        return;
+
+#ifdef __linux__
+    for ( int c = 0; c < COUNTERS_NUM; c++ )
+        if ( timers.fds[c] >= 0 )
+            close( timers.fds[c]);
+#endif
+    timers.groupFd = -1;
+
+    return;
+} // closeCounters
+
+// Print counters' summary for each phase (IPC and misses per particle 
+// update) and write counters of each phase and each thread in CSV 
+// format. For parallel phases the counts are the sums of the threads' 
+// shares, for serial phases they are the master thread's counts. If 
+// the counters were multiplexed, the counts are estimates and the 
+// share of the time they were running is printed.
+void
+Profiler::reportCounters()
+{
+    unsigned long long total[COUNTERS_NUM];
+    int p, t, c;
+
+    char ffname[32];
+    sprintf( ffname, "%s_counters.csv", timingName);
+    FILE *file = fopen( ffname, "w");
+    if ( file != NULL )
+    {
+        fprintf( file, "phase,thread");
+        for ( c = 0; c < COUNTERS_NUM; c++ )
+            fprintf( file, ",%s", counterNames[c]);
+        fprintf( file, "\n");
+    }
+
+    // the least share of the time the counters were running
+    double running = 1.0;
+    for ( t = 0; t < (int)threadTimers.size(); t++ )
+        if ( threadTimers[t].groupFd >= 0 && threadTimers[t].enabled > 0 && 
+             threadTimers[t].running < threadTimers[t].enabled )
+            running = min( running, (double)threadTimers[t].running / 
+                                    threadTimers[t].enabled);
+    if ( running < 1.0 )
+        printf( "counters : multiplexed, running %.0f%% of the time, "
+                "counts are scaled\n", running * 100.0);
+
+    double updates = (double)steps * particles.size();
+    for ( p = 0; p < PHASES_NUM; p++ )
+    {
+        // the phase is parallel if the threads have counted it
+        char parallel = 0;
+        for ( t = 0; t < (int)threadTimers.size(); t++ )
+            if ( threadTimers[t].counts[p][COUNTER_CYCLES] > 0 )
+                parallel = 1;
+
+        for ( c = 0; c < COUNTERS_NUM; c++ )
+            total[c] = 0;
+        for ( t = 0; t < (int)threadTimers.size(); t++ )
+        {
+            const unsigned long long *counts = parallel ? 
+                threadTimers[t].counts[p] : threadTimers[t].masterCounts[p];
+            if ( !parallel && t > 0 )
+                break;
+            if ( file != NULL )
+                fprintf( file, "%s,%d", phaseNames[p], t);
+            for ( c = 0; c < COUNTERS_NUM; c++ )
+            {
+                total[c] += counts[c];
+                if ( file == NULL )
+                    continue;
+                if ( threadTimers[t].slot[c] >= 0 )
+                    fprintf( file, ",%llu", counts[c]);
+                else
+                    fprintf( file, ",");
+            }
+            if ( file != NULL )
+                fprintf( file, "\n");
+        }
+
+        if ( total[COUNTER_CYCLES] == 0 )
+            continue;
+        printf( "counters : %-12s IPC %5.2f", phaseNames[p], 
+                (double)total[COUNTER_INSTRUCTIONS] / total[COUNTER_CYCLES]);
+        for ( c = COUNTER_L1D_MISSES; c < COUNTERS_NUM; c++ )
+            if ( threadTimers[0].slot[c] >= 0 && updates > 0.0 )
+                printf( ", %s/update %.3g", counterNames[c], 
+                        total[c] / updates);
+        printf( "\n");
+    }
+
+    if ( file != NULL )
+        fclose( file);
+
+    return;
+} // reportCounters
\ No newline at end of file
@@ -0,0 +1,181 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_PROFILE_H
+#define YAPS_PROFILE_H
+
+#include "common.h"
+#include <cstdio>
+
+// Phases of a calculation step
+enum Phase
+{
+    PHASE_EOS,              // pressures
+    PHASE_FLUID,            // interactions between smoothing particles
+    PHASE_BOUNDARY,         // forces of boundary particles
+    PHASE_INTEGRATION,      // time integration
+    PHASE_NEIGHBORS,        // maintenance of neighbor structures
+    PHASE_OUTPUT,           // output files and checkpoints
+    PHASES_NUM
+};
+
+// Hardware performance counters
+enum Counter
+{
+    COUNTER_CYCLES,         // CPU cycles
+    COUNTER_INSTRUCTIONS,   // retired instructions
+    COUNTER_L1D_MISSES,     // L1 data cache read misses
+    COUNTER_LLC_MISSES,     // last level cache misses
+    COUNTER_BRANCH_MISSES,  // mispredicted branches
+    COUNTERS_NUM
+};
+
+// Readings of the counters - their raw values followed 
+// by the time the group has been enabled and running
+#define READING_ENABLED COUNTERS_NUM
+#define READING_RUNNING (COUNTERS_NUM + 1)
+#define READINGS_NUM    (COUNTERS_NUM + 2)
+
+// Number of bins of the histogram of neighbors per particle, 
+// the last bin counts the particles with more neighbors
+#define NEIGHBORS_BINS 512
+
+// Types of the events of the timeline
+enum TraceType
+{
+    TRACE_PHASE,            // phase (master thread)
+    TRACE_SHARE,            // thread's share of a parallel phase
+    TRACE_CHUNK,            // chunk of a parallel loop
+    TRACE_WRITE,            // output file
+    TRACE_CHECKPOINT,       // checkpoint
+    TRACE_TYPES
+};
+
+// Timers of the phases of the simulation. Wall time of a phase is 
+// measured by the master thread, and the time each thread spends in 
+// its share of a parallel phase is measured separately to show the 
+// spread between threads. If PERF_EVENTS is set, hardware performance 
+// counters of each thread are collected for the phases in the same 
+// way (perf_event_open, Linux only). If TRACE is set, the events of 
+// each thread are kept in its own ring buffer and written as a 
+// timeline in Chrome trace format at the end of the run. The pairs of 
+// particles checked and accepted by the pair loops are counted for 
+// each step to show how much of the work is wasted.
+class Profiler
+{
+
+public:
+
+    // names of the phases and the counters
+    static const char* phaseNames[];
+    static const char* counterNames[];
+
+    // initialize timers
+    static void init();
+    // start/stop phase (by the master thread outside of parallel region)
+    static void startPhase( int phase);
+    static void stopPhase( int phase);
+    // start/stop thread's share of phase (inside of parallel region)
+    static void startThread( int phase);
+    static void stopThread( int phase);
+    // start/stop event of the timeline, 'arg' is the first particle 
+    // of a chunk or the number of a file (use PROFILE_EVENT_* macros)
+    static void startEvent( int type);
+    static void stopEvent( int type, int phase, int arg);
+    // count pairs checked and accepted in the thread's share of phase
+    static void countPairs( int phase, long long checked, long long accepted);
+    // count particle with 'n' neighbors
+    static void countNeighbors( int n);
+    // count step
+    static void countStep();
+    // total wall time of phase
+    static double getPhaseTime( int phase);
+    // print and write summary
+    static void report();
+
+    // timeline is recorded
+    static char tracing;
+
+private:
+
+    // summary filename
+    static const char* timingName;
+
+    // timers of a thread
+    struct ThreadTimers;
+    static vector<ThreadTimers> threadTimers;
+    // wall time of the phases
+    static double phaseStart[PHASES_NUM];
+    static double phaseTime[PHASES_NUM];
+    static int    phaseCalls[PHASES_NUM];
+    // start of the run and number of steps performed
+    static double runStart;
+    static int    steps;
+    // performance counters are collected
+    static char countersOn;
+    // pairs checked and accepted during the run, 
+    // file with the pairs of each step
+    static long long pairsTotal[PHASES_NUM][2];
+    static FILE *pairsFile;
+
+    // peak resident set size of the process (KB)
+    static long getPeakRSS();
+    // open/read/close performance counters of the current thread
+    static void openCounters();
+    static void readCounters( unsigned long long *values);
+    // add the counts between two readings
+    static void addCounts( ThreadTimers &timers, unsigned long long *counts, 
+                           const unsigned long long *start, 
+                           const unsigned long long *end);
+    static void closeCounters();
+    // write counters' summary
+    static void reportCounters();
+    // write pairs' summary and histogram of neighbors
+    static void reportPairs();
+
+    // event of the timeline
+    struct TraceEvent;
+    // number of events kept per thread
+    static int traceSize;
+    // add event to the ring buffer of the thread
+    static void addEvent( int thread, int type, int phase, int arg, 
+                          double start, double end);
+    // write timeline
+    static void writeTrace();
+
+};
+
+// Timers are compiled in only if YAPS_TIME is defined
+#ifdef YAPS_TIME
+#define PROFILE_INIT()              Profiler::init()
+#define PROFILE_START( phase)       Profiler::startPhase( phase)
+#define PROFILE_STOP( phase)        Profiler::stopPhase( phase)
+#define PROFILE_THREAD_START( phase) Profiler::startThread( phase)
+#define PROFILE_THREAD_STOP( phase) Profiler::stopThread( phase)
+#define PROFILE_STEP()              Profiler::countStep()
+#define PROFILE_REPORT()            Profiler::report()
+#define PROFILE_EVENT_START( type)  \
+    (Profiler::tracing ? Profiler::startEvent( type) : (void)0)
+#define PROFILE_EVENT_STOP( type, phase, arg) \
+    (Profiler::tracing ? Profiler::stopEvent( type, phase, arg) : (void)0)
+#define PROFILE_PAIRS( phase, checked, accepted) \
+    Profiler::countPairs( phase, checked, accepted)
+#define PROFILE_NEIGHBORS( n)       Profiler::countNeighbors( n)
+#else
+#define PROFILE_INIT()
+#define PROFILE_START( phase)
+#define PROFILE_STOP( phase)
+#define PROFILE_THREAD_START( phase)
+#define PROFILE_THREAD_STOP( phase)
+#define PROFILE_STEP()
+#define PROFILE_REPORT()
+#define PROFILE_EVENT_START( type)
+#define PROFILE_EVENT_STOP( type, phase, arg)
+#define PROFILE_PAIRS( phase, checked, accepted) \
+    ((void)(checked), (void)(accepted))
+#define PROFILE_NEIGHBORS( n)       ((void)(n))
+#endif
+
+#endif // YAPS_PROFILE_H
\ No newline at end of file
@@ -1,378 +1,1084 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#include "render.h"
-#include "opengl.h"
-#include "iobin.h"
-#include "common.h"
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-using namespace std;
-
-// RGB colors for rendering
-// smoothing particles
-const float Render::particleColor[2][3]  = { { 0.0f, 0.4f, 0.6f },
-                                             { 0.0f, 0.2f, 0.4f } };
-// background
-const float Render::backgroundColor[3]   = { 0.7f, 0.7f, 0.7f };
-// segments
-const float Render::segmentColor[3]      = { 0.0f, 0.0f, 0.0f };
-// triangles' edges
-const float Render::triangleLineColor[3] = { 0.0f, 0.0f, 0.0f };
-// triangles' interiors
-const float Render::triangleFillColor[4] = { 0.6f, 0.6f, 0.6f, 0.7f };
-
-// display list(s) numbers
-const int Render::obstacles_list = 1;
-
-// default size of the window
-const int Render::windowWidth  = 800;
-const int Render::windowHeight = 800;
-
-// current time step
-int Render::nfile = 0;
-
-// Constructor.
-Render::Render( int argc, char **argv)
-{
-    // initialize GLUT
-    glutInit( &argc, argv);
-    glutInitDisplayMode( GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH);
-    
-    // create window
-    glutInitWindowSize( windowWidth, windowHeight);
-    glutCreateWindow( argv[0]);
-    char title[20];
-    sprintf( title, "%s - %05d", "YAPS", nfile);
-    glutSetWindowTitle( title);
-    
-    // initialize GL capabilities
-    initGLCapabilities();
-    
-    // initialize display lists
-    initDisplayLists();
-    
-    // register callbacks for current window
-    glutDisplayFunc( displayCallback);
-    glutReshapeFunc( reshapeCallback);
-    glutKeyboardFunc( keyboardCallback);
-    glutSpecialFunc( specialFuncCallback);
-    glutMouseFunc( mouseFuncCallback);
-    glutMotionFunc( mouseMotionCallback);
-} // Render
-
-// Run renderer.
-void 
-Render::run()
-{
-    // main loop
-    glutMainLoop();
-} // run
-
-// Initialize OpenGL capabilities.
-void
-Render::initGLCapabilities()
-{
-    // turn on antialiasing for lines
-    glEnable( GL_LINE_SMOOTH);
-    glHint( GL_LINE_SMOOTH_HINT, GL_NICEST);
-    
-    // turn on Z-Buffer
-    glEnable( GL_DEPTH_TEST);
-    glDepthFunc( GL_LEQUAL);
-
-    // turn on blending
-    glEnable( GL_BLEND);
-    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    return;
-} // initGLCapabilities
-
-// Initialize display list(s).
-void
-Render::initDisplayLists( void)
-{
-    // initialize obstacles_list
-    glNewList( obstacles_list, GL_COMPILE);
-
-    if ( dimension == 2 )
-    {
-        // draw segments
-        glBegin( GL_LINES);
-        for ( int i = 0; i < (int)obstacles.size(); i++ )
-        {
-            glColor3fv( segmentColor);
-            glVertex3fv( obstacles[i].vrtx1);
-            glVertex3fv( obstacles[i].vrtx2);
-        }
-        glEnd();
-    }
-    else if ( dimension == 3 )
-    {
-        // draw triangles' edges
-        glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
-        glBegin( GL_TRIANGLES);
-        for ( int i = 0; i < (int)obstacles.size(); i++ )
-        {
-            glColor3fv( triangleLineColor);
-            glVertex3fv( obstacles[i].vrtx1);
-            glVertex3fv( obstacles[i].vrtx2);
-            glVertex3fv( obstacles[i].vrtx3);
-        }
-        glEnd();
-
-        // fill triangles' interiors
-        glPolygonMode( GL_FRONT_AND_BACK, GL_FILL);
-        // if it is transparent - turn off depth test
-        if ( triangleFillColor[3] < 1.0f )
-            glDepthMask( GL_FALSE);
-        glBegin( GL_TRIANGLES);
-        for ( int i = 0; i < (int)obstacles.size(); i++ )
-        {
-            glColor4fv( triangleFillColor);
-            glVertex3fv( obstacles[i].vrtx1);
-            glVertex3fv( obstacles[i].vrtx2);
-            glVertex3fv( obstacles[i].vrtx3);
-        }
-        glEnd();
-        // turn on depth test if it was turned off
-        if ( triangleFillColor[3] < 1.0f )
-            glDepthMask( GL_TRUE);
-    }
-
-    // end of obstacles_list
-    glEndList();
-    
-    return;
-} // initDisplayLists
-
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//                   GLUT CALLBACKS
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-
-// GLUT display callback.
-void
-Render::displayCallback()
-{
-    // clear the buffers
-    glClearColor( backgroundColor[0],
-                  backgroundColor[1],
-                  backgroundColor[2],
-                  1.0f);
-    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    // draw the particles
-    for ( int i = 0; i < (int)particles.size(); i++ )
-    {
-        glPushMatrix();
-        glTranslatef( particles[i].pos[0], 
-                      particles[i].pos[1], 
-                      particles[i].pos[2]);
-        glColor3fv( particleColor[particles[i].no-1]);
-        glutSolidSphere( parameters.particlesRadius, 20, 20);
-        glPopMatrix();
-    }
-
-    // draw the obstacles
-    glCallList( obstacles_list);
-
-    // swap the buffers
-    glutSwapBuffers();
-    
-    return;
-} // displayCallback
-
-// GLUT reshape callback.
-void
-Render::reshapeCallback( int width,   // window's width
-                         int height)  // window's height
-{
-    float clipVolume = parameters.clipVolume;
-
-    // it's not allowed to change the size of the window
-    glutReshapeWindow( windowWidth, windowHeight);
-    glViewport( 0, 0, windowWidth, windowHeight);
-
-    // set projection matrix
-    glMatrixMode( GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho( 0.0f, clipVolume, 0.0f, clipVolume, 
-             -clipVolume * 4.0f, clipVolume * 3.0f);
-    glMatrixMode( GL_MODELVIEW);
-    
-    return;
-} // reshapeCallback
-
-// GLUT keyboard callback.
-void
-Render::keyboardCallback( unsigned char key,   // key's code
-                          int x,               // position of
-                          int y)               // the mouse
-{
-    char title[20];
-
-    switch (key) {
-      case 'n':
-          // read next file and redisplay
-          if ( IOBin().readData( nfile + 1) == 0 )
-          {
-              nfile++;
-              sprintf( title, "%s - %05d", "YAPS", nfile);
-              glutSetWindowTitle( title);
-              //glutPostRedisplay();
-              displayCallback();
-          }
-          break;
-      case 'p':
-          // read previous file and redisplay
-          if ( IOBin().readData( nfile - 1) == 0 )
-          {
-              nfile--;
-              sprintf( title, "%s - %05d", "YAPS", nfile);
-              glutSetWindowTitle( title);
-              //glutPostRedisplay();
-              displayCallback();
-          }
-          break;
-      case 'q':
-          // exit the program
-          exit( 0);
-      default:
-        break;
-    }
-
-    return;
-} // keyboardCallback
-
-// scaling/rotation steps
-const float Render::scaleStep    = 0.05f;
-const float Render::xRotateStep  = 1.0f;
-const float Render::yRotateStep  = 1.0f;
-const float Render::xyRotateMult = 0.1f;
-// current scaling/rotation factors
-float Render::scaleFactor   = 1.0f;
-float Render::xRotateFactor = 0.0f;
-float Render::yRotateFactor = 0.0f;
-
-// GLUT special functions callback.
-void
-Render::specialFuncCallback( int key,   // key's code
-                             int x,     // position of
-                             int y)     // the mouse
-{
-
-    switch (key) {
-      case GLUT_KEY_UP:
-          xRotateFactor += xRotateStep;
-          break;
-      case GLUT_KEY_DOWN:
-          xRotateFactor -= xRotateStep;
-          break;
-      case GLUT_KEY_LEFT:
-          yRotateFactor += yRotateStep;
-          break;
-      case GLUT_KEY_RIGHT:
-          yRotateFactor -= yRotateStep;
-          break;
-      case GLUT_KEY_PAGE_UP:
-          scaleFactor += scaleStep;
-          break;
-      case GLUT_KEY_PAGE_DOWN:
-          scaleFactor -= scaleStep;
-          break;
-      default:
-          return;
-          break;
-    }
-
-    scaleRotateFunc();
-
-    return;
-} // specialFuncCallback
-
-// current mouse button and position
-int Render::x0 = -1;
-int Render::y0 = -1;
-int Render::curButton = -1;
-
-// GLUT mouse button callback.
-void
-Render::mouseFuncCallback( int button, int state, int x, int y)
-{
-
-    // save pressed button and position
-    curButton = button;
-    x0 = x;
-    y0 = y;
-
-    // scaling
-    switch (curButton) {
-      case 3:
-          scaleFactor += scaleStep;
-          break;
-      case 4:
-          scaleFactor -= scaleStep;
-          break;
-      default:
-          return;
-          break;
-    }
-
-    // redraw
-    scaleRotateFunc();
-
-    return;
-} // mouseFuncCallback
-
-// GLUT mouse motion callback.
-void
-Render::mouseMotionCallback( int x, int y)
-{
-    // rotation
-    switch (curButton) {
-      case GLUT_LEFT_BUTTON:
-          yRotateFactor -= xyRotateMult * (x0 - x);
-          xRotateFactor -= xyRotateMult * (y0 - y);
-          x0 = x;
-          y0 = y;
-          break;
-      default:
-          return;
-          break;
-    }
-     
-    // redraw
-    scaleRotateFunc();
-
-    return;
-} // mouseMotionCallback
-
-// Rotate and scale and redraw.
-void
-Render::scaleRotateFunc()
-{
-    glLoadIdentity();
-
-    float clipVolume = parameters.clipVolume;
-
-    // set the center of rotation
-    glTranslatef( clipVolume / 2.0f, clipVolume / 2.0f, clipVolume / 2.0f);
-    // rotate the scene along X-axis
-    glRotatef( xRotateFactor, 1.0, 0.0, 0.0);
-    // rotate the scene along Y-axis
-    glRotatef( yRotateFactor, 0.0, 1.0, 0.0);
-    // scale the scene
-    if ( scaleFactor < scaleStep )
-        scaleFactor = scaleStep;
-    glScalef( scaleFactor, scaleFactor, scaleFactor);
-    // restore the origin
-    glTranslatef( -clipVolume / 2.0f, -clipVolume / 2.0f, -clipVolume / 2.0f);
-    
-    // redisplay the scene
-    glutPostRedisplay();
-
-    return;
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "render.h"
+#include "opengl.h"
+#include "iobin.h"
+#include "framecache.h"
+#include "interp.h"
+#include "surface.h"
+#include "framering.h"
+#include "common.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <omp.h>
+using namespace std;
+
+// RGB colors for rendering
+// smoothing particles
+const float Render::particleColor[2][3]  = { { 0.0f, 0.4f, 0.6f },
+                                             { 0.0f, 0.2f, 0.4f } };
+// background
+const float Render::backgroundColor[3]   = { 0.7f, 0.7f, 0.7f };
+// segments
+const float Render::segmentColor[3]      = { 0.0f, 0.0f, 0.0f };
+// triangles' edges
+const float Render::triangleLineColor[3] = { 0.0f, 0.0f, 0.0f };
+// triangles' interiors
+const float Render::triangleFillColor[4] = { 0.6f, 0.6f, 0.6f, 0.7f };
+
+// display list(s) numbers
+const int Render::obstacles_list = 1;
+
+// size of the texture to draw particles as point sprites
+const int Render::spriteSize = 64;
+
+// default size of the window
+const int Render::windowWidth  = 800;
+const int Render::windowHeight = 800;
+
+// current time step
+int Render::nfile = 0;
+// particles of the current file
+const Particles* Render::frame = &particles;
+
+// interpolation between files is off by default
+char Render::interpMode = 0;
+int Render::frameSteps = 1;
+int Render::subStep = 0;
+Particles Render::interpFrame;
+
+// live frames
+char Render::live = 0;
+long long Render::liveFrame = -1;
+Particles Render::liveParticles;
+
+// playback
+char Render::playing = 0;
+int Render::timerRun = 0;
+int Render::direction = 1;
+int Render::playFrame = 0;
+double Render::playTime = 0.0;
+int Render::framesShown = 0;
+int Render::framesDropped = 0;
+double Render::statTime = 0.0;
+
+// particles are drawn as point sprites by default
+char Render::drawSprites = 1;
+char Render::particlesChanged = 1;
+unsigned int Render::spriteTexture = 0;
+unsigned int Render::vertexBuffer = 0;
+float* Render::vertexData = NULL;
+int Render::vertexDataSize = 0;
+CellGrid Render::frameGrid;
+vector<int> Render::drawFirst;
+vector<int> Render::drawCount;
+char Render::interacting = 0;
+char Render::drawSurface = 0;
+int Render::surfFile = -1;
+vector<float> Render::surfVerts;
+vector<float> Render::surfNormals;
+vector<int> Render::surfElems;
+
+// Constructor.
+Render::Render( int argc, char **argv)
+{
+    // initialize GLUT
+    glutInit( &argc, argv);
+    glutInitDisplayMode( GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH);
+    
+    // create window
+    glutInitWindowSize( windowWidth, windowHeight);
+    glutCreateWindow( argv[0]);
+    char title[20];
+    sprintf( title, "%s - %05d", "YAPS", nfile);
+    glutSetWindowTitle( title);
+    
+    // initialize GL capabilities
+    initGLCapabilities();
+    
+    // initialize display lists
+    initDisplayLists();
+
+    // initialize point sprites
+    initSprites();
+    
+    // register callbacks for current window
+    glutDisplayFunc( displayCallback);
+    glutReshapeFunc( reshapeCallback);
+    glutKeyboardFunc( keyboardCallback);
+    glutSpecialFunc( specialFuncCallback);
+    glutMouseFunc( mouseFuncCallback);
+    glutMotionFunc( mouseMotionCallback);
+
+    // initialize cache of frames
+    size_t cacheSize = (parameters.cacheSize > 0) ? 
+                       parameters.cacheSize : 512;
+    FrameCache::init( cacheSize << 20);
+} // Render
+
+// Run renderer. The main loop runs in the master thread, and 
+// another thread (if it's available) prefetches frames.
+void 
+Render::run()
+{
+#pragma omp parallel num_threads(2)
+    {
+        if ( omp_get_thread_num() == 0 )
+        {
+            // main loop
+            glutMainLoop();
+        }
+        else
+        {
+            // background loader
+            FrameCache::loaderLoop();
+        }
+    }
+} // run
+
+// Initialize OpenGL capabilities.
+void
+Render::initGLCapabilities()
+{
+    // turn on antialiasing for lines
+    glEnable( GL_LINE_SMOOTH);
+    glHint( GL_LINE_SMOOTH_HINT, GL_NICEST);
+    
+    // turn on Z-Buffer
+    glEnable( GL_DEPTH_TEST);
+    glDepthFunc( GL_LEQUAL);
+
+    // turn on blending
+    glEnable( GL_BLEND);
+    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    return;
+} // initGLCapabilities
+
+// Initialize texture of point sprites - it's a shaded sphere (impostor), 
+// the points outside of the sphere are transparent and are cut off by 
+// the alpha test. The color of the particle modulates the texture.
+void
+Render::initSprites()
+{
+    unsigned char *texture;
+    float x, y, z;
+    int i, j;
+
+    // luminance and alpha
+    texture = new unsigned char[spriteSize * spriteSize * 2];
+    for ( i = 0; i < spriteSize; i++ )
+    {
+        for ( j = 0; j < spriteSize; j++ )
+        {
+            x = 2.0f * (j + 0.5f) / spriteSize - 1.0f;
+            y = 2.0f * (i + 0.5f) / spriteSize - 1.0f;
+            z = 1.0f - x * x - y * y;
+            unsigned char *texel = texture + 2 * (i * spriteSize + j);
+            if ( z < 0.0f )
+            {
+                texel[0] = 0;
+                texel[1] = 0;
+                continue;
+            }
+            // diffuse lighting from the upper left
+            z = sqrt( z);
+            float light = 0.35f + 0.65f * (-0.3f * x + 0.3f * y + 0.9f * z);
+            if ( light > 1.0f )
+                light = 1.0f;
+            texel[0] = (unsigned char)(255.0f * light);
+            texel[1] = 255;
+        }
+    }
+
+    glGenTextures( 1, &spriteTexture);
+    glBindTexture( GL_TEXTURE_2D, spriteTexture);
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, spriteSize, 
+                  spriteSize, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, 
+                  texture);
+    glBindTexture( GL_TEXTURE_2D, 0);
+    delete [] texture;
+
+#ifdef YAPS_GL_VBO
+    glGenBuffers( 1, &vertexBuffer);
+#endif
+
+    return;
+} // initSprites
+
+// Initialize display list(s).
+void
+Render::initDisplayLists( void)
+{
+    // initialize obstacles_list
+    glNewList( obstacles_list, GL_COMPILE);
+
+    if ( dimension == 2 )
+    {
+        // draw segments
+        glBegin( GL_LINES);
+        for ( int i = 0; i < (int)obstacles.size(); i++ )
+        {
+            glColor3fv( segmentColor);
+            glVertex3fv( obstacles[i].vrtx1);
+            glVertex3fv( obstacles[i].vrtx2);
+        }
+        glEnd();
+    }
+    else if ( dimension == 3 )
+    {
+        // draw triangles' edges
+        glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
+        glBegin( GL_TRIANGLES);
+        for ( int i = 0; i < (int)obstacles.size(); i++ )
+        {
+            glColor3fv( triangleLineColor);
+            glVertex3fv( obstacles[i].vrtx1);
+            glVertex3fv( obstacles[i].vrtx2);
+            glVertex3fv( obstacles[i].vrtx3);
+        }
+        glEnd();
+
+        // fill triangles' interiors
+        glPolygonMode( GL_FRONT_AND_BACK, GL_FILL);
+        // if it is transparent - turn off depth test
+        if ( triangleFillColor[3] < 1.0f )
+            glDepthMask( GL_FALSE);
+        glBegin( GL_TRIANGLES);
+        for ( int i = 0; i < (int)obstacles.size(); i++ )
+        {
+            glColor4fv( triangleFillColor);
+            glVertex3fv( obstacles[i].vrtx1);
+            glVertex3fv( obstacles[i].vrtx2);
+            glVertex3fv( obstacles[i].vrtx3);
+        }
+        glEnd();
+        // turn on depth test if it was turned off
+        if ( triangleFillColor[3] < 1.0f )
+            glDepthMask( GL_TRUE);
+    }
+
+    // end of obstacles_list
+    glEndList();
+    
+    return;
+} // initDisplayLists
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//                   GLUT CALLBACKS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// GLUT display callback.
+void
+Render::displayCallback()
+{
+    // clear the buffers
+    glClearColor( backgroundColor[0],
+                  backgroundColor[1],
+                  backgroundColor[2],
+                  1.0f);
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // draw the surface or the visible particles
+    if ( drawSurface && updateSurface() == 0 )
+    {
+        drawSurfaceMesh();
+    }
+    else
+    {
+        updateFrameData();
+        int decim = findVisibleCells();
+        if ( drawSprites )
+            drawParticlesAsSprites( decim);
+        else
+            drawParticlesAsSpheres( decim);
+    }
+
+    // draw the obstacles
+    glCallList( obstacles_list);
+
+    // swap the buffers
+    glutSwapBuffers();
+    
+    return;
+} // displayCallback
+
+// Update data of the current frame if it has been changed - particles 
+// are sorted into cells of the grid (in random order inside each cell, 
+// so that any leading part of the cell is a representative subset of 
+// it), and their positions and colors are uploaded to the vertex buffer 
+// in this order.
+void
+Render::updateFrameData()
+{
+    const Particles &prts = *frame;
+    int n = (int)prts.size();
+    int c, i, j;
+
+    if ( !particlesChanged )
+        return;
+    particlesChanged = 0;
+    drawFirst.clear();
+    drawCount.clear();
+    if ( n == 0 )
+        return;
+
+    // there are about 64 particles in a cell of the fluid at rest
+    float cellSize = parameters.particlesDistrib * 
+                     ((dimension == 3) ? 4.0f : 8.0f);
+    if ( cellSize <= 0.0f )
+        cellSize = parameters.clipVolume / 64.0f;
+    frameGrid.build( prts[0].pos, sizeof(struct Particle) / sizeof(float), 
+                     n, cellSize);
+
+    // shuffle particles inside cells
+    vector<int> &index = frameGrid.index;
+    unsigned int seed = 12345;
+    for ( c = 0; c < frameGrid.cellsNum; c++ )
+    {
+        for ( i = frameGrid.cellStart[c + 1] - 1; 
+              i > frameGrid.cellStart[c]; i-- )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            j = frameGrid.cellStart[c] + 
+                (int)((seed >> 8) % (unsigned int)(i - frameGrid.cellStart[c] + 1));
+            int tmp = index[i];
+            index[i] = index[j];
+            index[j] = tmp;
+        }
+    }
+
+    // fill vertex data (x, y, z, r, g, b)
+    if ( n > vertexDataSize )
+    {
+        delete [] vertexData;
+        vertexData = new float[6 * n];
+        vertexDataSize = n;
+    }
+    for ( i = 0; i < n; i++ )
+    {
+        const Particle &prt = prts[index[i]];
+        memcpy( vertexData + 6 * i, prt.pos, 3 * sizeof(float));
+        memcpy( vertexData + 6 * i + 3, particleColor[prt.no-1], 
+                3 * sizeof(float));
+    }
+#ifdef YAPS_GL_VBO
+    glBindBuffer( GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData( GL_ARRAY_BUFFER, 6 * n * sizeof(float), 
+                  vertexData, GL_STREAM_DRAW);
+    glBindBuffer( GL_ARRAY_BUFFER, 0);
+#endif
+
+    return;
+} // updateFrameData
+
+// Find the cells of the grid which are inside the clipping volume with 
+// the current view, and set the ranges of the vertex buffer to draw. 
+// While the view is being changed by the mouse, only the leading part 
+// of each cell is drawn to keep the number of particles within 
+// LOD_BUDGET. The function returns the decimation factor.
+int
+Render::findVisibleCells()
+{
+    float clipVolume = parameters.clipVolume;
+    float margin = parameters.particlesRadius;
+    float lower[3], upper[3];
+    float win[3], wmin[3], wmax[3];
+    float m[16];
+    int visibleNum;
+    int c, k, d;
+
+    drawFirst.clear();
+    drawCount.clear();
+    if ( frame->empty() )
+        return 1;
+
+    // current modelview matrix
+    glGetFloatv( GL_MODELVIEW_MATRIX, m);
+
+    // cull cells
+    vector<int> visible;
+    visibleNum = 0;
+    for ( c = 0; c < frameGrid.cellsNum; c++ )
+    {
+        if ( frameGrid.cellStart[c + 1] == frameGrid.cellStart[c] )
+            continue;
+        frameGrid.getCellBounds( c, lower, upper);
+        // bounds of the cell in eye coordinates
+        for ( k = 0; k < 8; k++ )
+        {
+            float x = (k & 1) ? upper[0] + margin : lower[0] - margin;
+            float y = (k & 2) ? upper[1] + margin : lower[1] - margin;
+            float z = (k & 4) ? upper[2] + margin : lower[2] - margin;
+            for ( d = 0; d < 3; d++ )
+            {
+                win[d] = m[d] * x + m[4 + d] * y + m[8 + d] * z + m[12 + d];
+                if ( k == 0 || win[d] < wmin[d] )
+                    wmin[d] = win[d];
+                if ( k == 0 || win[d] > wmax[d] )
+                    wmax[d] = win[d];
+            }
+        }
+        // clipping volume (see reshapeCallback)
+        if ( wmax[0] < 0.0f || wmin[0] > clipVolume ||
+             wmax[1] < 0.0f || wmin[1] > clipVolume ||
+             wmax[2] < -clipVolume * 3.0f || wmin[2] > clipVolume * 4.0f )
+            continue;
+        visible.push_back( c);
+        visibleNum += frameGrid.cellStart[c + 1] - frameGrid.cellStart[c];
+    }
+
+    // decimation factor
+    int budget = (parameters.lodBudget > 0) ? parameters.lodBudget : 200000;
+    int decim = 1;
+    if ( interacting && visibleNum > budget )
+        decim = (visibleNum + budget - 1) / budget;
+
+    // ranges to draw, adjacent ranges are merged
+    for ( k = 0; k < (int)visible.size(); k++ )
+    {
+        int first = frameGrid.cellStart[visible[k]];
+        int count = frameGrid.cellStart[visible[k] + 1] - first;
+        count = (count + decim - 1) / decim;
+        if ( !drawFirst.empty() && 
+             drawFirst.back() + drawCount.back() == first )
+        {
+            drawCount.back() += count;
+            continue;
+        }
+        drawFirst.push_back( first);
+        drawCount.push_back( count);
+    }
+
+    return decim;
+} // findVisibleCells
+
+// Draw the visible particles as spheres, 'decim' is the decimation factor.
+void
+Render::drawParticlesAsSpheres( int decim)
+{
+    const Particles &prts = *frame;
+    const vector<int> &index = frameGrid.index;
+
+    // spheres are enlarged to compensate decimation
+    float radius = parameters.particlesRadius * 
+                   pow( (float)decim, 1.0f / dimension);
+
+    for ( int k = 0; k < (int)drawFirst.size(); k++ )
+    {
+        for ( int i = drawFirst[k]; i < drawFirst[k] + drawCount[k]; i++ )
+        {
+            const Particle &prt = prts[index[i]];
+            glPushMatrix();
+            glTranslatef( prt.pos[0], 
+                          prt.pos[1], 
+                          prt.pos[2]);
+            glColor3fv( particleColor[prt.no-1]);
+            glutSolidSphere( radius, 20, 20);
+            glPopMatrix();
+        }
+    }
+
+    return;
+} // drawParticlesAsSpheres
+
+// Draw the visible particles as point sprites textured with a shaded 
+// sphere, 'decim' is the decimation factor. Positions and colors of the 
+// particles have been uploaded to the vertex buffer already, ranges of 
+// the buffer are drawn by one call each.
+void
+Render::drawParticlesAsSprites( int decim)
+{
+    if ( drawFirst.empty() )
+        return;
+
+    // size of the sprites in pixels, sprites 
+    // are enlarged to compensate decimation
+    float range[2];
+    float size = 2.0f * parameters.particlesRadius * scaleFactor * 
+                 windowWidth / parameters.clipVolume * 
+                 pow( (float)decim, 1.0f / dimension);
+    glGetFloatv( GL_ALIASED_POINT_SIZE_RANGE, range);
+    if ( size < range[0] )
+        size = range[0];
+    if ( size > range[1] )
+        size = range[1];
+    glPointSize( size);
+
+    // turn on point sprites
+    glEnable( GL_TEXTURE_2D);
+    glBindTexture( GL_TEXTURE_2D, spriteTexture);
+    glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glEnable( GL_POINT_SPRITE);
+    glTexEnvi( GL_POINT_SPRITE, GL_COORD_REPLACE, GL_TRUE);
+    glEnable( GL_ALPHA_TEST);
+    glAlphaFunc( GL_GREATER, 0.5f);
+
+    // draw
+    glEnableClientState( GL_VERTEX_ARRAY);
+    glEnableClientState( GL_COLOR_ARRAY);
+#ifdef YAPS_GL_VBO
+    glBindBuffer( GL_ARRAY_BUFFER, vertexBuffer);
+    glVertexPointer( 3, GL_FLOAT, 6 * sizeof(float), (void *)0);
+    glColorPointer( 3, GL_FLOAT, 6 * sizeof(float), 
+                    (void *)(3 * sizeof(float)));
+#else
+    glVertexPointer( 3, GL_FLOAT, 6 * sizeof(float), vertexData);
+    glColorPointer( 3, GL_FLOAT, 6 * sizeof(float), vertexData + 3);
+#endif
+    for ( int k = 0; k < (int)drawFirst.size(); k++ )
+        glDrawArrays( GL_POINTS, drawFirst[k], drawCount[k]);
+#ifdef YAPS_GL_VBO
+    glBindBuffer( GL_ARRAY_BUFFER, 0);
+#endif
+    glDisableClientState( GL_COLOR_ARRAY);
+    glDisableClientState( GL_VERTEX_ARRAY);
+
+    // turn off point sprites
+    glDisable( GL_ALPHA_TEST);
+    glDisable( GL_POINT_SPRITE);
+    glBindTexture( GL_TEXTURE_2D, 0);
+    glDisable( GL_TEXTURE_2D);
+
+    return;
+} // drawParticlesAsSprites
+
+// Read the surface of the current file if it hasn't been read yet, 
+// normals of the vertices are averaged normals of the triangles. The 
+// function returns 0 if succeeded and 1 if there is no valid surface file.
+int
+Render::updateSurface()
+{
+    int i, k, d;
+
+    if ( surfFile == nfile )
+        return 0;
+
+    surfFile = -1;
+    if ( Surface::readSurface( nfile, surfVerts, surfElems) )
+        return 1;
+    surfFile = nfile;
+
+    // normals (triangles' areas are weights)
+    surfNormals.assign( surfVerts.size(), 0.0f);
+    if ( dimension != 3 )
+        return 0;
+    for ( i = 0; i + 2 < (int)surfElems.size(); i += 3 )
+    {
+        const float *v0 = &surfVerts[3 * surfElems[i]];
+        const float *v1 = &surfVerts[3 * surfElems[i + 1]];
+        const float *v2 = &surfVerts[3 * surfElems[i + 2]];
+        float a[3], b[3], norm[3];
+        for ( d = 0; d < 3; d++ )
+        {
+            a[d] = v1[d] - v0[d];
+            b[d] = v2[d] - v0[d];
+        }
+        norm[0] = a[1] * b[2] - a[2] * b[1];
+        norm[1] = a[2] * b[0] - a[0] * b[2];
+        norm[2] = a[0] * b[1] - a[1] * b[0];
+        for ( k = 0; k < 3; k++ )
+            for ( d = 0; d < 3; d++ )
+                surfNormals[3 * surfElems[i + k] + d] += norm[d];
+    }
+
+    return 0;
+} // updateSurface
+
+// Draw the surface of the current file - lit triangles in 3D 
+// simulation and segments in 2D one.
+void
+Render::drawSurfaceMesh()
+{
+    if ( surfElems.empty() )
+        return;
+
+    glEnableClientState( GL_VERTEX_ARRAY);
+    glVertexPointer( 3, GL_FLOAT, 0, &surfVerts[0]);
+    glColor3fv( particleColor[0]);
+    if ( dimension == 3 )
+    {
+        // the light is attached to the viewer
+        glEnable( GL_LIGHTING);
+        glEnable( GL_LIGHT0);
+        glEnable( GL_NORMALIZE);
+        glEnable( GL_COLOR_MATERIAL);
+        glLightModeli( GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+        glEnableClientState( GL_NORMAL_ARRAY);
+        glNormalPointer( GL_FLOAT, 0, &surfNormals[0]);
+        glDrawElements( GL_TRIANGLES, (int)surfElems.size(), 
+                        GL_UNSIGNED_INT, &surfElems[0]);
+        glDisableClientState( GL_NORMAL_ARRAY);
+        glDisable( GL_COLOR_MATERIAL);
+        glDisable( GL_NORMALIZE);
+        glDisable( GL_LIGHT0);
+        glDisable( GL_LIGHTING);
+    }
+    else
+    {
+        glLineWidth( 2.0f);
+        glDrawElements( GL_LINES, (int)surfElems.size(), 
+                        GL_UNSIGNED_INT, &surfElems[0]);
+        glLineWidth( 1.0f);
+    }
+    glDisableClientState( GL_VERTEX_ARRAY);
+
+    return;
+} // drawSurfaceMesh
+
+// GLUT reshape callback.
+void
+Render::reshapeCallback( int width,   // window's width
+                         int height)  // window's height
+{
+    float clipVolume = parameters.clipVolume;
+
+    // it's not allowed to change the size of the window
+    glutReshapeWindow( windowWidth, windowHeight);
+    glViewport( 0, 0, windowWidth, windowHeight);
+
+    // set projection matrix
+    glMatrixMode( GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho( 0.0f, clipVolume, 0.0f, clipVolume, 
+             -clipVolume * 4.0f, clipVolume * 3.0f);
+    glMatrixMode( GL_MODELVIEW);
+    
+    return;
+} // reshapeCallback
+
+// GLUT keyboard callback.
+void
+Render::keyboardCallback( unsigned char key,   // key's code
+                          int x,               // position of
+                          int y)               // the mouse
+{
+    switch (key) {
+      case 'n':
+          // show next file (or in-between frame)
+          direction = 1;
+          if ( subStep + 1 < frameSteps )
+              switchFile( nfile, subStep + 1);
+          else
+              switchFile( nfile + 1);
+          break;
+      case 'p':
+          // show previous file (or in-between frame)
+          direction = -1;
+          if ( subStep > 0 )
+              switchFile( nfile, subStep - 1);
+          else
+              switchFile( nfile - 1, frameSteps - 1);
+          break;
+      case 'm':
+          // switch between the surface (if it has been 
+          // extracted, see 'yaps_post -surface') and particles
+          drawSurface = !drawSurface;
+          glutPostRedisplay();
+          break;
+      case 'i':
+          // switch interpolation between files (off/Hermite/linear)
+          interpMode = (interpMode + 1) % 3;
+          frameSteps = 1;
+          if ( interpMode )
+              frameSteps = (parameters.interpSteps > 1) ? 
+                           parameters.interpSteps : 4;
+          printf( "interpolation : %s\n", (interpMode == 0) ? "off" : 
+                  ((interpMode == 1) ? "Hermite" : "linear"));
+          switchFile( nfile);
+          break;
+      case ' ':
+          // start/stop playback in the current direction
+          togglePlayback();
+          break;
+      case 'l':
+          // start/stop following the live frames (see 'yaps_post -live')
+          if ( live )
+              stopLive();
+          else if ( !FrameRing::isFinished() )
+              startLive();
+          break;
+      case 's':
+          // switch between point sprites and spheres
+          drawSprites = !drawSprites;
+          glutPostRedisplay();
+          break;
+      case 'q':
+          // exit the program
+          exit( 0);
+      default:
+        break;
+    }
+
+    return;
+} // keyboardCallback
+
+// Show file 'newFile' - take it from the cache of frames (the frames 
+// around it are prefetched in background) and redisplay. If 'newStep' 
+// isn't 0, in-between frame 'newStep' of the interval between files 
+// 'newFile' and 'newFile+1' is built and shown instead.
+void
+Render::switchFile( int newFile,   // number of the file
+                    int newStep)   // number of in-between frame
+{
+    const Particles *prts, *prts2;
+    char title[40];
+
+    if ( newFile < 0 || newStep < 0 || newStep >= frameSteps )
+        return;
+
+    // the frame becomes current as soon as it's taken from the 
+    // cache, so it can't be evicted before it's shown
+    int pos = newFile * frameSteps + newStep;
+    int cur = nfile * frameSteps + subStep;
+    prts = FrameCache::getCurrent( newFile, 
+                                   (pos != cur) ? pos - cur : direction);
+    if ( prts == NULL )
+        return;
+
+    // the next file is kept in the cache while 'newFile' is current, 
+    // so it's safe to use it; the previous frame may be evicted already, 
+    // so the file itself is shown if there is no in-between frame
+    if ( newStep > 0 )
+    {
+        prts2 = FrameCache::get( newFile + 1);
+        if ( prts2 == NULL )
+        {
+            newStep = 0;
+        }
+        else if ( Interp::interpolate( *prts, *prts2, 
+                                       (float)newStep / frameSteps, 
+                                       Interp::getInterval( newFile), 
+                                       interpMode == 1, interpFrame) )
+        {
+            printf( "Particles of files %d and %d don't match\n", 
+                    newFile, newFile + 1);
+            newStep = 0;
+        }
+        else
+        {
+            prts = &interpFrame;
+        }
+    }
+
+    nfile = newFile;
+    subStep = newStep;
+    frame = prts;
+    particlesChanged = 1;
+    if ( subStep > 0 )
+        sprintf( title, "%s - %05d + %d/%d", "YAPS", nfile, 
+                 subStep, frameSteps);
+    else
+        sprintf( title, "%s - %05d", "YAPS", nfile);
+    glutSetWindowTitle( title);
+    //glutPostRedisplay();
+    displayCallback();
+
+    return;
+} // switchFile
+
+// Start/stop playback. Frames (files and in-between frames if the 
+// interpolation is on) are shown at the rate of PLAY_FPS frames per 
+// second in the current direction. The live frames aren't followed 
+// during the playback.
+void
+Render::togglePlayback()
+{
+    playing = !playing;
+    if ( !playing )
+        return;
+    if ( live )
+        stopLive();
+
+    playFrame = nfile * frameSteps + subStep;
+    playTime = omp_get_wtime();
+    statTime = playTime;
+    framesShown = 0;
+    framesDropped = 0;
+    FrameCache::setCurrent( nfile, direction);
+    glutTimerFunc( 0, playbackCallback, ++timerRun);
+
+    return;
+} // togglePlayback
+
+// GLUT timer callback to advance playback. The frame to show is 
+// determined by the time elapsed since the playback has started, 
+// so the frames which aren't read or drawn in time are skipped. 
+// The loader prefetches files starting from the file of this frame.
+void
+Render::playbackCallback( int value)   // number of the run
+{
+    if ( !playing || value != timerRun )
+        return;
+
+    float fps = (parameters.playFps > 0.0f) ? parameters.playFps : 25.0f;
+    double t = omp_get_wtime();
+    int cur = nfile * frameSteps + subStep;
+    int target = playFrame + direction * (int)((t - playTime) * fps);
+    int newFrame, newFile, newStep;
+    char ready = 0;
+
+    // the latest frame up to the target one which is ready, 
+    // in-between frames need both files of the interval
+    for ( newFrame = target; newFrame != cur; newFrame -= direction )
+    {
+        if ( newFrame < 0 )
+            continue;
+        newFile = newFrame / frameSteps;
+        newStep = newFrame % frameSteps;
+        ready = FrameCache::peek( newFile) != NULL && 
+                ( newStep == 0 || FrameCache::peek( newFile + 1) != NULL );
+        if ( ready )
+            break;
+    }
+
+    // file which is needed to move further
+    int nextFile = (direction > 0) ? nfile + 1 : 
+                   ((subStep > 0) ? nfile : nfile - 1);
+    if ( ready )
+    {
+        framesDropped += (newFrame - cur) * direction - 1;
+        framesShown++;
+        switchFile( newFrame / frameSteps, newFrame % frameSteps);
+    }
+    else if ( target != cur && 
+              ( nextFile < 0 || FrameCache::isMissing( nextFile) ) )
+    {
+        // there are no more files
+        playing = 0;
+    }
+
+    // the target is moved only after the frame to show has become 
+    // current, the frames between them aren't kept by the cache
+    if ( target != cur && target >= 0 )
+        FrameCache::setTarget( target / frameSteps);
+
+    // report achieved frame rate, time to read a frame and skipped frames
+    if ( t - statTime >= 1.0 || !playing )
+    {
+        printf( "playback : %5.1f fps, read %6.1f ms/frame, "
+                "%d frames skipped\n", framesShown / (t - statTime), 
+                FrameCache::getDecodeTime() * 1000.0, framesDropped);
+        statTime = t;
+        framesShown = 0;
+        framesDropped = 0;
+    }
+
+    if ( playing )
+        glutTimerFunc( (unsigned int)(500.0f / fps), playbackCallback, value);
+
+    return;
+} // playbackCallback
+
+// Start following the frames of the running simulation, the newest 
+// frame is shown at the rate of PLAY_FPS frames per second at most. 
+// The loader doesn't prefetch the output files meanwhile, they could 
+// be absent (LIVE_ONLY).
+void
+Render::startLive()
+{
+    if ( live )
+        return;
+
+    live = 1;
+    playing = 0;
+    FrameCache::setPaused( 1);
+    glutTimerFunc( 0, liveCallback, ++timerRun);
+
+    return;
+} // startLive
+
+// Stop following the frames of the running simulation.
+void
+Render::stopLive()
+{
+    live = 0;
+    FrameCache::setPaused( 0);
+
+    return;
+} // stopLive
+
+// GLUT timer callback to show the newest live frame, the frames 
+// which have been published since the last call are skipped.
+void
+Render::liveCallback( int value)   // number of the run
+{
+    int newFile, step;
+    char title[48];
+
+    if ( !live || value != timerRun )
+        return;
+
+    long long newFrame = FrameRing::readLatest( liveFrame, liveParticles, 
+                                                &newFile, &step);
+    if ( newFrame >= 0 )
+    {
+        if ( liveFrame >= 0 && newFrame - liveFrame > 1 )
+            printf( "live : %d frames skipped\n", 
+                    (int)(newFrame - liveFrame - 1));
+        liveFrame = newFrame;
+        nfile = newFile;
+        subStep = 0;
+        frame = &liveParticles;
+        particlesChanged = 1;
+        sprintf( title, "%s - %05d (live, step %d)", "YAPS", nfile, step);
+        glutSetWindowTitle( title);
+        glutPostRedisplay();
+    }
+    else if ( FrameRing::isFinished() )
+    {
+        printf( "live : the simulation has finished\n");
+        stopLive();
+        return;
+    }
+
+    float fps = (parameters.playFps > 0.0f) ? parameters.playFps : 25.0f;
+    glutTimerFunc( (unsigned int)(1000.0f / fps), liveCallback, value);
+
+    return;
+} // liveCallback
+
+// scaling/rotation steps
+const float Render::scaleStep    = 0.05f;
+const float Render::xRotateStep  = 1.0f;
+const float Render::yRotateStep  = 1.0f;
+const float Render::xyRotateMult = 0.1f;
+// current scaling/rotation factors
+float Render::scaleFactor   = 1.0f;
+float Render::xRotateFactor = 0.0f;
+float Render::yRotateFactor = 0.0f;
+
+// GLUT special functions callback.
+void
+Render::specialFuncCallback( int key,   // key's code
+                             int x,     // position of
+                             int y)     // the mouse
+{
+
+    switch (key) {
+      case GLUT_KEY_UP:
+          xRotateFactor += xRotateStep;
+          break;
+      case GLUT_KEY_DOWN:
+          xRotateFactor -= xRotateStep;
+          break;
+      case GLUT_KEY_LEFT:
+          yRotateFactor += yRotateStep;
+          break;
+      case GLUT_KEY_RIGHT:
+          yRotateFactor -= yRotateStep;
+          break;
+      case GLUT_KEY_PAGE_UP:
+          scaleFactor += scaleStep;
+          break;
+      case GLUT_KEY_PAGE_DOWN:
+          scaleFactor -= scaleStep;
+          break;
+      default:
+          return;
+          break;
+    }
+
+    scaleRotateFunc();
+
+    return;
+} // specialFuncCallback
+
+// current mouse button and position
+int Render::x0 = -1;
+int Render::y0 = -1;
+int Render::curButton = -1;
+
+// GLUT mouse button callback.
+void
+Render::mouseFuncCallback( int button, int state, int x, int y)
+{
+
+    // save pressed button and position
+    curButton = button;
+    x0 = x;
+    y0 = y;
+
+    // while the scene is being rotated, it's drawn in less detail
+    if ( button == GLUT_LEFT_BUTTON )
+    {
+        interacting = (state == GLUT_DOWN);
+        if ( !interacting )
+            glutPostRedisplay();
+    }
+
+    // scaling
+    switch (curButton) {
+      case 3:
+          scaleFactor += scaleStep;
+          break;
+      case 4:
+          scaleFactor -= scaleStep;
+          break;
+      default:
+          return;
+          break;
+    }
+
+    // redraw
+    scaleRotateFunc();
+
+    return;
+} // mouseFuncCallback
+
+// GLUT mouse motion callback.
+void
+Render::mouseMotionCallback( int x, int y)
+{
+    // rotation
+    switch (curButton) {
+      case GLUT_LEFT_BUTTON:
+          yRotateFactor -= xyRotateMult * (x0 - x);
+          xRotateFactor -= xyRotateMult * (y0 - y);
+          x0 = x;
+          y0 = y;
+          break;
+      default:
+          return;
+          break;
+    }
+     
+    // redraw
+    scaleRotateFunc();
+
+    return;
+} // mouseMotionCallback
+
+// Rotate and scale and redraw.
+void
+Render::scaleRotateFunc()
+{
+    glLoadIdentity();
+
+    float clipVolume = parameters.clipVolume;
+
+    // set the center of rotation
+    glTranslatef( clipVolume / 2.0f, clipVolume / 2.0f, clipVolume / 2.0f);
+    // rotate the scene along X-axis
+    glRotatef( xRotateFactor, 1.0, 0.0, 0.0);
+    // rotate the scene along Y-axis
+    glRotatef( yRotateFactor, 0.0, 1.0, 0.0);
+    // scale the scene
+    if ( scaleFactor < scaleStep )
+        scaleFactor = scaleStep;
+    glScalef( scaleFactor, scaleFactor, scaleFactor);
+    // restore the origin
+    glTranslatef( -clipVolume / 2.0f, -clipVolume / 2.0f, -clipVolume / 2.0f);
+    
+    // redisplay the scene
+    glutPostRedisplay();
+
+    return;
 } // scaleRotateFunc
\ No newline at end of file
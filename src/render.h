@@ -1,63 +1,156 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#ifndef YAPS_RENDER_H
-#define YAPS_RENDER_H
-
-class Render
-{
-
-public:
-
-    // constructor
-    Render( int argc, char **argv);
-    // run renderer
-    static void run();
-
-private:
-
-    // RGB colors for rendering
-    static const float particleColor[][3];
-    static const float backgroundColor[];
-    static const float segmentColor[];
-    static const float triangleLineColor[];
-    static const float triangleFillColor[];
-    // display list(s)
-    static const int obstacles_list;
-    // default size of the window
-    static const int windowWidth;
-    static const int windowHeight;
-    // current file
-    static int nfile;
-
-    // scaling/rotation steps
-    static const float scaleStep;
-    static const float xRotateStep;
-    static const float yRotateStep;
-    static const float xyRotateMult;
-    // current scaling/rotation factors
-    static float scaleFactor;
-    static float xRotateFactor;
-    static float yRotateFactor;
-    // current mouse button and position
-    static int x0, y0;
-    static int curButton;
-
-    // initialize display list(s)
-    static void initDisplayLists();
-    // initialize GL capabilities
-    static void initGLCapabilities();
-    // GLUT callbacks
-    static void displayCallback();
-    static void reshapeCallback( int width, int height);
-    static void keyboardCallback( unsigned char key, int x, int y);
-    static void specialFuncCallback( int key, int x, int y);
-    static void mouseFuncCallback( int button, int state, int x, int y);
-    static void mouseMotionCallback( int x, int y);
-    static void scaleRotateFunc();
-
-};
-
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_RENDER_H
+#define YAPS_RENDER_H
+
+#include "common.h"
+#include "grid.h"
+
+class Render
+{
+
+    // software renderer uses the same colors
+    friend class SoftRender;
+
+public:
+
+    // constructor
+    Render( int argc, char **argv);
+    // run renderer
+    static void run();
+    // follow the frames of the running simulation (FrameRing 
+    // should be attached)
+    static void startLive();
+
+private:
+
+    // RGB colors for rendering
+    static const float particleColor[][3];
+    static const float backgroundColor[];
+    static const float segmentColor[];
+    static const float triangleLineColor[];
+    static const float triangleFillColor[];
+    // display list(s)
+    static const int obstacles_list;
+    // size of the texture to draw particles as point sprites
+    static const int spriteSize;
+    // default size of the window
+    static const int windowWidth;
+    static const int windowHeight;
+    // current file
+    static int nfile;
+    // particles of the current file
+    static const Particles *frame;
+
+    // interpolation between files (0 - off, 1 - Hermite, 2 - linear)
+    static char interpMode;
+    // number of frames for each interval between files
+    static int frameSteps;
+    // current in-between frame (0 - the file itself)
+    static int subStep;
+    // particles of the current in-between frame
+    static Particles interpFrame;
+
+    // the live frames are followed
+    static char live;
+    // the last live frame shown and its particles
+    static long long liveFrame;
+    static Particles liveParticles;
+
+    // playback is on
+    static char playing;
+    // the playback and the live frames are mutually exclusive, each 
+    // start of them gets a new number which is passed to the timer 
+    // callbacks, so the callbacks of the stopped one die out
+    static int timerRun;
+    // direction of moving through the files
+    static int direction;
+    // first frame and start time of the playback
+    static int playFrame;
+    static double playTime;
+    // statistics of the playback
+    static int framesShown;
+    static int framesDropped;
+    static double statTime;
+
+    // draw particles as point sprites (or as spheres)
+    static char drawSprites;
+    // particles have been changed since the last upload
+    static char particlesChanged;
+    // texture of point sprites
+    static unsigned int spriteTexture;
+    // vertex buffer and its data (position and color of each particle)
+    static unsigned int vertexBuffer;
+    static float *vertexData;
+    static int vertexDataSize;
+    // grid over particles of the current frame, particles are stored 
+    // in the vertex buffer in the order of the grid's index
+    static CellGrid frameGrid;
+    // ranges of the vertex buffer to draw
+    static vector<int> drawFirst;
+    static vector<int> drawCount;
+    // the view is being changed by the mouse
+    static char interacting;
+    // draw free surface of the fluid (see Surface) instead of particles
+    static char drawSurface;
+    // file the surface has been read for, its vertices, 
+    // normals and elements (triangles or segments)
+    static int surfFile;
+    static vector<float> surfVerts;
+    static vector<float> surfNormals;
+    static vector<int> surfElems;
+
+    // scaling/rotation steps
+    static const float scaleStep;
+    static const float xRotateStep;
+    static const float yRotateStep;
+    static const float xyRotateMult;
+    // current scaling/rotation factors
+    static float scaleFactor;
+    static float xRotateFactor;
+    static float yRotateFactor;
+    // current mouse button and position
+    static int x0, y0;
+    static int curButton;
+
+    // show another file or in-between frame
+    static void switchFile( int newFile, int newStep = 0);
+    // start/stop playback
+    static void togglePlayback();
+    // GLUT timer callback to advance playback
+    static void playbackCallback( int value);
+    // stop following the live frames
+    static void stopLive();
+    // GLUT timer callback to show the newest live frame
+    static void liveCallback( int value);
+    // initialize display list(s)
+    static void initDisplayLists();
+    // initialize GL capabilities
+    static void initGLCapabilities();
+    // initialize texture of point sprites
+    static void initSprites();
+    // update grid and vertex buffer for the current frame
+    static void updateFrameData();
+    // find visible parts of the frame
+    static int  findVisibleCells();
+    // draw particles
+    static void drawParticlesAsSpheres( int decim);
+    static void drawParticlesAsSprites( int decim);
+    // read surface of the current file and draw it
+    static int  updateSurface();
+    static void drawSurfaceMesh();
+    // GLUT callbacks
+    static void displayCallback();
+    static void reshapeCallback( int width, int height);
+    static void keyboardCallback( unsigned char key, int x, int y);
+    static void specialFuncCallback( int key, int x, int y);
+    static void mouseFuncCallback( int button, int state, int x, int y);
+    static void mouseMotionCallback( int x, int y);
+    static void scaleRotateFunc();
+
+};
+
 #endif /* YAPS_RENDER_H */
\ No newline at end of file
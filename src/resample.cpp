@@ -0,0 +1,277 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "resample.h"
+#include "iobin.h"
+#include "common.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <omp.h>
+using namespace std;
+
+// fraction, density, pressure and three components of velocity
+const int Resample::fieldsNum = 6;
+
+// grid filename
+const char* Resample::gridName = "grid";
+
+// kernel, particles and grid over them
+KernelBase* Resample::kernel = NULL;
+const Particle* Resample::prts = NULL;
+int Resample::prtsNum = 0;
+CellGrid Resample::prtsGrid;
+
+// Constructor.
+// Choose the kernel according to parameters as the simulator does.
+Resample::Resample()
+{
+    // search for the required kernel
+    char *kernelType = parameters.kernelType;
+    if ( !strcmp( kernelType, "SPLINE") )
+        kernel = new KernelSpline();
+    else if ( !strcmp( kernelType, "SPIKY") )
+        kernel = new KernelSpiky();
+}
+
+// Destructor.
+Resample::~Resample()
+{
+    // deallocate
+    delete kernel;
+    kernel = NULL;
+}
+
+// Resample files from 'first' to 'last' (till the last existing file 
+// if 'last' is negative) to regular grids with the step 'spacing' which 
+// cover the box from 'lower' to 'upper'. Grids are written in VTK format 
+// (or raw), grid nodes are processed in parallel. The function returns 
+// the number of files which haven't been resampled.
+int
+Resample::resampleFrames( int first,             // first file
+                          int last,              // last file
+                          float spacing,         // grid step
+                          const float *lower,    // lower bound
+                          const float *upper,    // upper bound
+                          char raw)              // raw format (or VTK)
+{
+    const Particle *frame;
+    int errors = 0;
+    int dims[3];
+    int nfile, n, i, d;
+
+    if ( kernel == NULL || spacing <= 0.0f )
+        return 1;
+
+    // size of the grid
+    for ( d = 0; d < 3; d++ )
+    {
+        dims[d] = 1;
+        if ( d < dimension && upper[d] > lower[d] )
+            dims[d] = (int)floor( (upper[d] - lower[d]) / spacing) + 1;
+    }
+    int nodesNum = dims[0] * dims[1] * dims[2];
+    vector<float> fields( (size_t)nodesNum * fieldsNum);
+
+    for ( nfile = first; last < 0 || nfile <= last; nfile++ )
+    {
+        if ( IOBin().mapData( nfile, &frame, &n) )
+        {
+            // there are no more files
+            if ( last < 0 )
+                break;
+            errors++;
+            continue;
+        }
+        double t = omp_get_wtime();
+        setParticles( frame, n);
+
+        // interpolate fields at grid nodes
+#pragma omp parallel for schedule(dynamic,64) private(d)
+        for ( i = 0; i < nodesNum; i++ )
+        {
+            float pnt[3];
+            int coords[3];
+            coords[0] = i % dims[0];
+            coords[1] = (i / dims[0]) % dims[1];
+            coords[2] = i / (dims[0] * dims[1]);
+            for ( d = 0; d < 3; d++ )
+                pnt[d] = (d < dimension) ? lower[d] + coords[d] * spacing : 
+                                           0.0f;
+            getFields( pnt, &fields[(size_t)i * fieldsNum]);
+        }
+
+        setParticles( NULL, 0);
+        IOBin().unmapData( frame, n);
+
+        // write the grid
+        if ( raw ? writeRaw( nfile, dims, fields) : 
+                   writeVTK( nfile, dims, lower, spacing, fields) )
+            errors++;
+        printf( "grid %05d : %d x %d x %d nodes, %d particles, %.2f s\n", 
+                nfile, dims[0], dims[1], dims[2], n, omp_get_wtime() - t);
+    }
+
+    return errors;
+} // resampleFrames
+
+// Set particles 'prts' to interpolate fields of, they are 
+// sorted into cells of the size of the kernel's support.
+void
+Resample::setParticles( const Particle *prts,   // particles
+                        int prtsNum)            // number of particles
+{
+    Resample::prts = prts;
+    Resample::prtsNum = prtsNum;
+    if ( prts != NULL )
+        prtsGrid.build( prts[0].pos, sizeof(struct Particle) / sizeof(float), 
+                        prtsNum, 2.0f * parameters.smoothR);
+
+    return;
+} // setParticles
+
+// Returns the grid over the particles, the cells 
+// aren't smaller than the support of the kernel.
+const CellGrid&
+Resample::getGrid()
+{
+    return prtsGrid;
+} // getGrid
+
+// Interpolate fields of the particles at point 'pnt' using the kernel. 
+// The fraction of the point covered by the fluid (color field) is 
+// F = sum(Vj * W), where Vj is the volume of particle j. Density, 
+// pressure and velocity are interpolated with normalization by F 
+// (Shepard), so they stay correct near the free surface. The function 
+// could be called from several threads.
+void
+Resample::getFields( const float *pnt,   // point
+                     float *fields)      // fraction, dens, press, vel
+{
+    double sum[6];
+    float Rij[3];
+    int coords[3];
+    int ix, iy, iz, c, k, d;
+
+    memset( sum, 0, sizeof(sum));
+
+    // in 2D simulation the mass is given for a particle of 
+    // the depth 'particlesDistrib' (see readCloudsSection)
+    float depth = (dimension == 2) ? parameters.particlesDistrib : 1.0f;
+
+    // particles in the neighbouring cells (the cell 
+    // isn't smaller than the kernel's support)
+    prtsGrid.getCellCoords( pnt, coords);
+    int zrange = (dimension == 3) ? 1 : 0;
+    for ( iz = coords[2] - zrange; iz <= coords[2] + zrange; iz++ )
+    for ( iy = coords[1] - 1; iy <= coords[1] + 1; iy++ )
+    for ( ix = coords[0] - 1; ix <= coords[0] + 1; ix++ )
+    {
+        c = prtsGrid.getCell( ix, iy, iz);
+        if ( c < 0 )
+            continue;
+        for ( k = prtsGrid.cellStart[c]; k < prtsGrid.cellStart[c + 1]; k++ )
+        {
+            const Particle &prt = prts[prtsGrid.index[k]];
+            for ( d = 0; d < 3; d++ )
+                Rij[d] = pnt[d] - prt.pos[d];
+            float w = kernel->getValue( Rij);
+            if ( w == 0.0f || prt.dens <= 0.0f )
+                continue;
+            w *= prt.mass / (prt.dens * depth);
+            sum[0] += w;
+            sum[1] += w * prt.dens;
+            sum[2] += w * prt.press;
+            for ( d = 0; d < 3; d++ )
+                sum[3 + d] += w * prt.vel[d];
+        }
+    }
+
+    fields[0] = (float)sum[0];
+    for ( k = 1; k < fieldsNum; k++ )
+        fields[k] = (sum[0] > 0.0) ? (float)(sum[k] / sum[0]) : 0.0f;
+
+    return;
+} // getFields
+
+// Write 'fields' of the grid of the size 'dims' with the origin 'lower' 
+// and the step 'spacing' in legacy VTK format (binary structured points).
+int
+Resample::writeVTK( int nfile,                     // number of the file
+                    const int *dims,               // size of the grid
+                    const float *lower,            // origin
+                    float spacing,                 // grid step
+                    const vector<float> &fields)   // fields
+{
+    static const char *names[] = { "fraction", "density", "pressure" };
+    int nodesNum = dims[0] * dims[1] * dims[2];
+    int i, k;
+
+    // open file for writing
+    char ffname[32];
+    sprintf( ffname, "%s_%05d.vtk", gridName, nfile);
+    FILE *file = fopen( ffname, "wb");
+    if ( file == NULL )
+        return 1;
+
+    // header
+    fprintf( file, "# vtk DataFile Version 3.0\n" );
+    fprintf( file, "YAPS output %05d\nBINARY\nDATASET STRUCTURED_POINTS\n", 
+             nfile);
+    fprintf( file, "DIMENSIONS %d %d %d\n", dims[0], dims[1], dims[2]);
+    fprintf( file, "ORIGIN %g %g %g\n", lower[0], lower[1], 
+             (dimension == 3) ? lower[2] : 0.0f);
+    fprintf( file, "SPACING %g %g %g\n", spacing, spacing, spacing);
+    fprintf( file, "POINT_DATA %d\n", nodesNum);
+
+    // VTK binary data is big-endian (the host is little-endian)
+    vector<unsigned char> buf( (size_t)nodesNum * 3 * sizeof(float));
+    for ( k = 0; k < 4; k++ )
+    {
+        int comps = (k < 3) ? 1 : 3;
+        if ( k < 3 )
+            fprintf( file, "SCALARS %s float 1\nLOOKUP_TABLE default\n", 
+                     names[k]);
+        else
+            fprintf( file, "VECTORS velocity float\n");
+        for ( i = 0; i < nodesNum * comps; i++ )
+        {
+            float v = fields[(size_t)(i / comps) * fieldsNum + k + i % comps];
+            unsigned char *b = (unsigned char *)&v;
+            unsigned char *o = &buf[(size_t)i * 4];
+            o[0] = b[3]; o[1] = b[2]; o[2] = b[1]; o[3] = b[0];
+        }
+        fwrite( &buf[0], sizeof(float), (size_t)nodesNum * comps, file);
+        fprintf( file, "\n");
+    }
+
+    int res = ferror( file) ? 1 : 0;
+    fclose( file);
+
+    return res;
+} // writeVTK
+
+// Write 'fields' of the grid of the size 'dims' in raw format - 
+// node by node (X changes fastest), fraction, density, pressure 
+// and three components of velocity for each node, native floats.
+int
+Resample::writeRaw( int nfile,                     // number of the file
+                    const int *dims,               // size of the grid
+                    const vector<float> &fields)   // fields
+{
+    // open file for writing
+    char ffname[32];
+    sprintf( ffname, "%s_%05d.raw", gridName, nfile);
+    FILE *file = fopen( ffname, "wb");
+    if ( file == NULL )
+        return 1;
+
+    size_t num = (size_t)dims[0] * dims[1] * dims[2] * fieldsNum;
+    int res = (fwrite( &fields[0], sizeof(float), num, file) != num) ? 1 : 0;
+
+    fclose( file);
+
+    return res;
+} // writeRaw
\ No newline at end of file
@@ -0,0 +1,57 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_RESAMPLE_H
+#define YAPS_RESAMPLE_H
+
+#include "common.h"
+#include "grid.h"
+#include "kernel.h"
+
+// Resampling of particles' fields to a regular grid
+class Resample
+{
+
+public:
+
+    // number of fields (fraction, density, pressure, velocity)
+    static const int fieldsNum;
+
+    // constructor
+    Resample();
+    // destructor
+    ~Resample();
+    // resample files 'first'...'last' to grids
+    static int resampleFrames( int first, int last, float spacing, 
+                               const float *lower, const float *upper, 
+                               char raw);
+    // set particles to interpolate fields of
+    static void setParticles( const Particle *prts, int prtsNum);
+    // interpolate fields at point
+    static void getFields( const float *pnt, float *fields);
+    // grid over the particles (cells aren't smaller than kernel's support)
+    static const CellGrid& getGrid();
+
+private:
+
+    // grid filename
+    static const char* gridName;
+
+    // kernel
+    static KernelBase* kernel;
+    // particles and grid over them
+    static const Particle *prts;
+    static int prtsNum;
+    static CellGrid prtsGrid;
+
+    // write fields in VTK or raw format
+    static int writeVTK( int nfile, const int *dims, const float *lower, 
+                         float spacing, const vector<float> &fields);
+    static int writeRaw( int nfile, const int *dims, 
+                         const vector<float> &fields);
+
+};
+
+#endif // YAPS_RESAMPLE_H
\ No newline at end of file
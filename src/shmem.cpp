@@ -0,0 +1,234 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "shmem.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <signal.h>
+#include <cerrno>
+#endif
+using namespace std;
+
+#ifdef _WIN32
+// a named mapping exists while its handle is open, 
+// so the handles of the created blocks are kept
+struct Mapping
+{
+    void *addr;
+    HANDLE handle;
+};
+static vector<Mapping> mappings;
+#endif
+
+// Get name of the block of process 'pid'.
+void
+SharedMemory::getName( const char *prefix,  // prefix of the name
+                       int pid,             // process identifier
+                       char *name)          // name
+{
+#ifdef _WIN32
+    sprintf( name, "Local\\%s%d", prefix, pid);
+#else
+    sprintf( name, "/%s%d", prefix, pid);
+#endif
+
+    return;
+} // getName
+
+// Create zeroed block 'name' of 'size' bytes for writing, the function 
+// returns its address or NULL if the block can't be created.
+void*
+SharedMemory::create( const char *name,     // name
+                      size_t size)          // size
+{
+    void *addr = NULL;
+
+#ifdef _WIN32
+    unsigned long long sz = size;
+    HANDLE handle = CreateFileMappingA( INVALID_HANDLE_VALUE, NULL, 
+                                        PAGE_READWRITE, (DWORD)(sz >> 32), 
+                                        (DWORD)sz, name);
+    if ( handle == NULL )
+        return NULL;
+    addr = MapViewOfFile( handle, FILE_MAP_WRITE, 0, 0, size);
+    if ( addr == NULL )
+    {
+        CloseHandle( handle);
+        return NULL;
+    }
+    Mapping mapping = { addr, handle };
+    mappings.push_back( mapping);
+#else
+    int fd = shm_open( name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if ( fd < 0 )
+        return NULL;
+    if ( ftruncate( fd, size) == 0 )
+    {
+        addr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if ( addr == MAP_FAILED )
+            addr = NULL;
+    }
+    close( fd);
+    if ( addr == NULL )
+        shm_unlink( name);
+#endif
+
+    return addr;
+} // create
+
+// Unmap and remove block 'name' created by 'create', the readers 
+// which have mapped it keep their mappings.
+void
+SharedMemory::destroy( void *addr,          // address
+                       size_t size,         // size
+                       const char *name)    // name
+{
+    if ( addr == NULL )
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile( addr);
+    for ( int i = 0; i < (int)mappings.size(); i++ )
+    {
+        if ( mappings[i].addr != addr )
+            continue;
+        CloseHandle( mappings[i].handle);
+        mappings.erase( mappings.begin() + i);
+        break;
+    }
+#else
+    munmap( addr, size);
+    shm_unlink( name);
+#endif
+
+    return;
+} // destroy
+
+// Map block 'name' for reading, the function returns its 
+// address and size or NULL if there is no such block.
+const void*
+SharedMemory::map( const char *name,    // name
+                   size_t *size)        // size
+{
+    void *addr = NULL;
+    *size = 0;
+
+#ifdef _WIN32
+    HANDLE handle = OpenFileMappingA( FILE_MAP_READ, FALSE, name);
+    if ( handle == NULL )
+        return NULL;
+    addr = MapViewOfFile( handle, FILE_MAP_READ, 0, 0, 0);
+    // the view keeps the mapping open
+    CloseHandle( handle);
+    MEMORY_BASIC_INFORMATION info;
+    if ( addr != NULL && VirtualQuery( addr, &info, sizeof(info)) )
+        *size = info.RegionSize;
+#else
+    int fd = shm_open( name, O_RDONLY, 0);
+    if ( fd < 0 )
+        return NULL;
+    struct stat st;
+    if ( fstat( fd, &st) == 0 && st.st_size > 0 )
+    {
+        addr = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if ( addr == MAP_FAILED )
+            addr = NULL;
+        else
+            *size = st.st_size;
+    }
+    close( fd);
+#endif
+
+    return addr;
+} // map
+
+// Unmap block mapped by 'map'.
+void
+SharedMemory::unmap( const void *addr,  // address
+                     size_t size)       // size
+{
+    if ( addr == NULL )
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile( (void *)addr);
+#else
+    munmap( (void *)addr, size);
+#endif
+
+    return;
+} // unmap
+
+// Remove block 'name' left by a dead process, 
+// on Windows blocks are removed by the system.
+void
+SharedMemory::unlink( const char *name)     // name
+{
+#ifndef _WIN32
+    shm_unlink( name);
+#endif
+
+    return;
+} // unlink
+
+// Find the processes which have created blocks with 'prefix', POSIX 
+// shared memory objects are files in /dev/shm on Linux, there is no 
+// way to list the blocks on other systems.
+void
+SharedMemory::list( const char *prefix,     // prefix of the names
+                    vector<int> &pids)      // processes' identifiers
+{
+    pids.clear();
+#ifdef __linux__
+    DIR *dir = opendir( "/dev/shm");
+    if ( dir == NULL )
+        return;
+    int len = (int)strlen( prefix);
+    struct dirent *entry;
+    while ( (entry = readdir( dir)) != NULL )
+        if ( !strncmp( entry->d_name, prefix, len) )
+            pids.push_back( atoi( entry->d_name + len));
+    closedir( dir);
+#endif
+
+    return;
+} // list
+
+// Returns 0 if process 'pid' doesn't exist and 1 otherwise.
+int
+SharedMemory::isAlive( int pid)     // process identifier
+{
+#ifdef _WIN32
+    HANDLE process = OpenProcess( SYNCHRONIZE, FALSE, pid);
+    if ( process == NULL )
+        return 0;
+    DWORD res = WaitForSingleObject( process, 0);
+    CloseHandle( process);
+    return res == WAIT_TIMEOUT;
+#else
+    return !(kill( pid, 0) != 0 && errno == ESRCH);
+#endif
+} // isAlive
+
+// Full memory barrier.
+void
+SharedMemory::barrier()
+{
+#ifdef _WIN32
+    MemoryBarrier();
+#else
+    __sync_synchronize();
+#endif
+
+    return;
+} // barrier
\ No newline at end of file
@@ -0,0 +1,43 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_SHMEM_H
+#define YAPS_SHMEM_H
+
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+// Named shared memory - POSIX shared memory objects or named file 
+// mappings on Windows. A block is created by the simulator and 
+// named "<prefix><pid>", the other processes map it for reading.
+class SharedMemory
+{
+
+public:
+
+    // name of the block of process 'pid' (64 characters at most)
+    static void getName( const char *prefix, int pid, char *name);
+    // create zeroed block for writing, NULL if it can't be created
+    static void* create( const char *name, size_t size);
+    // unmap and remove block created by 'create'
+    static void destroy( void *addr, size_t size, const char *name);
+    // map block for reading, NULL if there is no such block
+    static const void* map( const char *name, size_t *size);
+    // unmap block mapped by 'map'
+    static void unmap( const void *addr, size_t size);
+    // remove block left by a dead process (POSIX only)
+    static void unlink( const char *name);
+    // identifiers of the processes which have created blocks 
+    // with 'prefix' (Linux only, the blocks are in /dev/shm)
+    static void list( const char *prefix, vector<int> &pids);
+    // check that process exists
+    static int isAlive( int pid);
+    // full memory barrier
+    static void barrier();
+
+};
+
+#endif // YAPS_SHMEM_H
\ No newline at end of file
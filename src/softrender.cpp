@@ -0,0 +1,387 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "softrender.h"
+#include "render.h"
+#include "iobin.h"
+#include "interp.h"
+#include "common.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+// image name
+const char* SoftRender::imageName = "image";
+
+// view
+float SoftRender::scaleFactor   = 1.0f;
+float SoftRender::xRotateFactor = 0.0f;
+float SoftRender::yRotateFactor = 0.0f;
+// size of images
+int SoftRender::width  = 800;
+int SoftRender::height = 800;
+
+// Image with depth buffer
+struct SoftRender::Image
+{
+    vector<float> color;    // RGB colors of pixels
+    vector<float> depth;    // depth of pixels (greater is nearer)
+};
+
+// Constructor.
+// The view is set in the same way as in the renderer - the 
+// scene is scaled by 'scaleFactor' and rotated along X-axis 
+// and Y-axis by 'xRotateFactor' and 'yRotateFactor' degrees.
+SoftRender::SoftRender( float scaleFactor,     // scaling
+                        float xRotateFactor,   // rotation along X-axis
+                        float yRotateFactor,   // rotation along Y-axis
+                        int width,             // width of images
+                        int height)            // height of images
+{
+    SoftRender::scaleFactor = scaleFactor;
+    SoftRender::xRotateFactor = xRotateFactor;
+    SoftRender::yRotateFactor = yRotateFactor;
+    SoftRender::width = width;
+    SoftRender::height = height;
+} // SoftRender
+
+// Render frames from 'first' to 'last' (till the last existing frame 
+// if 'last' is negative) to images in PPM format. The frames are 
+// rendered in parallel, each thread reads and renders its own frame. 
+// If 'steps' is greater than 1, each interval between frames is 
+// rendered as 'steps' frames built by Hermite interpolation, and 
+// images are numbered accordingly. The function returns the number 
+// of frames which haven't been rendered.
+int
+SoftRender::exportFrames( int first,   // first frame
+                          int last,    // last frame
+                          int steps)   // frames for each interval
+{
+    int errors = 0;
+    int n;
+
+    // find the last frame, the files are only mapped (not read)
+    if ( last < 0 )
+    {
+        const Particle *mprts;
+        int mprtsNum;
+        for ( last = first; 
+              IOBin().mapData( last + 1, &mprts, &mprtsNum) == 0; last++ )
+            IOBin().unmapData( mprts, mprtsNum);
+    }
+
+#pragma omp parallel for schedule(dynamic) reduction(+:errors)
+    for ( n = first; n <= last; n++ )
+    {
+        Particles prts;
+        Image image;
+
+        if ( IOBin().readData( n, prts) )
+        {
+            errors++;
+            continue;
+        }
+        renderFrame( prts, &image);
+        if ( writeImage( &image, n * steps) )
+            errors++;
+
+        // in-between frames
+        Particles prts2, iprts;
+        if ( steps <= 1 || n == last || IOBin().readData( n + 1, prts2) )
+            continue;
+        for ( int k = 1; k < steps; k++ )
+        {
+            if ( Interp::interpolate( prts, prts2, (float)k / steps, 
+                                      Interp::getInterval( n), 1, iprts) )
+            {
+                errors++;
+                continue;
+            }
+            renderFrame( iprts, &image);
+            if ( writeImage( &image, n * steps + k) )
+                errors++;
+        }
+    }
+
+    return errors;
+} // exportFrames
+
+// Render particles 'prts' and obstacles to 'image' - particles are 
+// drawn as shaded discs, then obstacles are drawn over them in the 
+// same way as it's done by the renderer.
+void
+SoftRender::renderFrame( const Particles &prts,   // particles
+                         Image *image)            // image
+{
+    float win1[3], win2[3], win3[3];
+    int i;
+
+    // clear the buffers
+    image->color.resize( 3 * width * height);
+    image->depth.assign( width * height, -1e30f);
+    for ( i = 0; i < width * height; i++ )
+        memcpy( &image->color[3 * i], Render::backgroundColor, 
+                3 * sizeof(float));
+
+    // draw the particles
+    float radius = parameters.particlesRadius * scaleFactor * 
+                   min( width, height) / parameters.clipVolume;
+    for ( i = 0; i < (int)prts.size(); i++ )
+    {
+        transform( prts[i].pos, win1);
+        drawDisc( image, win1, radius, Render::particleColor[prts[i].no-1]);
+    }
+
+    // draw the obstacles
+    for ( i = 0; i < (int)obstacles.size(); i++ )
+    {
+        transform( obstacles[i].vrtx1, win1);
+        transform( obstacles[i].vrtx2, win2);
+        if ( dimension == 2 )
+        {
+            drawLine( image, win1, win2, Render::segmentColor);
+            continue;
+        }
+        transform( obstacles[i].vrtx3, win3);
+        drawLine( image, win1, win2, Render::triangleLineColor);
+        drawLine( image, win2, win3, Render::triangleLineColor);
+        drawLine( image, win3, win1, Render::triangleLineColor);
+    }
+    if ( dimension == 3 )
+    {
+        // interiors are transparent and don't change the depth
+        for ( i = 0; i < (int)obstacles.size(); i++ )
+        {
+            transform( obstacles[i].vrtx1, win1);
+            transform( obstacles[i].vrtx2, win2);
+            transform( obstacles[i].vrtx3, win3);
+            drawTriangle( image, win1, win2, win3, 
+                          Render::triangleFillColor);
+        }
+    }
+
+    return;
+} // renderFrame
+
+// Transform point 'pnt' to window coordinates 'win' - x and y in pixels 
+// (y goes down), z is the depth. The transformation is the same as the 
+// renderer's one (see Render::scaleRotateFunc and reshapeCallback), 
+// the clipping volume is fitted into the image keeping its aspect.
+void
+SoftRender::transform( const float *pnt,   // point
+                       float *win)         // window coordinates
+{
+    float clipVolume = parameters.clipVolume;
+    float c = clipVolume / 2.0f;
+    float side = (float)min( width, height);
+    float x, y, z, t;
+    float a;
+
+    // restore the origin and scale the scene
+    x = (pnt[0] - c) * scaleFactor;
+    y = (pnt[1] - c) * scaleFactor;
+    z = ((dimension == 3 ? pnt[2] : 0.0f) - c) * scaleFactor;
+    // rotate the scene along Y-axis
+    a = yRotateFactor * 3.1415926535f / 180.0f;
+    t = x * cos( a) + z * sin( a);
+    z = -x * sin( a) + z * cos( a);
+    x = t;
+    // rotate the scene along X-axis
+    a = xRotateFactor * 3.1415926535f / 180.0f;
+    t = y * cos( a) - z * sin( a);
+    z = y * sin( a) + z * cos( a);
+    y = t;
+    // set the center of rotation and project (orthographic projection)
+    win[0] = 0.5f * (width - side) + (x + c) / clipVolume * side;
+    win[1] = 0.5f * (height - side) + (1.0f - (y + c) / clipVolume) * side;
+    win[2] = z + c;
+
+    return;
+} // transform
+
+// Draw particle at window coordinates 'win' as a disc of 'radius' 
+// pixels, it's shaded and its depth is set as for a sphere.
+void
+SoftRender::drawDisc( Image *image,          // image
+                      const float *win,      // window coordinates
+                      float radius,          // radius in pixels
+                      const float *color)    // color
+{
+    float clipVolume = parameters.clipVolume;
+    float dx, dy, dz;
+    float depth, light;
+    int x, y;
+
+    // clipping volume in depth
+    if ( win[2] > clipVolume * 4.0f || win[2] < -clipVolume * 3.0f )
+        return;
+
+    // pixels covered by the disc
+    int x1 = (int)floor( win[0] - radius);
+    int x2 = (int)ceil( win[0] + radius);
+    int y1 = (int)floor( win[1] - radius);
+    int y2 = (int)ceil( win[1] + radius);
+    if ( x1 < 0 ) x1 = 0;
+    if ( y1 < 0 ) y1 = 0;
+    if ( x2 > width - 1 ) x2 = width - 1;
+    if ( y2 > height - 1 ) y2 = height - 1;
+    if ( radius < 0.5f )
+        radius = 0.5f;
+
+    for ( y = y1; y <= y2; y++ )
+    {
+        for ( x = x1; x <= x2; x++ )
+        {
+            dx = (x + 0.5f - win[0]) / radius;
+            dy = (win[1] - y - 0.5f) / radius;
+            dz = 1.0f - dx * dx - dy * dy;
+            if ( dz < 0.0f )
+                continue;
+            dz = sqrt( dz);
+            // depth test
+            depth = win[2] + dz * radius * clipVolume / min( width, height);
+            float *zbuf = &image->depth[y * width + x];
+            if ( depth < *zbuf )
+                continue;
+            *zbuf = depth;
+            // diffuse lighting from the upper left
+            light = 0.35f + 0.65f * (-0.3f * dx + 0.3f * dy + 0.9f * dz);
+            if ( light > 1.0f )
+                light = 1.0f;
+            float *pixel = &image->color[3 * (y * width + x)];
+            pixel[0] = color[0] * light;
+            pixel[1] = color[1] * light;
+            pixel[2] = color[2] * light;
+        }
+    }
+
+    return;
+} // drawDisc
+
+// Draw line between window coordinates 'win1' and 'win2', 
+// the line passes the depth test and updates the depth.
+void
+SoftRender::drawLine( Image *image,          // image
+                      const float *win1,     // window coordinates
+                      const float *win2,     // of the ends
+                      const float *color)    // color
+{
+    float dx = win2[0] - win1[0];
+    float dy = win2[1] - win1[1];
+    int steps = (int)ceil( fabs( dx) > fabs( dy) ? fabs( dx) : fabs( dy));
+    float t;
+    int i, x, y;
+
+    if ( steps < 1 )
+        steps = 1;
+    for ( i = 0; i <= steps; i++ )
+    {
+        t = (float)i / steps;
+        x = (int)floor( win1[0] + t * dx);
+        y = (int)floor( win1[1] + t * dy);
+        if ( x < 0 || y < 0 || x >= width || y >= height )
+            continue;
+        float depth = win1[2] + t * (win2[2] - win1[2]);
+        float *zbuf = &image->depth[y * width + x];
+        if ( depth < *zbuf )
+            continue;
+        *zbuf = depth;
+        memcpy( &image->color[3 * (y * width + x)], color, 3 * sizeof(float));
+    }
+
+    return;
+} // drawLine
+
+// Draw triangle with window coordinates 'win1', 'win2' and 'win3'. 
+// It's blended with the image according to the alpha of 'color', 
+// the depth is tested but isn't changed.
+void
+SoftRender::drawTriangle( Image *image,          // image
+                          const float *win1,     // window coordinates
+                          const float *win2,     // of the
+                          const float *win3,     // vertices
+                          const float *color)    // color (RGBA)
+{
+    float area = (win2[0] - win1[0]) * (win3[1] - win1[1]) -
+                 (win3[0] - win1[0]) * (win2[1] - win1[1]);
+    float w1, w2, w3;
+    float px, py;
+    int x, y;
+
+    if ( area == 0.0f )
+        return;
+
+    // pixels covered by the triangle
+    int x1 = (int)floor( min( win1[0], min( win2[0], win3[0])));
+    int x2 = (int)ceil( max( win1[0], max( win2[0], win3[0])));
+    int y1 = (int)floor( min( win1[1], min( win2[1], win3[1])));
+    int y2 = (int)ceil( max( win1[1], max( win2[1], win3[1])));
+    if ( x1 < 0 ) x1 = 0;
+    if ( y1 < 0 ) y1 = 0;
+    if ( x2 > width - 1 ) x2 = width - 1;
+    if ( y2 > height - 1 ) y2 = height - 1;
+
+    for ( y = y1; y <= y2; y++ )
+    {
+        for ( x = x1; x <= x2; x++ )
+        {
+            // barycentric coordinates of the pixel's center
+            px = x + 0.5f;
+            py = y + 0.5f;
+            w1 = ((win2[0] - px) * (win3[1] - py) - 
+                  (win3[0] - px) * (win2[1] - py)) / area;
+            w2 = ((win3[0] - px) * (win1[1] - py) - 
+                  (win1[0] - px) * (win3[1] - py)) / area;
+            w3 = 1.0f - w1 - w2;
+            if ( w1 < 0.0f || w2 < 0.0f || w3 < 0.0f )
+                continue;
+            // depth test
+            float depth = w1 * win1[2] + w2 * win2[2] + w3 * win3[2];
+            if ( depth < image->depth[y * width + x] )
+                continue;
+            // blending
+            float *pixel = &image->color[3 * (y * width + x)];
+            for ( int c = 0; c < 3; c++ )
+                pixel[c] = color[3] * color[c] + (1.0f - color[3]) * pixel[c];
+        }
+    }
+
+    return;
+} // drawTriangle
+
+// Write 'image' of frame 'nfile' in binary PPM format.
+int
+SoftRender::writeImage( const Image *image,   // image
+                        int nfile)            // number of the frame
+{
+    // open file for writing
+    char ffname[32];
+    sprintf( ffname, "%s_%05d.ppm", imageName, nfile);
+    FILE *file = fopen( ffname, "wb");
+    if ( file == NULL )
+        return 1;
+
+    // header and pixels
+    vector<unsigned char> row( 3 * width);
+    fprintf( file, "P6\n%d %d\n255\n", width, height);
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int i = 0; i < 3 * width; i++ )
+        {
+            float c = image->color[3 * y * width + i];
+            c = (c < 0.0f) ? 0.0f : ((c > 1.0f) ? 1.0f : c);
+            row[i] = (unsigned char)(255.0f * c + 0.5f);
+        }
+        fwrite( &row[0], 1, 3 * width, file);
+    }
+
+    // close the file
+    if ( fclose( file) != 0 )
+        return 1;
+
+    return 0;
+} // writeImage
@@ -0,0 +1,57 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_SOFTRENDER_H
+#define YAPS_SOFTRENDER_H
+
+#include "common.h"
+
+class SoftRender
+{
+
+public:
+
+    // constructor (view is set as in the renderer)
+    SoftRender( float scaleFactor, float xRotateFactor, 
+                float yRotateFactor, int width, int height);
+    // render frames 'first'...'last' to images, in parallel
+    static int exportFrames( int first, int last, int steps = 1);
+
+private:
+
+    // image name
+    static const char* imageName;
+
+    // view
+    static float scaleFactor;
+    static float xRotateFactor;
+    static float yRotateFactor;
+    // size of images
+    static int width;
+    static int height;
+
+    // image with depth buffer
+    struct Image;
+
+    // render particles 'prts' and obstacles to 'image'
+    static void renderFrame      ( const Particles &prts, Image *image);
+    // transform point to window coordinates (x, y in pixels, z)
+    static void transform        ( const float *pnt, float *win);
+    // draw particle as a shaded disc
+    static void drawDisc         ( Image *image, const float *win, 
+                                   float radius, const float *color);
+    // draw line
+    static void drawLine         ( Image *image, const float *win1, 
+                                   const float *win2, const float *color);
+    // draw transparent triangle
+    static void drawTriangle     ( Image *image, const float *win1, 
+                                   const float *win2, const float *win3, 
+                                   const float *color);
+    // write image in PPM format
+    static int  writeImage       ( const Image *image, int nfile);
+
+};
+
+#endif // YAPS_SOFTRENDER_H
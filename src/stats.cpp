@@ -0,0 +1,349 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "stats.h"
+#include "iobin.h"
+#include "common.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <omp.h>
+using namespace std;
+
+// statistics filename
+const char* Stats::statsName = "stats";
+
+// names of the values
+static const char* valueNames[] = { "density", "pressure", "velocity" };
+static const int valuesNum = 3;
+
+// Statistics of a value over particles of a frame, the 
+// histogram's bins divide the range [min,max] evenly. NaN and 
+// infinite values (of a diverged run) are only counted.
+struct Stats::Value
+{
+    float min;              // minimum
+    float max;              // maximum
+    double mean;            // mean
+    vector<int> hist;       // histogram
+    int nonFinite;          // number of NaN and infinite values
+};
+
+// Statistics of a frame
+struct Stats::Frame
+{
+    int nfile;              // number of the file
+    int prtsNum;            // number of particles (-1 - not read)
+    float time;             // time of the frame
+    float lower[3];         // bounding box
+    float upper[3];
+    double centroid[3];     // centroid of the fluid (mass weighted)
+    int nonFinite;          // number of particles with NaN or infinite 
+                            // positions or masses (out of the box)
+    Value values[3];        // density, pressure, velocity magnitude
+};
+
+// Returns 1 if 'v' is neither NaN nor infinite (the difference 
+// is NaN otherwise), and 0 otherwise.
+static inline int
+isFinite( float v)   // value
+{
+    return v - v == 0.0f;
+} // isFinite
+
+// Scan files from 'first' to 'last' (till the last existing file if 
+// 'last' is negative) and write their statistics to a file in CSV or 
+// JSON format. The files are mapped into memory and scanned in 
+// parallel, each thread scans its own file. The function returns the 
+// number of files which haven't been scanned.
+int
+Stats::scanFrames( int first,     // first file
+                   int last,      // last file
+                   int binsNum,   // number of bins of histograms
+                   char json)     // JSON format (or CSV)
+{
+    const Particle *prts;
+    int errors = 0;
+    int n;
+
+    // find the last file
+    if ( last < 0 )
+    {
+        for ( last = first; IOBin().mapData( last + 1, &prts, &n) == 0; 
+              last++ )
+            IOBin().unmapData( prts, n);
+    }
+    if ( last < first )
+        return 0;
+
+    double t = omp_get_wtime();
+    vector<Frame> frames( last - first + 1);
+
+#pragma omp parallel for schedule(dynamic) reduction(+:errors)
+    for ( n = first; n <= last; n++ )
+    {
+        if ( scanFrame( n, binsNum, &frames[n - first]) )
+            errors++;
+    }
+
+    // total amount of data and frames with NaN or infinite values
+    double mbytes = 0.0;
+    int diverged = 0;
+    for ( n = 0; n < (int)frames.size(); n++ )
+    {
+        if ( frames[n].prtsNum > 0 )
+            mbytes += frames[n].prtsNum * sizeof(struct Particle) / 1048576.0;
+        if ( frames[n].prtsNum > 0 && frames[n].nonFinite > 0 )
+        {
+            diverged++;
+            continue;
+        }
+        for ( int j = 0; frames[n].prtsNum > 0 && j < valuesNum; j++ )
+        {
+            if ( frames[n].values[j].nonFinite > 0 )
+            {
+                diverged++;
+                break;
+            }
+        }
+    }
+    t = omp_get_wtime() - t;
+    printf( "stats : %d files (%.1f MB) scanned in %.2f s, %.1f MB/s\n", 
+            (int)frames.size() - errors, mbytes, t, 
+            (t > 0.0) ? mbytes / t : 0.0);
+    if ( diverged > 0 )
+        printf( "stats : %d files with NaN or infinite values "
+                "(see the nonfinite columns)\n", diverged);
+
+    // write statistics
+    if ( json ? writeJSON( frames, binsNum) : writeCSV( frames, binsNum) )
+        printf( "Can't write statistics\n");
+
+    return errors;
+} // scanFrames
+
+// Calculate statistics 'frame' of file 'nfile'. The function 
+// returns 0 if succeeded and 1 if the file can't be read.
+int
+Stats::scanFrame( int nfile,      // number of the file
+                  int binsNum,    // number of bins of histograms
+                  Frame *frame)   // statistics
+{
+    const Particle *prts;
+    float v[3];
+    double sum[3];
+    double mass;
+    int count[3];
+    int n, i, j, d;
+
+    frame->nfile = nfile;
+    frame->prtsNum = -1;
+    if ( IOBin().mapData( nfile, &prts, &n) )
+        return 1;
+    frame->prtsNum = n;
+
+    // the initial state is written before the first step, then 
+    // the files are written after every OUT_FREQ steps starting 
+    // from step 0 (see Calc::run)
+    frame->time = (nfile == 0) ? 0.0f : 
+        (1 + (nfile - 1) * parameters.outFreq) * parameters.timeStep;
+
+    // ranges, means, bounding box and centroid
+    memset( sum, 0, sizeof(sum));
+    memset( count, 0, sizeof(count));
+    memset( frame->centroid, 0, sizeof(frame->centroid));
+    frame->nonFinite = 0;
+    mass = 0.0;
+    for ( i = 0; i < n; i++ )
+    {
+        const Particle &prt = prts[i];
+        v[0] = prt.dens;
+        v[1] = prt.press;
+        v[2] = sqrt( prt.vel[0] * prt.vel[0] + prt.vel[1] * prt.vel[1] + 
+                     prt.vel[2] * prt.vel[2]);
+        for ( j = 0; j < valuesNum; j++ )
+        {
+            if ( !isFinite( v[j]) )
+                continue;
+            if ( count[j] == 0 || v[j] < frame->values[j].min )
+                frame->values[j].min = v[j];
+            if ( count[j] == 0 || v[j] > frame->values[j].max )
+                frame->values[j].max = v[j];
+            sum[j] += v[j];
+            count[j]++;
+        }
+
+        // the particles with non-finite positions or masses 
+        // are left out of the bounding box and the centroid
+        char finite = isFinite( prt.mass);
+        for ( d = 0; d < 3; d++ )
+            if ( !isFinite( prt.pos[d]) )
+                finite = 0;
+        if ( !finite )
+        {
+            frame->nonFinite++;
+            continue;
+        }
+        for ( d = 0; d < 3; d++ )
+        {
+            if ( i == frame->nonFinite || prt.pos[d] < frame->lower[d] )
+                frame->lower[d] = prt.pos[d];
+            if ( i == frame->nonFinite || prt.pos[d] > frame->upper[d] )
+                frame->upper[d] = prt.pos[d];
+            frame->centroid[d] += prt.mass * prt.pos[d];
+        }
+        mass += prt.mass;
+    }
+    if ( n == frame->nonFinite )
+    {
+        memset( frame->lower, 0, sizeof(frame->lower));
+        memset( frame->upper, 0, sizeof(frame->upper));
+    }
+    for ( j = 0; j < valuesNum; j++ )
+    {
+        if ( count[j] == 0 )
+            frame->values[j].min = frame->values[j].max = 0.0f;
+        frame->values[j].mean = (count[j] > 0) ? sum[j] / count[j] : 0.0;
+        frame->values[j].nonFinite = n - count[j];
+    }
+    for ( d = 0; d < 3; d++ )
+        frame->centroid[d] = (mass > 0.0) ? frame->centroid[d] / mass : 0.0;
+
+    // histograms (the mapped pages are still in memory)
+    for ( j = 0; j < valuesNum; j++ )
+        frame->values[j].hist.assign( binsNum, 0);
+    for ( i = 0; i < n; i++ )
+    {
+        const Particle &prt = prts[i];
+        v[0] = prt.dens;
+        v[1] = prt.press;
+        v[2] = sqrt( prt.vel[0] * prt.vel[0] + prt.vel[1] * prt.vel[1] + 
+                     prt.vel[2] * prt.vel[2]);
+        for ( j = 0; j < valuesNum; j++ )
+        {
+            if ( !isFinite( v[j]) )
+                continue;
+            // the position is clamped to the range of the bins 
+            // before it's converted to an integer
+            Value &value = frame->values[j];
+            double range = (double)value.max - value.min;
+            double pos = (range > 0.0) ? 
+                         (v[j] - value.min) / range * binsNum : 0.0;
+            int bin = 0;
+            if ( pos >= binsNum - 1 )
+                bin = binsNum - 1;
+            else if ( pos > 0.0 )
+                bin = (int)pos;
+            value.hist[bin]++;
+        }
+    }
+
+    IOBin().unmapData( prts, n);
+
+    return 0;
+} // scanFrame
+
+// Write statistics 'frames' in CSV format, one line for each file.
+int
+Stats::writeCSV( const vector<Frame> &frames,   // statistics
+                 int binsNum)                   // number of bins
+{
+    char ffname[32];
+    sprintf( ffname, "%s.csv", statsName);
+    FILE *file = fopen( ffname, "w");
+    if ( file == NULL )
+        return 1;
+
+    int i, j, k;
+
+    // header
+    fprintf( file, "file,time,particles,"
+                   "xmin,ymin,zmin,xmax,ymax,zmax,cx,cy,cz,nonfinite");
+    for ( j = 0; j < valuesNum; j++ )
+    {
+        fprintf( file, ",%s_min,%s_max,%s_mean,%s_nonfinite", 
+                 valueNames[j], valueNames[j], valueNames[j], valueNames[j]);
+        for ( k = 0; k < binsNum; k++ )
+            fprintf( file, ",%s_h%d", valueNames[j], k);
+    }
+    fprintf( file, "\n");
+
+    // frames
+    for ( i = 0; i < (int)frames.size(); i++ )
+    {
+        const Frame &frame = frames[i];
+        if ( frame.prtsNum < 0 )
+            continue;
+        fprintf( file, "%d,%g,%d,%g,%g,%g,%g,%g,%g,%g,%g,%g,%d", 
+                 frame.nfile, frame.time, frame.prtsNum, 
+                 frame.lower[0], frame.lower[1], frame.lower[2], 
+                 frame.upper[0], frame.upper[1], frame.upper[2], 
+                 frame.centroid[0], frame.centroid[1], frame.centroid[2], 
+                 frame.nonFinite);
+        for ( j = 0; j < valuesNum; j++ )
+        {
+            const Value &value = frame.values[j];
+            fprintf( file, ",%g,%g,%g,%d", value.min, value.max, value.mean, 
+                     value.nonFinite);
+            for ( k = 0; k < binsNum; k++ )
+                fprintf( file, ",%d", value.hist[k]);
+        }
+        fprintf( file, "\n");
+    }
+
+    fclose( file);
+
+    return 0;
+} // writeCSV
+
+// Write statistics 'frames' in JSON format.
+int
+Stats::writeJSON( const vector<Frame> &frames,   // statistics
+                  int binsNum)                   // number of bins
+{
+    char ffname[32];
+    sprintf( ffname, "%s.json", statsName);
+    FILE *file = fopen( ffname, "w");
+    if ( file == NULL )
+        return 1;
+
+    int i, j, k;
+    char first = 1;
+
+    fprintf( file, "{\n  \"bins\": %d,\n  \"frames\": [", binsNum);
+    for ( i = 0; i < (int)frames.size(); i++ )
+    {
+        const Frame &frame = frames[i];
+        if ( frame.prtsNum < 0 )
+            continue;
+        fprintf( file, "%s\n    { \"file\": %d, \"time\": %g, "
+                       "\"particles\": %d,\n", 
+                 first ? "" : ",", frame.nfile, frame.time, frame.prtsNum);
+        first = 0;
+        fprintf( file, "      \"bbox\": [[%g, %g, %g], [%g, %g, %g]], ", 
+                 frame.lower[0], frame.lower[1], frame.lower[2], 
+                 frame.upper[0], frame.upper[1], frame.upper[2]);
+        fprintf( file, "\"centroid\": [%g, %g, %g], \"nonfinite\": %d", 
+                 frame.centroid[0], frame.centroid[1], frame.centroid[2], 
+                 frame.nonFinite);
+        for ( j = 0; j < valuesNum; j++ )
+        {
+            const Value &value = frame.values[j];
+            fprintf( file, ",\n      \"%s\": { \"min\": %g, \"max\": %g, "
+                           "\"mean\": %g, \"nonfinite\": %d, \"hist\": [", 
+                     valueNames[j], value.min, value.max, value.mean, 
+                     value.nonFinite);
+            for ( k = 0; k < binsNum; k++ )
+                fprintf( file, "%s%d", k ? ", " : "", value.hist[k]);
+            fprintf( file, "] }");
+        }
+        fprintf( file, " }");
+    }
+    fprintf( file, "\n  ]\n}\n");
+
+    fclose( file);
+
+    return 0;
+} // writeJSON
\ No newline at end of file
@@ -0,0 +1,38 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_STATS_H
+#define YAPS_STATS_H
+
+#include "common.h"
+
+// Statistics of output files
+class Stats
+{
+
+public:
+
+    // scan files 'first'...'last' in parallel and write statistics
+    static int scanFrames( int first, int last, int binsNum, char json);
+
+private:
+
+    // statistics filename
+    static const char* statsName;
+
+    // statistics of a value over particles of a frame
+    struct Value;
+    // statistics of a frame
+    struct Frame;
+
+    // statistics of frame 'nfile'
+    static int  scanFrame  ( int nfile, int binsNum, Frame *frame);
+    // write statistics in CSV or JSON format
+    static int  writeCSV   ( const vector<Frame> &frames, int binsNum);
+    static int  writeJSON  ( const vector<Frame> &frames, int binsNum);
+
+};
+
+#endif // YAPS_STATS_H
\ No newline at end of file
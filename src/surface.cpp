@@ -0,0 +1,534 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "surface.h"
+#include "resample.h"
+#include "iobin.h"
+#include "common.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <omp.h>
+using namespace std;
+
+// surface filename
+const char* Surface::surfName = "surface";
+
+// File's header, it's followed by vertices (3 floats each) 
+// and elements (indices of 'dimension' vertices each)
+struct Surface::Header
+{
+    char magic[8];      // "YAPSSRF"
+    int version;        // version of the format
+    int dimension;      // dimension (3 - triangles, 2 - segments)
+    int vertsNum;       // number of vertices
+    int elemsNum;       // number of elements
+};
+
+// Sparse grid (lattice) of the color field. It's divided into blocks 
+// which match the cells of the grid over particles (Resample::getGrid) 
+// with one more layer of cells around, the field is evaluated only in 
+// the blocks near particles.
+struct Surface::Lattice
+{
+    float origin[3];        // origin
+    float spacing;          // step
+    float blockSize;        // size of a block
+    int blocksDims[3];      // number of blocks along each axis
+    int nodesDims[3];       // number of nodes along each axis
+};
+
+// Vertex of the surface on the edge of the lattice, the edge is 
+// identified by the index of its first node and its direction
+struct Surface::EdgeVertex
+{
+    unsigned long long key; // edge
+    float pos[3];           // position
+
+    bool operator< ( const EdgeVertex &v) const { return key < v.key; }
+    bool operator==( const EdgeVertex &v) const { return key == v.key; }
+};
+
+// Cube of the lattice is divided into 6 tetrahedra around 
+// the diagonal 0-7 (bits of the corner's number are offsets 
+// along X, Y and Z), the square is divided into 2 triangles
+static const int cubeTetras[6][4] = { { 0, 1, 3, 7 }, { 0, 3, 2, 7 }, 
+                                      { 0, 2, 6, 7 }, { 0, 6, 4, 7 }, 
+                                      { 0, 4, 5, 7 }, { 0, 5, 1, 7 } };
+static const int squareTriangles[2][3] = { { 0, 1, 3 }, { 0, 3, 2 } };
+
+// Extract free surfaces of files from 'first' to 'last' (till the last 
+// existing file if 'last' is negative) - isosurfaces 'iso' of the color 
+// field (see Resample::getFields) evaluated on the lattice with the step 
+// 'spacing' near particles, by marching tetrahedra (triangles in 2D). 
+// Blocks of the lattice are processed in parallel. The function returns 
+// the number of files which haven't been processed.
+int
+Surface::extractFrames( int first,       // first file
+                        int last,        // last file
+                        float spacing,   // step of the lattice
+                        float iso)       // value of the color field
+{
+    Resample resample;
+    const Particle *frame;
+    Lattice lattice;
+    int errors = 0;
+    int nfile, n, i, c, d;
+
+    if ( spacing <= 0.0f )
+        return 1;
+
+    for ( nfile = first; last < 0 || nfile <= last; nfile++ )
+    {
+        if ( IOBin().mapData( nfile, &frame, &n) )
+        {
+            // there are no more files
+            if ( last < 0 )
+                break;
+            errors++;
+            continue;
+        }
+        double t = omp_get_wtime();
+        Resample::setParticles( frame, n);
+        const CellGrid &grid = Resample::getGrid();
+
+        // lattice
+        lattice.spacing = spacing;
+        lattice.blockSize = grid.cellSize;
+        for ( d = 0; d < 3; d++ )
+        {
+            lattice.origin[d] = 0.0f;
+            lattice.blocksDims[d] = 1;
+            lattice.nodesDims[d] = 1;
+            if ( d >= dimension )
+                continue;
+            lattice.origin[d] = grid.origin[d] - grid.cellSize;
+            lattice.blocksDims[d] = grid.dims[d] + 2;
+            lattice.nodesDims[d] = (int)ceil( lattice.blocksDims[d] * 
+                                   (double)grid.cellSize / spacing) + 1;
+        }
+
+        // blocks near particles
+        int *bdims = lattice.blocksDims;
+        vector<char> active( bdims[0] * bdims[1] * bdims[2], 0);
+        int range[3] = { 1, 1, (dimension == 3) ? 1 : 0 };
+        for ( c = 0; n > 0 && c < grid.cellsNum; c++ )
+        {
+            if ( grid.cellStart[c + 1] == grid.cellStart[c] )
+                continue;
+            int cx = c % grid.dims[0] + 1;
+            int cy = (c / grid.dims[0]) % grid.dims[1] + 1;
+            int cz = (dimension == 3) ? c / (grid.dims[0] * grid.dims[1]) + 1 
+                                      : 0;
+            for ( int z = cz - range[2]; z <= cz + range[2]; z++ )
+                for ( int y = cy - 1; y <= cy + 1; y++ )
+                    for ( int x = cx - 1; x <= cx + 1; x++ )
+                        active[(z * bdims[1] + y) * bdims[0] + x] = 1;
+        }
+        vector<int> blocks;
+        for ( i = 0; i < (int)active.size(); i++ )
+            if ( active[i] )
+                blocks.push_back( i);
+
+        // extract the surface block by block
+        vector< vector<EdgeVertex> > blockVerts( blocks.size());
+#pragma omp parallel for schedule(dynamic)
+        for ( i = 0; i < (int)blocks.size(); i++ )
+        {
+            int block[3];
+            block[0] = blocks[i] % bdims[0];
+            block[1] = (blocks[i] / bdims[0]) % bdims[1];
+            block[2] = blocks[i] / (bdims[0] * bdims[1]);
+            extractBlock( lattice, block, iso, blockVerts[i]);
+        }
+
+        Resample::setParticles( NULL, 0);
+        IOBin().unmapData( frame, n);
+
+        // vertices shared by elements are stored once
+        vector<EdgeVertex> uniqueVerts;
+        for ( i = 0; i < (int)blockVerts.size(); i++ )
+            uniqueVerts.insert( uniqueVerts.end(), 
+                                blockVerts[i].begin(), blockVerts[i].end());
+        sort( uniqueVerts.begin(), uniqueVerts.end());
+        uniqueVerts.erase( unique( uniqueVerts.begin(), uniqueVerts.end()), 
+                           uniqueVerts.end());
+        vector<float> verts( 3 * uniqueVerts.size());
+        for ( i = 0; i < (int)uniqueVerts.size(); i++ )
+            memcpy( &verts[3 * i], uniqueVerts[i].pos, 3 * sizeof(float));
+        vector<int> elems;
+        for ( c = 0; c < (int)blockVerts.size(); c++ )
+        {
+            for ( i = 0; i < (int)blockVerts[c].size(); i++ )
+                elems.push_back( (int)(lower_bound( uniqueVerts.begin(), 
+                                 uniqueVerts.end(), blockVerts[c][i]) - 
+                                 uniqueVerts.begin()));
+            vector<EdgeVertex>().swap( blockVerts[c]);
+        }
+
+        // write the surface
+        if ( writeSurface( nfile, verts, elems) )
+            errors++;
+        printf( "surface %05d : %d particles, %d blocks, %d vertices, "
+                "%d elements, %.2f s\n", nfile, n, (int)blocks.size(), 
+                (int)uniqueVerts.size(), (int)elems.size() / dimension, 
+                omp_get_wtime() - t);
+    }
+
+    return errors;
+} // extractFrames
+
+// Extract the surface in block 'block' of the lattice - the color 
+// field is evaluated at the nodes of the block, then the cubes 
+// (squares in 2D) of the block are divided into simplices. Vertices 
+// of the elements are appended to 'elemVerts'.
+void
+Surface::extractBlock( const Lattice &lattice,          // lattice
+                       const int *block,                // block
+                       float iso,                       // iso value
+                       vector<EdgeVertex> &elemVerts)   // elements
+{
+    float fields[6];
+    float pnt[3];
+    int lo[3], hi[3], nn[3];
+    int nodes[8][3];
+    float vals[8];
+    int x, y, z, k, d;
+
+    // cubes of the block are [lo,hi) and its nodes are [lo,hi]
+    for ( d = 0; d < 3; d++ )
+    {
+        lo[d] = hi[d] = 0;
+        if ( d >= dimension )
+            continue;
+        lo[d] = (int)ceil( block[d] * (double)lattice.blockSize / 
+                           lattice.spacing);
+        hi[d] = (int)ceil( (block[d] + 1) * (double)lattice.blockSize / 
+                           lattice.spacing);
+        if ( hi[d] > lattice.nodesDims[d] - 1 )
+            hi[d] = lattice.nodesDims[d] - 1;
+        if ( lo[d] >= hi[d] )
+            return;
+    }
+    for ( d = 0; d < 3; d++ )
+        nn[d] = hi[d] - lo[d] + 1;
+
+    // color field at the nodes
+    vector<float> field( nn[0] * nn[1] * nn[2]);
+    char inside = 0, outside = 0;
+    for ( z = 0; z < nn[2]; z++ )
+    for ( y = 0; y < nn[1]; y++ )
+    for ( x = 0; x < nn[0]; x++ )
+    {
+        pnt[0] = lattice.origin[0] + (lo[0] + x) * lattice.spacing;
+        pnt[1] = lattice.origin[1] + (lo[1] + y) * lattice.spacing;
+        pnt[2] = (dimension == 3) ? 
+                 lattice.origin[2] + (lo[2] + z) * lattice.spacing : 0.0f;
+        Resample::getFields( pnt, fields);
+        field[(z * nn[1] + y) * nn[0] + x] = fields[0];
+        if ( fields[0] >= iso )
+            inside = 1;
+        else
+            outside = 1;
+    }
+    if ( !inside || !outside )
+        return;
+
+    // cubes (squares)
+    int cornersNum = (dimension == 3) ? 8 : 4;
+    for ( z = 0; z < ((dimension == 3) ? nn[2] - 1 : 1); z++ )
+    for ( y = 0; y < nn[1] - 1; y++ )
+    for ( x = 0; x < nn[0] - 1; x++ )
+    {
+        inside = outside = 0;
+        for ( k = 0; k < cornersNum; k++ )
+        {
+            int cx = x + (k & 1), cy = y + ((k >> 1) & 1), 
+                cz = z + ((k >> 2) & 1);
+            nodes[k][0] = lo[0] + cx;
+            nodes[k][1] = lo[1] + cy;
+            nodes[k][2] = lo[2] + cz;
+            vals[k] = field[(cz * nn[1] + cy) * nn[0] + cx];
+            if ( vals[k] >= iso )
+                inside = 1;
+            else
+                outside = 1;
+        }
+        if ( !inside || !outside )
+            continue;
+
+        // simplices
+        int snodes[4][3];
+        float svals[4];
+        int simplicesNum = (dimension == 3) ? 6 : 2;
+        for ( int s = 0; s < simplicesNum; s++ )
+        {
+            for ( k = 0; k <= dimension; k++ )
+            {
+                int corner = (dimension == 3) ? cubeTetras[s][k] : 
+                                                squareTriangles[s][k];
+                memcpy( snodes[k], nodes[corner], 3 * sizeof(int));
+                svals[k] = vals[corner];
+            }
+            extractSimplex( lattice, snodes, svals, iso, elemVerts);
+        }
+    }
+
+    return;
+} // extractBlock
+
+// Extract the surface in the simplex with nodes 'nodes' and values of 
+// the color field 'vals' (tetrahedron in 3D and triangle in 2D). There 
+// is one triangle (segment) if one node is separated from the others, 
+// and two triangles if two nodes are inside. Elements are oriented so 
+// that their normals point out of the fluid.
+void
+Surface::extractSimplex( const Lattice &lattice,          // lattice
+                         int (*nodes)[3],                 // nodes
+                         const float *vals,               // values
+                         float iso,                       // iso value
+                         vector<EdgeVertex> &elemVerts)   // elements
+{
+    int in[4], out[4];
+    int inNum = 0, outNum = 0;
+    EdgeVertex verts[4];
+    int k;
+
+    for ( k = 0; k <= dimension; k++ )
+    {
+        if ( vals[k] >= iso )
+            in[inNum++] = k;
+        else
+            out[outNum++] = k;
+    }
+    if ( inNum == 0 || outNum == 0 )
+        return;
+
+    // edges crossed by the surface, the first 
+    // node of each edge is inside of the fluid
+    int edges[4][2];
+    int edgesNum = 0;
+    for ( int i = 0; i < inNum; i++ )
+        for ( int j = 0; j < outNum; j++ )
+        {
+            edges[edgesNum][0] = in[i];
+            edges[edgesNum][1] = out[j];
+            edgesNum++;
+        }
+    // quadrilateral, the edges go around it
+    if ( edgesNum == 4 )
+    {
+        int tmp[2] = { edges[2][0], edges[2][1] };
+        edges[2][0] = edges[3][0];
+        edges[2][1] = edges[3][1];
+        edges[3][0] = tmp[0];
+        edges[3][1] = tmp[1];
+    }
+    for ( k = 0; k < edgesNum; k++ )
+        getEdgeVertex( lattice, nodes[edges[k][0]], vals[edges[k][0]], 
+                       nodes[edges[k][1]], vals[edges[k][1]], iso, verts[k]);
+
+    // direction out of the fluid
+    float dir[3];
+    for ( k = 0; k < 3; k++ )
+        dir[k] = (float)(nodes[edges[0][1]][k] - nodes[edges[0][0]][k]);
+
+    // elements - segment, triangle or two triangles
+    int elemsNum = (edgesNum == 4) ? 2 : 1;
+    for ( int e = 0; e < elemsNum; e++ )
+    {
+        EdgeVertex v0 = verts[0];
+        EdgeVertex v1 = verts[e + 1];
+        EdgeVertex v2 = verts[(e + 2) % edgesNum];
+        float a[3], b[3], norm[3];
+        for ( k = 0; k < 3; k++ )
+        {
+            a[k] = v1.pos[k] - v0.pos[k];
+            b[k] = v2.pos[k] - v0.pos[k];
+        }
+        if ( dimension == 3 )
+        {
+            norm[0] = a[1] * b[2] - a[2] * b[1];
+            norm[1] = a[2] * b[0] - a[0] * b[2];
+            norm[2] = a[0] * b[1] - a[1] * b[0];
+        }
+        else
+        {
+            norm[0] = a[1];
+            norm[1] = -a[0];
+            norm[2] = 0.0f;
+        }
+        char flip = (norm[0] * dir[0] + norm[1] * dir[1] + 
+                     norm[2] * dir[2] < 0.0f);
+        elemVerts.push_back( v0);
+        if ( dimension == 3 )
+        {
+            elemVerts.push_back( flip ? v2 : v1);
+            elemVerts.push_back( flip ? v1 : v2);
+        }
+        else
+        {
+            // the segment is v0-v1
+            if ( flip )
+                elemVerts.back() = v1;
+            elemVerts.push_back( flip ? v0 : v1);
+        }
+    }
+
+    return;
+} // extractSimplex
+
+// Returns vertex 'vert' where the color field is equal to 'iso' on the 
+// edge between nodes 'node1' and 'node2' of the lattice. The vertex is 
+// calculated from the node with the lower index, so the same vertex is 
+// produced by every block which shares the edge.
+void
+Surface::getEdgeVertex( const Lattice &lattice,   // lattice
+                        const int *node1,         // first node
+                        float val1,               // value at it
+                        const int *node2,         // second node
+                        float val2,               // value at it
+                        float iso,                // iso value
+                        EdgeVertex &vert)         // vertex
+{
+    const int *dims = lattice.nodesDims;
+    unsigned long long idx1, idx2;
+    int d;
+
+    idx1 = ((unsigned long long)node1[2] * dims[1] + node1[1]) * dims[0] + 
+           node1[0];
+    idx2 = ((unsigned long long)node2[2] * dims[1] + node2[1]) * dims[0] + 
+           node2[0];
+    if ( idx2 < idx1 )
+    {
+        const int *node = node1;
+        node1 = node2;
+        node2 = node;
+        float val = val1;
+        val1 = val2;
+        val2 = val;
+        idx1 = idx2;
+    }
+
+    // edge is identified by the first node and the direction
+    int dir = 0;
+    for ( d = 2; d >= 0; d-- )
+        dir = dir * 3 + (node2[d] - node1[d] + 1);
+    vert.key = idx1 * 27 + dir;
+
+    float t = (val2 != val1) ? (iso - val1) / (val2 - val1) : 0.5f;
+    for ( d = 0; d < 3; d++ )
+    {
+        float p1 = lattice.origin[d] + node1[d] * lattice.spacing;
+        float p2 = lattice.origin[d] + node2[d] * lattice.spacing;
+        vert.pos[d] = (d < dimension) ? p1 + t * (p2 - p1) : 0.0f;
+    }
+
+    return;
+} // getEdgeVertex
+
+// Write surface of file 'nfile' - vertices 'verts' 
+// and elements 'elems' (indices of vertices).
+int
+Surface::writeSurface( int nfile,                   // number of the file
+                       const vector<float> &verts,  // vertices
+                       const vector<int> &elems)    // elements
+{
+    // open file for writing
+    char ffname[32];
+    sprintf( ffname, "%s_%05d.bin", surfName, nfile);
+    FILE *file = fopen( ffname, "wb");
+    if ( file == NULL )
+        return 1;
+
+    // header and data
+    Header header;
+    memset( &header, 0, sizeof(struct Header));
+    strcpy( header.magic, "YAPSSRF");
+    header.version = 1;
+    header.dimension = dimension;
+    header.vertsNum = (int)verts.size() / 3;
+    header.elemsNum = (int)elems.size() / dimension;
+    int res = 0;
+    if ( fwrite( &header, sizeof(struct Header), 1, file) != 1 )
+        res = 1;
+    if ( res == 0 && !verts.empty() && 
+         fwrite( &verts[0], sizeof(float), verts.size(), file) != 
+         verts.size() )
+        res = 1;
+    if ( res == 0 && !elems.empty() && 
+         fwrite( &elems[0], sizeof(int), elems.size(), file) != 
+         elems.size() )
+        res = 1;
+
+    fclose( file);
+
+    return res;
+} // writeSurface
+
+// Read surface of file 'nfile' - vertices 'verts' (3 floats each) and 
+// elements 'elems' (indices of 'dimension' vertices each). The function 
+// doesn't touch global data. It returns 0 if succeeded and 1 otherwise - 
+// the file can't be read, its counts don't match its size or an element 
+// refers to a missing vertex. Then 'verts' and 'elems' are left empty.
+int
+Surface::readSurface( int nfile,               // number of the file
+                      vector<float> &verts,    // vertices
+                      vector<int> &elems)      // elements
+{
+    // open file for reading
+    char ffname[32];
+    sprintf( ffname, "%s_%05d.bin", surfName, nfile);
+    FILE *file = fopen( ffname, "rb");
+    if ( file == NULL )
+        return 1;
+
+    // size of the file and header
+    Header header;
+    fseek( file, 0, SEEK_END);
+    long long size = (long long)ftell( file);
+    fseek( file, 0, SEEK_SET);
+    verts.clear();
+    elems.clear();
+    if ( fread( &header, sizeof(struct Header), 1, file) != 1 ||
+         memcmp( header.magic, "YAPSSRF", 8) || header.version != 1 || 
+         header.dimension != dimension || 
+         header.vertsNum < 0 || header.elemsNum < 0 ||
+         size != (long long)sizeof(struct Header) + 
+                 3LL * (long long)sizeof(float) * header.vertsNum + 
+                 (long long)sizeof(int) * header.dimension * header.elemsNum )
+    {
+        fclose( file);
+        return 1;
+    }
+
+    // data
+    int res = 0;
+    verts.resize( 3 * (size_t)header.vertsNum);
+    elems.resize( (size_t)header.dimension * header.elemsNum);
+    if ( !verts.empty() && 
+         fread( &verts[0], sizeof(float), verts.size(), file) != 
+         verts.size() )
+        res = 1;
+    if ( res == 0 && !elems.empty() && 
+         fread( &elems[0], sizeof(int), elems.size(), file) != 
+         elems.size() )
+        res = 1;
+
+    fclose( file);
+
+    // indices of the vertices
+    for ( size_t i = 0; res == 0 && i < elems.size(); i++ )
+        if ( elems[i] < 0 || elems[i] >= header.vertsNum )
+            res = 1;
+    if ( res )
+    {
+        verts.clear();
+        elems.clear();
+    }
+
+    return res;
+} // readSurface
\ No newline at end of file
@@ -0,0 +1,55 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_SURFACE_H
+#define YAPS_SURFACE_H
+
+#include "common.h"
+
+// Free surface of the fluid - isosurface of the color field 
+// (triangles in 3D simulation and segments in 2D one)
+class Surface
+{
+
+public:
+
+    // extract surfaces of files 'first'...'last'
+    static int extractFrames( int first, int last, float spacing, 
+                              float iso);
+    // read surface of file 'nfile'
+    static int readSurface( int nfile, vector<float> &verts, 
+                            vector<int> &elems);
+
+private:
+
+    // surface filename
+    static const char* surfName;
+
+    // file's header
+    struct Header;
+    // sparse grid of the color field
+    struct Lattice;
+    // vertex on an edge of the grid
+    struct EdgeVertex;
+
+    // extract surface of particles in the block of the lattice
+    static void extractBlock( const Lattice &lattice, const int *block, 
+                              float iso, vector<EdgeVertex> &elemVerts);
+    // extract surface in the simplex (tetrahedron or triangle)
+    static void extractSimplex( const Lattice &lattice, int (*nodes)[3], 
+                                const float *vals, float iso, 
+                                vector<EdgeVertex> &elemVerts);
+    // vertex on the edge between two nodes of the lattice
+    static void getEdgeVertex( const Lattice &lattice, 
+                               const int *node1, float val1, 
+                               const int *node2, float val2, 
+                               float iso, EdgeVertex &vert);
+    // write surface of file 'nfile'
+    static int writeSurface( int nfile, const vector<float> &verts, 
+                             const vector<int> &elems);
+
+};
+
+#endif // YAPS_SURFACE_H
\ No newline at end of file
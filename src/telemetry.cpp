@@ -0,0 +1,269 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "telemetry.h"
+#include "shmem.h"
+#include "common.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <omp.h>
+#ifdef _WIN32
+#include <process.h>
+#include <direct.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+// prefix of the names of the blocks
+const char* Telemetry::namePrefix = "yaps_sim.";
+
+// block of this process
+TelemetryBlock* Telemetry::block = NULL;
+// time and step of the previous update
+double Telemetry::lastTime = 0.0;
+int    Telemetry::lastStep = 0;
+
+// Create the block of this process if TELEMETRY is set.
+void
+Telemetry::open( int step,      // first step
+                 int nfile)     // number of the next output file
+{
+    char name[64];
+
+    if ( !parameters.telemetry || block != NULL )
+        return;
+
+#ifdef _WIN32
+    int pid = _getpid();
+#else
+    int pid = getpid();
+#endif
+    SharedMemory::getName( namePrefix, pid, name);
+    block = (TelemetryBlock *)SharedMemory::create( name, 
+                                                    sizeof(TelemetryBlock));
+    if ( block == NULL )
+    {
+        printf( "Can't create telemetry block %s\n", name);
+        return;
+    }
+
+    // the block is zeroed on creation
+    beginWrite();
+    strcpy( block->magic, "YAPSTLM");
+    block->version = 1;
+    block->pid = pid;
+    block->state = 0;
+#ifdef _WIN32
+    if ( _getcwd( block->dir, sizeof(block->dir)) == NULL )
+#else
+    if ( getcwd( block->dir, sizeof(block->dir)) == NULL )
+#endif
+        block->dir[0] = '\0';
+    block->particles = (int)particles.size();
+    block->bparticles = (int)bparticles.size();
+    block->threads = omp_get_max_threads();
+    block->step = step;
+    block->nsteps = parameters.nsteps;
+    block->nfile = nfile;
+    block->simTime = step * parameters.timeStep;
+    block->startTime = block->updateTime = (double)time( NULL);
+    getMemory( &block->rssKB, &block->peakRssKB);
+    endWrite();
+
+    lastTime = omp_get_wtime();
+    lastStep = step;
+    printf( "Telemetry is published in %s\n", name);
+
+    return;
+} // open
+
+// Update the block after step, the rates are averaged 
+// over at least half a second to smooth short steps.
+void
+Telemetry::update( int step,    // steps performed
+                   int nfile)   // number of the next output file
+{
+    if ( block == NULL )
+        return;
+
+    double now = omp_get_wtime();
+    char rates = (now - lastTime >= 0.5);
+
+    beginWrite();
+    block->step = step;
+    block->nfile = nfile;
+    block->simTime = step * parameters.timeStep;
+    block->updateTime = (double)time( NULL);
+    if ( rates )
+    {
+        block->stepsPerSec = (step - lastStep) / (now - lastTime);
+        block->updatesPerSec = block->stepsPerSec * particles.size();
+        getMemory( &block->rssKB, &block->peakRssKB);
+    }
+#ifdef YAPS_TIME
+    for ( int p = 0; p < PHASES_NUM; p++ )
+        block->phaseTime[p] = Profiler::getPhaseTime( p);
+#endif
+    endWrite();
+
+    if ( rates )
+    {
+        lastTime = now;
+        lastStep = step;
+    }
+
+    return;
+} // update
+
+// Mark the beginning of writing of an output file.
+void
+Telemetry::startOutput()
+{
+    if ( block == NULL )
+        return;
+
+    beginWrite();
+    block->outputQueue++;
+    endWrite();
+
+    return;
+} // startOutput
+
+// Mark the end of writing of an output file.
+void
+Telemetry::stopOutput()
+{
+    if ( block == NULL )
+        return;
+
+    beginWrite();
+    block->outputQueue--;
+    endWrite();
+
+    return;
+} // stopOutput
+
+// Mark the run finished and remove the block, the readers 
+// which have mapped it still see the final state.
+void
+Telemetry::close()
+{
+    if ( block == NULL )
+        return;
+
+    beginWrite();
+    block->state = 1;
+    block->updateTime = (double)time( NULL);
+    getMemory( &block->rssKB, &block->peakRssKB);
+    endWrite();
+
+    char name[64];
+    SharedMemory::getName( namePrefix, block->pid, name);
+    SharedMemory::destroy( block, sizeof(TelemetryBlock), name);
+    block = NULL;
+
+    return;
+} // close
+
+// Map the block of process 'pid' for reading, the function 
+// returns NULL if there is no such block.
+const TelemetryBlock*
+Telemetry::map( int pid)    // process identifier
+{
+    char name[64];
+    size_t size;
+
+    SharedMemory::getName( namePrefix, pid, name);
+    const TelemetryBlock *addr = 
+        (const TelemetryBlock *)SharedMemory::map( name, &size);
+    if ( addr != NULL && 
+         (size < sizeof(TelemetryBlock) || strcmp( addr->magic, "YAPSTLM")) )
+    {
+        SharedMemory::unmap( addr, size);
+        addr = NULL;
+    }
+
+    return addr;
+} // map
+
+// Unmap the block mapped by 'map'.
+void
+Telemetry::unmap( const TelemetryBlock *block)  // block
+{
+    SharedMemory::unmap( block, sizeof(TelemetryBlock));
+
+    return;
+} // unmap
+
+// Copy consistent state of the block, the function 
+// returns 0 if succeeded and 1 otherwise.
+int
+Telemetry::read( const TelemetryBlock *block,   // block
+                 TelemetryBlock *copy)          // copy
+{
+    for ( int attempt = 0; attempt < 1000; attempt++ )
+    {
+        unsigned int seq = block->seq;
+        if ( seq & 1 )
+            continue;
+        SharedMemory::barrier();
+        memcpy( copy, (const void *)block, sizeof(TelemetryBlock));
+        SharedMemory::barrier();
+        if ( block->seq == seq )
+            return 0;
+    }
+
+    return 1;
+} // read
+
+// Begin writing of the block.
+void
+Telemetry::beginWrite()
+{
+    block->seq++;
+    SharedMemory::barrier();
+
+    return;
+} // beginWrite
+
+// End writing of the block.
+void
+Telemetry::endWrite()
+{
+    SharedMemory::barrier();
+    block->seq++;
+
+    return;
+} // endWrite
+
+// Get resident set size and its peak in KB (0 if unknown).
+void
+Telemetry::getMemory( long *rss,    // resident set size
+                      long *peak)   // peak resident set size
+{
+    *rss = *peak = 0;
+#ifndef _WIN32
+    struct rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage) == 0 )
+        *peak = usage.ru_maxrss;
+#ifdef __linux__
+    FILE *file = fopen( "/proc/self/statm", "r");
+    if ( file != NULL )
+    {
+        long size, pages;
+        if ( fscanf( file, "%ld %ld", &size, &pages) == 2 )
+            *rss = pages * (sysconf( _SC_PAGESIZE) / 1024);
+        fclose( file);
+    }
+#else
+    *rss = *peak;
+#endif
+#endif
+
+    return;
+} // getMemory
\ No newline at end of file
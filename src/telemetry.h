@@ -0,0 +1,81 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_TELEMETRY_H
+#define YAPS_TELEMETRY_H
+
+#include "profile.h"
+
+// Status of a running simulation, it's published in shared memory 
+// named "yaps_sim.<pid>" and updated after each step. The block is 
+// guarded by a sequence number which is odd while the block is being 
+// written, so a reader copies the block and retries if the number 
+// is odd or has been changed.
+struct TelemetryBlock
+{
+    char   magic[8];            // "YAPSTLM"
+    int    version;             // version of the block
+    int    pid;                 // process identifier
+    volatile unsigned int seq;  // sequence number
+    int    state;               // 0 - running, 1 - finished
+    char   dir[256];            // working directory
+    int    particles;           // number of particles
+    int    bparticles;          // number of boundary particles
+    int    threads;             // number of threads
+    int    step;                // steps performed
+    int    nsteps;              // total number of steps
+    int    nfile;               // number of the next output file
+    int    outputQueue;         // output files being written
+    double simTime;             // simulated time
+    double startTime;           // start of the run (seconds since epoch)
+    double updateTime;          // last update (seconds since epoch)
+    double stepsPerSec;         // recent steps per second
+    double updatesPerSec;       // recent particle updates per second
+    double phaseTime[PHASES_NUM];   // total time of the phases (YAPS_TIME)
+    long   rssKB;               // resident set size (KB)
+    long   peakRssKB;           // peak resident set size (KB)
+};
+
+class Telemetry
+{
+
+public:
+
+    // create the block of this process (if TELEMETRY is set)
+    static void open( int step, int nfile);
+    // update the block after step
+    static void update( int step, int nfile);
+    // mark the beginning/end of writing of an output file
+    static void startOutput();
+    static void stopOutput();
+    // mark the run finished and remove the block
+    static void close();
+
+    // map the block of process 'pid' for reading and unmap it
+    static const TelemetryBlock* map( int pid);
+    static void unmap( const TelemetryBlock *block);
+    // copy consistent state of the block, the function 
+    // returns 0 if succeeded and 1 otherwise
+    static int read( const TelemetryBlock *block, TelemetryBlock *copy);
+    // prefix of the names of the blocks
+    static const char* namePrefix;
+
+private:
+
+    // block of this process
+    static TelemetryBlock *block;
+    // time and step of the previous update
+    static double lastTime;
+    static int lastStep;
+
+    // resident set size and its peak (KB)
+    static void getMemory( long *rss, long *peak);
+    // begin/end writing of the block
+    static void beginWrite();
+    static void endWrite();
+
+};
+
+#endif // YAPS_TELEMETRY_H
\ No newline at end of file
@@ -0,0 +1,275 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "traj.h"
+#include "iobin.h"
+#include "common.h"
+#include <cstdio>
+#include <cstring>
+#include <omp.h>
+using namespace std;
+
+// filename
+const char* Traj::trajName = "trajectories.bin";
+// temporary filename
+const char* Traj::tmpName = "trajectories.tmp";
+
+// File's header, it's followed by times of the frames 
+// (framesNum floats) and trajectories (idsNum * framesNum 
+// points, the trajectory of particle 'id' starts from 
+// the point id * framesNum)
+struct Traj::Header
+{
+    char magic[8];      // "YAPSTRJ"
+    int version;        // version of the format
+    int dimension;      // dimension of the simulation
+    int firstFile;      // number of the first file
+    int framesNum;      // number of frames
+    int idsNum;         // number of identifiers (maximum + 1)
+};
+
+// Set the position of 'file' to 'offset' bytes from its beginning, 
+// the offset could be beyond 2 GB (long is 32-bit on Win32). The 
+// function returns 0 if succeeded.
+static int
+seekFile( FILE *file,           // file
+          long long offset)     // offset
+{
+#ifdef _WIN32
+    return _fseeki64( file, offset, SEEK_SET);
+#else
+    return fseeko( file, (off_t)offset, SEEK_SET);
+#endif
+} // seekFile
+
+// Transpose output files from 'first' to 'last' (till the last 
+// existing file if 'last' is negative) to the file of trajectories. 
+// The files are mapped into memory and read in two passes: the first 
+// one finds the last file and the number of identifiers, the second 
+// one scatters the particles of the files in parallel. If the 
+// trajectories fit in 'memSize' MB, the particles are scattered into 
+// them directly. Otherwise they are processed by 
+// chunks of identifiers: the points of each chunk are written frame by 
+// frame to its part of a temporary file, then the parts are read back 
+// one by one, transposed and written. The function returns 0 if 
+// succeeded and 1 otherwise.
+int
+Traj::transpose( int first,     // first file
+                 int last,      // last file
+                 int memSize)   // memory to use (MB)
+{
+    const Particle *prts;
+    int errors = 0;
+    int n, i, f, c;
+
+    // find the last file and the number of identifiers
+    int idsNum = 0;
+    for ( f = first; last < 0 || f <= last; f++ )
+    {
+        if ( IOBin().mapData( f, &prts, &n) )
+            break;
+        for ( i = 0; i < n; i++ )
+            if ( prts[i].id >= idsNum )
+                idsNum = prts[i].id + 1;
+        IOBin().unmapData( prts, n);
+    }
+    if ( f == first || ( last >= 0 && f <= last ) )
+        return 1;
+    last = f - 1;
+
+    int framesNum = last - first + 1;
+    double t = omp_get_wtime();
+
+    // open file for writing
+    FILE *file = fopen( trajName, "wb");
+    if ( file == NULL )
+        return 1;
+
+    // header and times of the frames (see Calc::run)
+    Header header;
+    memset( &header, 0, sizeof(struct Header));
+    strcpy( header.magic, "YAPSTRJ");
+    header.version = 1;
+    header.dimension = dimension;
+    header.firstFile = first;
+    header.framesNum = framesNum;
+    header.idsNum = idsNum;
+    vector<float> times( framesNum);
+    for ( f = first; f <= last; f++ )
+        times[f - first] = (f == 0) ? 0.0f : 
+            (1 + (f - 1) * parameters.outFreq) * parameters.timeStep;
+    if ( fwrite( &header, sizeof(struct Header), 1, file) != 1 ||
+         fwrite( &times[0], sizeof(float), framesNum, file) != 
+         (size_t)framesNum )
+    {
+        fclose( file);
+        return 1;
+    }
+
+    // number of particles in a chunk, a chunk and its 
+    // part of the temporary file are in memory together
+    size_t bytes = (size_t)framesNum * sizeof(struct TrajPoint);
+    int chunkSize = (int)(((size_t)memSize << 20) / bytes);
+    if ( chunkSize < idsNum )
+        chunkSize /= 2;
+    if ( chunkSize < 1 )
+        chunkSize = 1;
+    if ( chunkSize > idsNum )
+        chunkSize = idsNum;
+    int chunksNum = (idsNum + chunkSize - 1) / chunkSize;
+
+    TrajPoint absent;
+    memset( &absent, 0, sizeof(struct TrajPoint));
+    TrajPoints chunk;
+    FILE *tmp = NULL;
+    if ( chunksNum == 1 )
+        chunk.assign( (size_t)idsNum * framesNum, absent);
+    else if ( (tmp = fopen( tmpName, "w+b")) == NULL )
+    {
+        printf( "Can't open %s\n", tmpName);
+        fclose( file);
+        return 1;
+    }
+
+    // scatter particles of each frame
+#pragma omp parallel for schedule(dynamic) private(prts,n,i,c) reduction(+:errors)
+    for ( f = 0; f < framesNum; f++ )
+    {
+        if ( IOBin().mapData( first + f, &prts, &n) )
+        {
+            errors++;
+            continue;
+        }
+        TrajPoints row;
+        if ( chunksNum > 1 )
+            row.assign( idsNum, absent);
+        for ( i = 0; i < n; i++ )
+        {
+            const Particle &prt = prts[i];
+            if ( prt.id < 0 || prt.id >= idsNum )
+                continue;
+            TrajPoint &pnt = (chunksNum == 1) ? 
+                             chunk[(size_t)prt.id * framesNum + f] : 
+                             row[prt.id];
+            pnt.no = prt.no;
+            memcpy( pnt.pos, prt.pos, sizeof(pnt.pos));
+            memcpy( pnt.vel, prt.vel, sizeof(pnt.vel));
+            pnt.dens = prt.dens;
+            pnt.press = prt.press;
+        }
+        IOBin().unmapData( prts, n);
+        if ( chunksNum == 1 )
+            continue;
+
+        // the part of the chunk 'c' holds its points frame by frame
+#pragma omp critical (traj_tmp)
+        for ( c = 0; c < chunksNum; c++ )
+        {
+            int firstId = c * chunkSize;
+            int len = min( chunkSize, idsNum - firstId);
+            long long offset = ((long long)firstId * framesNum + 
+                                (long long)f * len) * sizeof(struct TrajPoint);
+            if ( seekFile( tmp, offset) || 
+                 fwrite( &row[firstId], sizeof(struct TrajPoint), len, tmp) != 
+                 (size_t)len )
+                errors++;
+        }
+    }
+
+    // transpose and write the chunks
+    TrajPoints part;
+    for ( c = 0; c < chunksNum && !errors; c++ )
+    {
+        int firstId = c * chunkSize;
+        int len = min( chunkSize, idsNum - firstId);
+        if ( chunksNum > 1 )
+        {
+            size_t num = (size_t)len * framesNum;
+            part.resize( num);
+            chunk.resize( num);
+            if ( seekFile( tmp, (long long)firstId * framesNum * 
+                                sizeof(struct TrajPoint)) || 
+                 fread( &part[0], sizeof(struct TrajPoint), num, tmp) != num )
+            {
+                errors++;
+                break;
+            }
+            for ( f = 0; f < framesNum; f++ )
+                for ( i = 0; i < len; i++ )
+                    chunk[(size_t)i * framesNum + f] = part[(size_t)f * len + i];
+        }
+        if ( fwrite( &chunk[0], sizeof(struct TrajPoint), chunk.size(), 
+                     file) != chunk.size() )
+            errors++;
+    }
+
+    fclose( file);
+    if ( tmp != NULL )
+    {
+        fclose( tmp);
+        remove( tmpName);
+    }
+
+    t = omp_get_wtime() - t;
+    printf( "trajectories : %d particles, %d frames, chunks of %d "
+            "particles, %.2f s\n", idsNum, framesNum, chunkSize, t);
+
+    return errors ? 1 : 0;
+} // transpose
+
+// Read trajectories of particles from 'firstId' to 'firstId+idsNum-1' 
+// into 'points' - the trajectory of particle 'firstId+k' is stored in 
+// points[k*framesNum]...points[(k+1)*framesNum-1]. The particles are 
+// read by one contiguous read. The function returns 0 if succeeded 
+// and 1 otherwise.
+int
+Traj::readTrajectories( int firstId,             // first particle
+                        int idsNum,              // number of particles
+                        TrajPoints &points,      // trajectories
+                        int *framesNum,          // number of frames
+                        vector<float> *times)    // times of frames
+{
+    // open file for reading
+    FILE *file = fopen( trajName, "rb");
+    if ( file == NULL )
+        return 1;
+
+    // header
+    Header header;
+    if ( fread( &header, sizeof(struct Header), 1, file) != 1 ||
+         strcmp( header.magic, "YAPSTRJ") || header.version != 1 || 
+         firstId < 0 || idsNum < 0 || firstId + idsNum > header.idsNum )
+    {
+        fclose( file);
+        return 1;
+    }
+    *framesNum = header.framesNum;
+
+    // times of the frames
+    vector<float> tms( header.framesNum);
+    int res = 0;
+    if ( header.framesNum > 0 && 
+         fread( &tms[0], sizeof(float), header.framesNum, file) != 
+         (size_t)header.framesNum )
+        res = 1;
+    if ( times != NULL )
+        *times = tms;
+
+    // trajectories
+    size_t num = (size_t)idsNum * header.framesNum;
+    long long offset = (long long)sizeof(struct Header) + 
+                       (long long)header.framesNum * sizeof(float) + 
+                       (long long)firstId * header.framesNum * 
+                       sizeof(struct TrajPoint);
+    points.resize( num);
+    if ( res == 0 && num > 0 && 
+         ( seekFile( file, offset) || 
+           fread( &points[0], sizeof(struct TrajPoint), num, file) != num ) )
+        res = 1;
+
+    fclose( file);
+
+    return res;
+} // readTrajectories
\ No newline at end of file
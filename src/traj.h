@@ -0,0 +1,48 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#ifndef YAPS_TRAJ_H
+#define YAPS_TRAJ_H
+
+#include "common.h"
+
+// Point of a trajectory
+struct TrajPoint
+{
+    int no;              // material number (0 - absent in the frame)
+    float pos[3];        // position (x,y,z)
+    float vel[3];        // velocity vector (Vx,Vy,Vz)
+    float dens;          // density
+    float press;         // pressure
+};
+typedef vector<TrajPoint> TrajPoints;
+
+// Trajectories of particles - output files transposed so that the 
+// points of a particle in all frames are stored contiguously, and 
+// particles follow each other in the order of their identifiers.
+class Traj
+{
+
+public:
+
+    // filename
+    static const char* trajName;
+    // transpose files 'first'...'last', 'memSize' MB of memory is used
+    static int transpose( int first, int last, int memSize);
+    // read trajectories of particles 'firstId'...'firstId+idsNum-1'
+    static int readTrajectories( int firstId, int idsNum, 
+                                 TrajPoints &points, 
+                                 int *framesNum, vector<float> *times);
+
+private:
+
+    // temporary filename
+    static const char* tmpName;
+    // file's header
+    struct Header;
+
+};
+
+#endif // YAPS_TRAJ_H
\ No newline at end of file
@@ -0,0 +1,480 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "io.h"
+#include "iobin.h"
+#include "calc.h"
+#include "kernel.h"
+#include "eos.h"
+#include "common.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <omp.h>
+using namespace std;
+
+// Microbenchmarks of the hot paths of the simulator. The particles 
+// are placed on a jittered lattice with the step PRTS_DISTR, so the 
+// number of neighbors of a particle doesn't depend on the size of 
+// the set, and the boundary particles form a floor under them. Each 
+// benchmark is repeated several times and the best time is taken.
+class Bench
+{
+
+public:
+
+    // set parameters (built-in or from $PARAMS of an input file)
+    static void setParameters( const char *pname);
+    // create synthetic particles
+    static void createParticles( long n);
+    // benchmark kernels
+    static void benchKernels();
+    // benchmark all passes for the current particles
+    static void benchPasses();
+    // open/close results' file
+    static void openResults();
+    static void closeResults();
+
+    // number of repetitions, work per benchmark (pairs or particles)
+    static int reps;
+    static double budget;
+
+private:
+
+    // results' filename and file
+    static const char* resultsName;
+    static FILE *results;
+    // results of the benchmarked calls, they keep 
+    // the calls from being optimized out
+    static volatile float sink;
+    // print and write result
+    static void addResult( const char *name, double items, 
+                           const char *unit, double seconds, double bytes);
+    // time the pair loops over 'rows' particles 'iters' times
+    static double timeFluid( int rows, int iters);
+    static double timeBoundary( int rows, int iters);
+
+};
+
+// number of repetitions and work per benchmark
+int    Bench::reps = 3;
+double Bench::budget = 5.0e7;
+// results
+const char* Bench::resultsName = "bench.csv";
+FILE* Bench::results = NULL;
+volatile float Bench::sink = 0.0f;
+
+// Set parameters, the built-in ones are those of the 3D water column.
+void
+Bench::setParameters( const char *pname)    // input file (NULL - none)
+{
+    dimension = 3;
+    parameters.particlesDistrib = 10.0f;
+    parameters.bparticlesDistrib = 5.0f;
+    parameters.sos = 20.0f;
+    strcpy( parameters.kernelType, "SPLINE");
+    parameters.smoothR = 16.0f;
+    strcpy( parameters.eosType, "DESBRUN");
+    parameters.viscAlpha = 0.05f;
+    parameters.viscBeta = 0.0f;
+    parameters.timeStep = 0.2f;
+
+    if ( pname != NULL )
+    {
+        IO::doReadParticles = 0;
+        IO::doReadBParticles = 0;
+        IO::doReadObstacles = 0;
+        if ( IO().readInput( pname) )
+        {
+            printf( "Can't read parameters from %s\n", pname);
+            exit( 1);
+        }
+    }
+
+    return;
+} // setParameters
+
+// Create 'n' particles on a jittered lattice and the boundary 
+// particles under them. The random numbers are always the same, 
+// so the sets are the same from run to run.
+void
+Bench::createParticles( long n)     // number of particles
+{
+    float distr = parameters.particlesDistrib;
+    float bdistr = parameters.bparticlesDistrib;
+    float dens0 = 0.001f;
+    int side = (int)ceil( pow( (double)n, 1.0 / dimension) - 1.0e-6);
+    int d;
+
+    srand( 12345);
+    particles.resize( n);
+    for ( long i = 0; i < n; i++ )
+    {
+        Particle &p = particles[i];
+        memset( &p, 0, sizeof(p));
+        p.id = (int)i;
+        long k = i;
+        for ( d = 0; d < dimension; d++ )
+        {
+            float jitter = 0.2f * ((float)rand() / RAND_MAX - 0.5f);
+            p.pos[d] = ((float)(k % side) + jitter) * distr;
+            p.vel[d] = p.ivalVel[d] = 0.1f * ((float)rand() / RAND_MAX - 0.5f);
+            k /= side;
+        }
+        p.dens0 = dens0;
+        p.dens = p.ivalDens = 
+            dens0 * (1.0f + 0.01f * ((float)rand() / RAND_MAX - 0.5f));
+        p.mass = dens0 * (float)pow( (double)distr, dimension);
+    }
+
+    // floor under the lattice
+    int bside = (int)(side * distr / bdistr) + 1;
+    bparticles.resize( (dimension == 3) ? (long)bside * bside : bside);
+    for ( long i = 0; i < (long)bparticles.size(); i++ )
+    {
+        BParticle &b = bparticles[i];
+        b.pos[0] = (i % bside) * bdistr;
+        b.pos[1] = -distr;
+        b.pos[2] = (dimension == 3) ? (i / bside) * bdistr : 0.0f;
+    }
+
+    return;
+} // createParticles
+
+// Open results' file.
+void
+Bench::openResults()
+{
+    results = fopen( resultsName, "w");
+    if ( results != NULL )
+        fprintf( results, "benchmark,particles,items,seconds,"
+                          "ns_per_item,gb_per_s\n");
+
+    return;
+} // openResults
+
+// Close results' file.
+void
+Bench::closeResults()
+{
+    if ( results != NULL )
+        fclose( results);
+    results = NULL;
+
+    return;
+} // closeResults
+
+// Print result and write it to the results' file, 'bytes' is 
+// the amount of particles' data passed (0 - not applicable).
+void
+Bench::addResult( const char *name,     // name of the benchmark
+                  double items,         // number of items processed
+                  const char *unit,     // name of an item
+                  double seconds,       // best time
+                  double bytes)         // data passed
+{
+    double ns = 1.0e9 * seconds / items;
+    double gbs = (bytes > 0.0) ? bytes / seconds / 1.0e9 : 0.0;
+
+    printf( "bench : %-18s %9d  %10.3f ns/%-8s", name, 
+            (int)particles.size(), ns, unit);
+    if ( bytes > 0.0 )
+        printf( "  %8.3f GB/s", gbs);
+    printf( "\n");
+
+    if ( results != NULL )
+    {
+        fprintf( results, "%s,%d,%.0f,%.6f,%.6f,", name, 
+                 (int)particles.size(), items, seconds, ns);
+        if ( bytes > 0.0 )
+            fprintf( results, "%.6f", gbs);
+        fprintf( results, "\n");
+    }
+
+    return;
+} // addResult
+
+// Benchmark gradients of the kernels at the points uniformly 
+// distributed inside of their support.
+void
+Bench::benchKernels()
+{
+    const int pointsNum = 1 << 20;
+    float smoothR = parameters.smoothR;
+    vector<float> points( 3 * pointsNum);
+    float grad[3];
+    int d;
+
+    srand( 54321);
+    for ( int i = 0; i < pointsNum; i++ )
+    {
+        float *Rij = &points[3 * i];
+        float r2;
+        do
+        {
+            r2 = 0.0f;
+            for ( d = 0; d < 3; d++ )
+            {
+                Rij[d] = (d < dimension) ? 
+                    2.0f * smoothR * (2.0f * rand() / RAND_MAX - 1.0f) : 0.0f;
+                r2 += Rij[d] * Rij[d];
+            }
+        }
+        while ( r2 > 4.0f * smoothR * smoothR || r2 == 0.0f );
+    }
+
+    KernelBase *kernels[2] = { new KernelSpline(), new KernelSpiky() };
+    const char *names[2] = { "kernel_spline", "kernel_spiky" };
+    int iters = max( 1, (int)(budget / pointsNum));
+    for ( int k = 0; k < 2; k++ )
+    {
+        double best = 0.0;
+        float sum = 0.0f;
+        for ( int r = 0; r < reps; r++ )
+        {
+            double t = omp_get_wtime();
+            for ( int it = 0; it < iters; it++ )
+                for ( int i = 0; i < pointsNum; i++ )
+                    if ( !kernels[k]->getGrad( grad, &points[3 * i]) )
+                        sum += grad[0];
+            t = omp_get_wtime() - t;
+            if ( r == 0 || t < best )
+                best = t;
+        }
+        sink = sum;
+        addResult( names[k], (double)iters * pointsNum, "call", best, 0.0);
+        delete kernels[k];
+    }
+
+    return;
+} // benchKernels
+
+// Time the interactions of the first 'rows' particles 
+// with their neighbors 'iters' times.
+double
+Bench::timeFluid( int rows,     // number of particles
+                  int iters)    // number of iterations
+{
+    int chunksNum = (rows + Calc::chunkSize - 1) / Calc::chunkSize;
+    int c;
+
+    double t = omp_get_wtime();
+    for ( int it = 0; it < iters; it++ )
+    {
+#pragma omp parallel for schedule(dynamic) private(c)
+        for ( c = 0; c < chunksNum; c++ )
+        {
+            int first = c * Calc::chunkSize;
+            Calc::calcFluidForces( first, min( first + Calc::chunkSize, rows));
+        }
+    }
+
+    return omp_get_wtime() - t;
+} // timeFluid
+
+// Time the forces of the neighboring boundary particles 
+// for the first 'rows' particles 'iters' times.
+double
+Bench::timeBoundary( int rows,  // number of particles
+                     int iters) // number of iterations
+{
+    int chunksNum = (rows + Calc::chunkSize - 1) / Calc::chunkSize;
+    int c;
+
+    double t = omp_get_wtime();
+    for ( int it = 0; it < iters; it++ )
+    {
+#pragma omp parallel for schedule(dynamic) private(c)
+        for ( c = 0; c < chunksNum; c++ )
+        {
+            int first = c * Calc::chunkSize;
+            Calc::calcBoundaryForces( first, 
+                                      min( first + Calc::chunkSize, rows));
+        }
+    }
+
+    return omp_get_wtime() - t;
+} // timeBoundary
+
+// Benchmark the passes of a calculation step and input/output for 
+// the current particles. The neighbor lists are built once for all 
+// the particles, the pair loops are limited to the lists of the first 
+// particles ('budget' pairs), the passes over all the particles are 
+// repeated until 'budget' particles are processed.
+void
+Bench::benchPasses()
+{
+    double n = (double)particles.size();
+    double nb = (double)bparticles.size();
+    double psize = (double)sizeof(struct Particle);
+    double bsize = (double)sizeof(struct BParticle);
+    double best = 0.0, t;
+    double pairs;
+    int r, it;
+
+    // neighbor lists (the grids are sorted and the lists are filled)
+    for ( r = 0; r < reps; r++ )
+    {
+        t = omp_get_wtime();
+        Calc::buildNeighbors();
+        t = omp_get_wtime() - t;
+        if ( r == 0 || t < best )
+            best = t;
+    }
+    pairs = (double)Calc::nbrStart.back() + Calc::bnbrStart.back();
+    addResult( "neighbors", n, "particle", best, 
+               n * psize + nb * bsize + pairs * sizeof(int));
+
+    // pair loops
+    pairs = max( 1.0, Calc::nbrStart.back() / max( n, 1.0));
+    int rows = (int)min( n, max( 1.0, budget / pairs));
+    pairs = max( 1.0, (double)Calc::nbrStart[rows]);
+    int iters = max( 1, (int)(budget / pairs));
+    EOSBatchelor().calcPress();
+    for ( r = 0; r < reps; r++ )
+    {
+        t = timeFluid( rows, iters);
+        if ( r == 0 || t < best )
+            best = t;
+    }
+    addResult( "pairs_fluid", iters * pairs, "pair", best, 
+               iters * pairs * psize);
+
+    pairs = max( 1.0, Calc::bnbrStart.back() / max( n, 1.0));
+    rows = (int)min( n, max( 1.0, budget / pairs));
+    pairs = max( 1.0, (double)Calc::bnbrStart[rows]);
+    iters = max( 1, (int)(budget / pairs));
+    for ( r = 0; r < reps; r++ )
+    {
+        t = timeBoundary( rows, iters);
+        if ( r == 0 || t < best )
+            best = t;
+    }
+    addResult( "pairs_boundary", iters * pairs, "pair", best, 
+               iters * pairs * bsize);
+
+    // passes over all the particles, they read and write the particles
+    iters = max( 1, (int)(budget / n));
+    EOSBase *eoses[2] = { new EOSBatchelor(), new EOSDesbrun() };
+    const char *names[2] = { "eos_batchelor", "eos_desbrun" };
+    for ( int e = 0; e < 2; e++ )
+    {
+        for ( r = 0; r < reps; r++ )
+        {
+            t = omp_get_wtime();
+            for ( it = 0; it < iters; it++ )
+                eoses[e]->calcPress();
+            t = omp_get_wtime() - t;
+            if ( r == 0 || t < best )
+                best = t;
+        }
+        addResult( names[e], iters * n, "particle", best, 
+                   2.0 * iters * n * psize);
+        delete eoses[e];
+    }
+
+    // the particles move away, but it doesn't change the work
+    for ( r = 0; r < reps; r++ )
+    {
+        t = omp_get_wtime();
+        for ( it = 0; it < iters; it++ )
+            Calc::leapfrogIntegration();
+        t = omp_get_wtime() - t;
+        if ( r == 0 || t < best )
+            best = t;
+    }
+    addResult( "leapfrog", iters * n, "particle", best, 
+               2.0 * iters * n * psize);
+
+    // output file (read back from the page cache)
+    Particles prts;
+    double tread = 0.0;
+    for ( r = 0; r < reps; r++ )
+    {
+        t = omp_get_wtime();
+        IOBin().writeData( 0);
+        t = omp_get_wtime() - t;
+        if ( r == 0 || t < best )
+            best = t;
+        t = omp_get_wtime();
+        IOBin().readData( 0, prts);
+        t = omp_get_wtime() - t;
+        if ( r == 0 || t < tread )
+            tread = t;
+    }
+    addResult( "iobin_write", n, "particle", best, n * psize);
+    addResult( "iobin_read", n, "particle", tread, n * psize);
+
+    char ffname[20];
+    sprintf( ffname, "%s_%05d.bin", IOBin::fname, 0);
+    remove( ffname);
+
+    return;
+} // benchPasses
+
+// Usage:
+//   yaps_bench [-min <n>] [-max <n>]  - benchmark the sets of 10^3..10^6 
+//              [-dim <2|3>]             particles (powers of 10), 
+//              [-budget <pairs>]        'budget' pairs or particles per 
+//              [-reps <n>]              benchmark (5e7), best of 'reps' 
+//              [-params <input>]        runs (3), parameters of the 3D 
+//                                       water column or from $PARAMS
+//                                       of 'input', results are written 
+//                                       to bench.csv
+int
+main( int argc, char **argv)
+{
+    const char *pname = NULL;
+    double nmin = 1.0e3, nmax = 1.0e6;
+    int dim = 0;
+
+    // parse command line
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( !strcmp( argv[i], "-min") && i + 1 < argc )
+            nmin = atof( argv[++i]);
+        else if ( !strcmp( argv[i], "-max") && i + 1 < argc )
+            nmax = atof( argv[++i]);
+        else if ( !strcmp( argv[i], "-dim") && i + 1 < argc )
+            dim = atoi( argv[++i]);
+        else if ( !strcmp( argv[i], "-budget") && i + 1 < argc )
+            Bench::budget = atof( argv[++i]);
+        else if ( !strcmp( argv[i], "-reps") && i + 1 < argc )
+            Bench::reps = max( 1, atoi( argv[++i]));
+        else if ( !strcmp( argv[i], "-params") && i + 1 < argc )
+            pname = argv[++i];
+        else
+        {
+            printf( "Usage: %s [-min <n>] [-max <n>] [-dim <2|3>] "
+                    "[-budget <pairs>] [-reps <n>] [-params <input>]\n", 
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    Bench::setParameters( pname);
+    if ( dim == 2 || dim == 3 )
+        dimension = dim;
+    IOBin::fname = "bench";
+
+    // kernel and EOS are chosen by the parameters
+    Calc calc;
+    printf( "bench : dimension %d, kernel %s, %d threads, best of %d, "
+            "particle %d bytes\n", dimension, parameters.kernelType, 
+            omp_get_max_threads(), Bench::reps, (int)sizeof(struct Particle));
+
+    Bench::openResults();
+    Bench::benchKernels();
+    for ( double n = nmin; n <= nmax * 1.001; n *= 10.0 )
+    {
+        Bench::createParticles( (long)n);
+        Bench::benchPasses();
+    }
+    Bench::closeResults();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "io.h"
+#include "iobin.h"
+#include "common.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+using namespace std;
+
+// Usage:
+//   yaps_cmp <file> <reference> [-tol <t>]
+// Compare output file with reference one, the particles are matched 
+// by their identifiers. The differences of positions are relative to 
+// PRTS_DISTR of 'input', the differences of velocities are relative to 
+// the maximum speed of the reference and the differences of densities 
+// are relative to the initial densities. The program fails if a 
+// difference is greater than 't' (1e-3 by default).
+int
+main( int argc, char **argv)
+{
+    const char *name = NULL, *rname = NULL;
+    float tol = 1.0e-3f;
+
+    // parse command line
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( !strcmp( argv[i], "-tol") && i + 1 < argc )
+            tol = (float)atof( argv[++i]);
+        else if ( name == NULL && argv[i][0] != '-' )
+            name = argv[i];
+        else if ( rname == NULL && argv[i][0] != '-' )
+            rname = argv[i];
+        else
+        {
+            name = NULL;
+            break;
+        }
+    }
+    if ( name == NULL || rname == NULL )
+    {
+        printf( "Usage: %s <file> <reference> [-tol <t>]\n", argv[0]);
+        return 2;
+    }
+
+    // read input
+    IO::doReadParticles = 0;
+    IO::doReadBParticles = 0;
+    IO::doReadObstacles = 0;
+    IO().readInput();
+
+    Particles prts, refs;
+    if ( IOBin().readData( name, prts) || IOBin().readData( rname, refs) )
+    {
+        printf( "Can't read %s or %s\n", name, rname);
+        return 2;
+    }
+    if ( prts.size() != refs.size() )
+    {
+        printf( "%s : %d particles, reference %d\n", name, 
+                (int)prts.size(), (int)refs.size());
+        return 1;
+    }
+
+    // reference particles by identifiers
+    int n = (int)refs.size();
+    vector<int> byId( n, -1);
+    float vmax = 0.0f;
+    for ( int i = 0; i < n; i++ )
+    {
+        if ( refs[i].id >= 0 && refs[i].id < n )
+            byId[refs[i].id] = i;
+        float v = 0.0f;
+        for ( int d = 0; d < dimension; d++ )
+            v += refs[i].vel[d] * refs[i].vel[d];
+        if ( sqrt( v) > vmax )
+            vmax = sqrt( v);
+    }
+    if ( vmax <= 0.0f )
+        vmax = 1.0f;
+
+    // maximum differences
+    float dpos = 0.0f, dvel = 0.0f, ddens = 0.0f;
+    for ( int i = 0; i < n; i++ )
+    {
+        int id = prts[i].id;
+        if ( id < 0 || id >= n || byId[id] < 0 )
+        {
+            printf( "%s : particle %d isn't in the reference\n", name, id);
+            return 1;
+        }
+        const Particle &p = prts[i], &r = refs[byId[id]];
+        float dp = 0.0f, dv = 0.0f;
+        for ( int d = 0; d < dimension; d++ )
+        {
+            dp += (p.pos[d] - r.pos[d]) * (p.pos[d] - r.pos[d]);
+            dv += (p.vel[d] - r.vel[d]) * (p.vel[d] - r.vel[d]);
+        }
+        dp = sqrt( dp) / parameters.particlesDistrib;
+        dv = sqrt( dv) / vmax;
+        float dd = fabs( p.dens - r.dens) / r.dens0;
+        if ( dp > dpos || dp != dp )
+            dpos = dp;
+        if ( dv > dvel || dv != dv )
+            dvel = dv;
+        if ( dd > ddens || dd != dd )
+            ddens = dd;
+    }
+
+    // NaN fails too
+    char ok = (dpos <= tol && dvel <= tol && ddens <= tol);
+    printf( "%s : %d particles, max differences: position %.3g, "
+            "velocity %.3g, density %.3g (tolerance %g) %s\n", name, n, 
+            dpos, dvel, ddens, tol, ok ? "ok" : "FAILED");
+
+    return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "telemetry.h"
+#include "shmem.h"
+#include "profile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+using namespace std;
+
+// Returns state of the simulation as a string, the process 
+// could have died without removing its block.
+static const char*
+getState( const TelemetryBlock *status)     // status of the simulation
+{
+    if ( status->state == 1 )
+        return "finished";
+    if ( !SharedMemory::isAlive( status->pid) )
+        return "dead";
+    if ( (double)time( NULL) - status->updateTime > 60.0 )
+        return "stalled";
+
+    return "running";
+} // getState
+
+// Returns estimated time to the end of the run in seconds.
+static double
+getETA( const TelemetryBlock *status)       // status of the simulation
+{
+    if ( status->stepsPerSec <= 0.0 || status->step >= status->nsteps )
+        return 0.0;
+
+    return (status->nsteps - status->step) / status->stepsPerSec;
+} // getETA
+
+// Print one line for each simulation.
+static void
+printList( vector<TelemetryBlock> &list)    // simulations
+{
+    printf( "%7s %-8s %17s %10s %8s %10s %8s %8s  %s\n", "pid", "state", 
+            "step", "time", "steps/s", "updates/s", "RSS MB", "ETA", "dir");
+    for ( int i = 0; i < (int)list.size(); i++ )
+    {
+        TelemetryBlock &s = list[i];
+        char progress[32];
+        sprintf( progress, "%d/%d", s.step, s.nsteps);
+        double eta = getETA( &s);
+        printf( "%7d %-8s %17s %10.2f %8.2f %10.3g %8.1f %5d:%02d  %s\n", 
+                s.pid, getState( &s), progress, s.simTime, s.stepsPerSec, 
+                s.updatesPerSec, s.rssKB / 1024.0, 
+                (int)(eta / 60.0), (int)eta % 60, s.dir);
+    }
+
+    return;
+} // printList
+
+// Print full status of the simulation.
+static void
+printStatus( const TelemetryBlock *s)       // status of the simulation
+{
+    double total = 0.0;
+    int p;
+
+    printf( "pid        : %d (%s)\n", s->pid, getState( s));
+    printf( "directory  : %s\n", s->dir);
+    printf( "particles  : %d / %d boundary, %d threads\n", s->particles, 
+            s->bparticles, s->threads);
+    printf( "step       : %d of %d (%.1f %%), time %.3f\n", s->step, 
+            s->nsteps, s->nsteps ? 100.0 * s->step / s->nsteps : 0.0, 
+            s->simTime);
+    printf( "rate       : %.3f steps/s, %.4g particle updates/s, "
+            "ETA %.0f s\n", s->stepsPerSec, s->updatesPerSec, getETA( s));
+    printf( "output     : next file %d, %d being written\n", s->nfile, 
+            s->outputQueue);
+    printf( "memory     : %.1f MB, peak %.1f MB\n", s->rssKB / 1024.0, 
+            s->peakRssKB / 1024.0);
+    printf( "running    : %.0f s, updated %.0f s ago\n", 
+            s->updateTime - s->startTime, (double)time( NULL) - s->updateTime);
+    for ( p = 0; p < PHASES_NUM; p++ )
+        total += s->phaseTime[p];
+    if ( total <= 0.0 )
+        return;
+    for ( p = 0; p < PHASES_NUM; p++ )
+        printf( "phase      : %-12s %10.3f s %5.1f %%\n", Profiler::phaseNames[p], 
+                s->phaseTime[p], 100.0 * s->phaseTime[p] / total);
+
+    return;
+} // printStatus
+
+// Find the simulations which have published their status, 
+// 'clean' removes the blocks of the dead processes.
+static void
+findSimulations( vector<TelemetryBlock> &list,  // simulations
+                 char clean)                    // remove dead ones
+{
+    vector<int> pids;
+    SharedMemory::list( Telemetry::namePrefix, pids);
+    list.clear();
+    for ( int i = 0; i < (int)pids.size(); i++ )
+    {
+        const TelemetryBlock *block = Telemetry::map( pids[i]);
+        TelemetryBlock status;
+        if ( block == NULL || Telemetry::read( block, &status) )
+        {
+            Telemetry::unmap( block);
+            continue;
+        }
+        Telemetry::unmap( block);
+        if ( clean && !SharedMemory::isAlive( status.pid) )
+        {
+            char name[64];
+            SharedMemory::getName( Telemetry::namePrefix, pids[i], name);
+            SharedMemory::unlink( name);
+            printf( "Removed %s\n", name);
+            continue;
+        }
+        list.push_back( status);
+    }
+
+    return;
+} // findSimulations
+
+// Usage:
+//   yaps_mon [-watch <s>]          - list the running simulations (Linux)
+//   yaps_mon <pid> [-watch <s>]    - status of simulation 'pid'
+//   yaps_mon -clean                - remove blocks of dead simulations
+// The status is published by yaps_sim if TELEMETRY is set, '-watch' 
+// refreshes the screen each 's' seconds.
+int
+main( int argc, char **argv)
+{
+    int pid = 0;
+    int watch = 0;
+    char clean = 0;
+
+    // parse command line
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( !strcmp( argv[i], "-watch") && i + 1 < argc )
+            watch = atoi( argv[++i]);
+        else if ( !strcmp( argv[i], "-clean") )
+            clean = 1;
+        else if ( argv[i][0] != '-' && atoi( argv[i]) > 0 )
+            pid = atoi( argv[i]);
+        else
+        {
+            printf( "Usage: %s [<pid>] [-watch <seconds>] [-clean]\n", 
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    const TelemetryBlock *block = NULL;
+    if ( pid > 0 )
+    {
+        block = Telemetry::map( pid);
+        if ( block == NULL )
+        {
+            printf( "No status of process %d\n", pid);
+            return 1;
+        }
+    }
+
+    for ( ; ; )
+    {
+        if ( watch > 0 )
+            printf( "\033[H\033[2J");
+        if ( block != NULL )
+        {
+            TelemetryBlock status;
+            if ( Telemetry::read( block, &status) )
+                printf( "Can't read status of process %d\n", pid);
+            else
+            {
+                printStatus( &status);
+                if ( status.state == 1 )
+                    break;
+            }
+        }
+        else
+        {
+            vector<TelemetryBlock> list;
+            findSimulations( list, clean);
+            if ( list.empty() )
+                printf( "No simulations found\n");
+            else
+                printList( list);
+        }
+        if ( watch <= 0 )
+            break;
+        fflush( stdout);
+#ifdef _WIN32
+        Sleep( watch * 1000);
+#else
+        sleep( watch);
+#endif
+    }
+    Telemetry::unmap( block);
+
+    return 0;
+}
\ No newline at end of file
@@ -1,32 +1,341 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#include "io.h"
-#include "iobin.h"
-#include "render.h"
-#include "common.h"
-#include <cstdio>
-using namespace std;
-
-int
-main( int argc, char **argv)
-{
-    // read input
-    IO::doReadParticles = 0;
-    IO::doReadBParticles = 0;
-    IO().readInput();
-
-    // read initial state
-    IOBin().readData( 0);
-
-    printf( "Numbers of particles (smooth / boundary / total) : %d / %d / %d\n", 
-        (int)particles.size(), (int)bparticles.size(), 
-        (int)particles.size() + (int)bparticles.size());
-
-    // run renderer
-    Render( argc, argv).run();
-
-    return 0;
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "io.h"
+#include "iobin.h"
+#include "render.h"
+#include "softrender.h"
+#include "stats.h"
+#include "traj.h"
+#include "resample.h"
+#include "surface.h"
+#include "framering.h"
+#include "common.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+using namespace std;
+
+// Usage:
+//   yaps_post                        - interactive renderer
+//   yaps_post -export [first [last]] - render frames to images without 
+//             [-scale <s>]             display, in parallel (all frames 
+//             [-rotate <x> <y>]        by default)
+//             [-size <w> <h>]
+//             [-interp]                - with in-between frames (INTERP_STEPS 
+//                                        for each interval between frames)
+//   yaps_post -stats [first [last]]  - write statistics of frames to 
+//             [-bins <n>] [-json]      stats.csv (or stats.json)
+//   yaps_post -traj [first [last]]   - transpose frames to trajectories 
+//             [-mem <MB>]              of particles (trajectories.bin)
+//   yaps_post -path <id> [<num>]     - print trajectories of particles 
+//                                      'id'...'id+num-1'
+//   yaps_post -grid [first [last]]   - resample fields of particles to 
+//             [-spacing <h>]           regular grids (grid_*.vtk), the 
+//             [-box <lower> <upper>]   clipping volume with the step 
+//             [-raw]                   PRTS_DISTR by default
+//   yaps_post -surface [first [last]] - extract free surfaces of the fluid 
+//             [-spacing <h>]           (surface_*.bin), the lattice step 
+//             [-iso <value>]           is PRTS_DISTR/2 and the iso value 
+//                                      of the color field is 0.5 by default
+//   yaps_post -live [<pid>]          - show frames of the running simulation 
+//                                      (LIVE_FRAMES) started in the current 
+//                                      directory or of process 'pid'
+int
+main( int argc, char **argv)
+{
+    // read input
+    IO::doReadParticles = 0;
+    IO::doReadBParticles = 0;
+    IO().readInput();
+
+    if ( argc > 1 && !strcmp( argv[1], "-export") )
+    {
+        int first = 0, last = -1;
+        float scale = 1.0f, xrot = 0.0f, yrot = 0.0f;
+        int width = 800, height = 800;
+        int steps = 1;
+        int i = 2;
+
+        // parse command line
+        if ( i < argc && argv[i][0] != '-' )
+            first = atoi( argv[i++]);
+        if ( i < argc && argv[i][0] != '-' )
+            last = atoi( argv[i++]);
+        for ( ; i < argc; i++ )
+        {
+            if ( !strcmp( argv[i], "-scale") && i + 1 < argc )
+                scale = (float)atof( argv[++i]);
+            else if ( !strcmp( argv[i], "-rotate") && i + 2 < argc )
+            {
+                xrot = (float)atof( argv[++i]);
+                yrot = (float)atof( argv[++i]);
+            }
+            else if ( !strcmp( argv[i], "-size") && i + 2 < argc )
+            {
+                width = atoi( argv[++i]);
+                height = atoi( argv[++i]);
+            }
+            else if ( !strcmp( argv[i], "-interp") )
+                steps = (parameters.interpSteps > 1) ? 
+                        parameters.interpSteps : 4;
+            else
+            {
+                printf( "Unknown option %s\n", argv[i]);
+                return 1;
+            }
+        }
+
+        // render frames to images
+        int errors = SoftRender( scale, xrot, yrot, width, height).
+                     exportFrames( first, last, steps);
+        if ( errors )
+            printf( "%d frames haven't been rendered\n", errors);
+
+        return errors ? 1 : 0;
+    }
+
+    if ( argc > 1 && !strcmp( argv[1], "-stats") )
+    {
+        int first = 0, last = -1;
+        int binsNum = 16;
+        char json = 0;
+        int i = 2;
+
+        // parse command line
+        if ( i < argc && argv[i][0] != '-' )
+            first = atoi( argv[i++]);
+        if ( i < argc && argv[i][0] != '-' )
+            last = atoi( argv[i++]);
+        for ( ; i < argc; i++ )
+        {
+            if ( !strcmp( argv[i], "-bins") && i + 1 < argc )
+                binsNum = atoi( argv[++i]);
+            else if ( !strcmp( argv[i], "-json") )
+                json = 1;
+            else
+            {
+                printf( "Unknown option %s\n", argv[i]);
+                return 1;
+            }
+        }
+        if ( binsNum < 1 )
+            binsNum = 1;
+
+        // scan frames
+        int errors = Stats().scanFrames( first, last, binsNum, json);
+        if ( errors )
+            printf( "%d frames haven't been scanned\n", errors);
+
+        return errors ? 1 : 0;
+    }
+
+    if ( argc > 1 && !strcmp( argv[1], "-traj") )
+    {
+        int first = 0, last = -1;
+        int memSize = 256;
+        int i = 2;
+
+        // parse command line
+        if ( i < argc && argv[i][0] != '-' )
+            first = atoi( argv[i++]);
+        if ( i < argc && argv[i][0] != '-' )
+            last = atoi( argv[i++]);
+        for ( ; i < argc; i++ )
+        {
+            if ( !strcmp( argv[i], "-mem") && i + 1 < argc )
+                memSize = atoi( argv[++i]);
+            else
+            {
+                printf( "Unknown option %s\n", argv[i]);
+                return 1;
+            }
+        }
+
+        // transpose frames
+        if ( Traj().transpose( first, last, memSize) )
+        {
+            printf( "Can't write trajectories\n");
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if ( argc > 2 && !strcmp( argv[1], "-path") )
+    {
+        int firstId = atoi( argv[2]);
+        int idsNum = (argc > 3) ? atoi( argv[3]) : 1;
+        TrajPoints points;
+        vector<float> times;
+        int framesNum;
+
+        // read trajectories
+        if ( Traj().readTrajectories( firstId, idsNum, points, 
+                                      &framesNum, &times) )
+        {
+            printf( "Can't read trajectories\n");
+            return 1;
+        }
+
+        // print them
+        printf( "id,time,x,y,z,vx,vy,vz,density,pressure\n");
+        for ( int k = 0; k < idsNum; k++ )
+        {
+            for ( int f = 0; f < framesNum; f++ )
+            {
+                const TrajPoint &pnt = points[k * framesNum + f];
+                if ( pnt.no == 0 )
+                    continue;
+                printf( "%d,%g,%g,%g,%g,%g,%g,%g,%g,%g\n", 
+                        firstId + k, times[f], 
+                        pnt.pos[0], pnt.pos[1], pnt.pos[2], 
+                        pnt.vel[0], pnt.vel[1], pnt.vel[2], 
+                        pnt.dens, pnt.press);
+            }
+        }
+
+        return 0;
+    }
+
+    if ( argc > 1 && !strcmp( argv[1], "-grid") )
+    {
+        int first = 0, last = -1;
+        float spacing = parameters.particlesDistrib;
+        float lower[3] = { 0.0f, 0.0f, 0.0f };
+        float upper[3];
+        char raw = 0;
+        int i = 2, d;
+
+        for ( d = 0; d < 3; d++ )
+            upper[d] = (d < dimension) ? parameters.clipVolume : 0.0f;
+
+        // parse command line
+        if ( i < argc && argv[i][0] != '-' )
+            first = atoi( argv[i++]);
+        if ( i < argc && argv[i][0] != '-' )
+            last = atoi( argv[i++]);
+        for ( ; i < argc; i++ )
+        {
+            if ( !strcmp( argv[i], "-spacing") && i + 1 < argc )
+                spacing = (float)atof( argv[++i]);
+            else if ( !strcmp( argv[i], "-box") && i + 2 * dimension < argc )
+            {
+                for ( d = 0; d < dimension; d++ )
+                    lower[d] = (float)atof( argv[++i]);
+                for ( d = 0; d < dimension; d++ )
+                    upper[d] = (float)atof( argv[++i]);
+            }
+            else if ( !strcmp( argv[i], "-raw") )
+                raw = 1;
+            else
+            {
+                printf( "Unknown option %s\n", argv[i]);
+                return 1;
+            }
+        }
+
+        // resample frames
+        int errors = Resample().resampleFrames( first, last, spacing, 
+                                                lower, upper, raw);
+        if ( errors )
+            printf( "%d frames haven't been resampled\n", errors);
+
+        return errors ? 1 : 0;
+    }
+
+    if ( argc > 1 && !strcmp( argv[1], "-surface") )
+    {
+        int first = 0, last = -1;
+        float spacing = parameters.particlesDistrib / 2.0f;
+        float iso = 0.5f;
+        int i = 2;
+
+        // parse command line
+        if ( i < argc && argv[i][0] != '-' )
+            first = atoi( argv[i++]);
+        if ( i < argc && argv[i][0] != '-' )
+            last = atoi( argv[i++]);
+        for ( ; i < argc; i++ )
+        {
+            if ( !strcmp( argv[i], "-spacing") && i + 1 < argc )
+                spacing = (float)atof( argv[++i]);
+            else if ( !strcmp( argv[i], "-iso") && i + 1 < argc )
+                iso = (float)atof( argv[++i]);
+            else
+            {
+                printf( "Unknown option %s\n", argv[i]);
+                return 1;
+            }
+        }
+
+        // extract surfaces
+        int errors = Surface().extractFrames( first, last, spacing, iso);
+        if ( errors )
+            printf( "%d frames haven't been processed\n", errors);
+
+        return errors ? 1 : 0;
+    }
+
+    // attach to the frames of the running simulation
+    char live = 0;
+    if ( argc > 1 && !strcmp( argv[1], "-live") )
+    {
+        int pid = (argc > 2) ? atoi( argv[2]) : 0;
+        if ( FrameRing::attach( pid) )
+        {
+            printf( "No live frames found\n");
+            return 1;
+        }
+        live = 1;
+    }
+
+    // read initial state, the simulation could publish the live frames 
+    // only (LIVE_ONLY), so they start from the first frame of the ring
+    if ( live )
+    {
+        int nfile, step;
+        if ( FrameRing::readLatest( -1, particles, &nfile, &step) < 0 )
+            printf( "Waiting for the first live frame\n");
+        while ( FrameRing::readLatest( -1, particles, &nfile, &step) < 0 )
+        {
+            if ( FrameRing::isFinished() && 
+                 FrameRing::readLatest( -1, particles, &nfile, &step) < 0 )
+            {
+                printf( "No live frames found\n");
+                FrameRing::detach();
+                return 1;
+            }
+#ifdef _WIN32
+            Sleep( 50);
+#else
+            usleep( 50000);
+#endif
+        }
+    }
+    else if ( IOBin().readData( 0) )
+    {
+        printf( "Can't read the initial state (output_00000.bin)\n");
+        return 1;
+    }
+
+    printf( "Numbers of particles (smooth / boundary / total) : %d / %d / %d\n", 
+        (int)particles.size(), (int)bparticles.size(), 
+        (int)particles.size() + (int)bparticles.size());
+
+    // run renderer
+    Render render( argc, argv);
+    if ( live )
+        render.startLive();
+    render.run();
+    FrameRing::detach();
+
+    return 0;
 }
\ No newline at end of file
@@ -1,31 +1,89 @@
-// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
-// See the file COPYING for copying permission.
-//
-// $Id$
-
-#include "io.h"
-#include "iobin.h"
-#include "calc.h"
-#include "common.h"
-#include <cstdio>
-using namespace std;
-
-int
-main( int argc, char **argv)
-{
-    // read input
-    IO::doReadObstacles = 0;
-    IO().readInput();
-
-    // write initial state
-    IOBin().writeData( 0);
-
-    printf( "Numbers of particles (smooth / boundary / total) : %d / %d / %d\n", 
-        (int)particles.size(), (int)bparticles.size(), 
-        (int)particles.size() + (int)bparticles.size());
-
-    // run simulator
-    Calc().run();
-
-    return 0;
+// Copyright (c) 2008-2010 Yury Mishin <yury.mishin@gmail.com>
+// See the file COPYING for copying permission.
+//
+// $Id$
+
+#include "io.h"
+#include "iobin.h"
+#include "calc.h"
+#include "common.h"
+#include <cstdio>
+#include <cstring>
+using namespace std;
+
+// Usage:
+//   yaps_sim                                  - start from 'input'
+//   yaps_sim -restart <file> [-params <file>] - resume from checkpoint, 
+//                                               parameters could be 
+//                                               changed by $PARAMS section 
+//                                               of another input file
+int
+main( int argc, char **argv)
+{
+    const char *ckname = NULL;
+    const char *pname = NULL;
+    int step = 0;
+    int nfile = 1;
+
+    // parse command line
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( !strcmp( argv[i], "-restart") && i + 1 < argc )
+            ckname = argv[++i];
+        else if ( !strcmp( argv[i], "-params") && i + 1 < argc )
+            pname = argv[++i];
+        else
+        {
+            printf( "Usage: %s [-restart <checkpoint> [-params <input>]]\n", 
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if ( ckname != NULL )
+    {
+        // read the full state
+        if ( IOBin().readCheckpoint( ckname, &step, &nfile) )
+        {
+            printf( "Can't read checkpoint %s\n", ckname);
+            return 1;
+        }
+
+        // change parameters
+        if ( pname != NULL )
+        {
+            int dim = dimension;
+            IO::doReadParticles = 0;
+            IO::doReadBParticles = 0;
+            IO::doReadObstacles = 0;
+            if ( IO().readInput( pname) )
+            {
+                printf( "Can't read parameters from %s\n", pname);
+                return 1;
+            }
+            if ( dimension != dim )
+            {
+                printf( "Dimension can't be changed on restart\n");
+                return 1;
+            }
+        }
+
+        printf( "Restart from %s at step %d\n", ckname, step);
+    }
+    else
+    {
+        // read input
+        IO::doReadObstacles = 0;
+        IO().readInput();
+
+        // write initial state
+        IOBin().writeData( 0);
+    }
+
+    printf( "Numbers of particles (smooth / boundary / total) : %d / %d / %d\n", 
+        (int)particles.size(), (int)bparticles.size(), 
+        (int)particles.size() + (int)bparticles.size());
+
+    // run simulator
+    return Calc().run( step, nfile);
 }
\ No newline at end of file
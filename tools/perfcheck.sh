@@ -0,0 +1,126 @@
+#!/bin/sh
+# $Id$
+#
+# Performance regression check. The scenes _watercolumn2D, 
+# _watercolumn3D and _gutter3D are run for enough steps to take a 
+# second or two each, throughput (particle updates per second, median 
+# of PERF_REPS runs (5), which is robust to the noise of a loaded 
+# machine) and peak RSS are compared with 
+# tools/perfcheck/baseline.txt, and the last output 
+# file of each scene is compared with the reference snapshot 
+# tools/perfcheck/<scene>.bin by yaps_cmp.
+#
+# Usage (from the top directory, after make yaps_sim yaps_cmp):
+#   tools/perfcheck.sh           - check, fails if a scene is slower 
+#                                  than the baseline by more than 
+#                                  PERF_TOL % (10), uses more memory 
+#                                  by more than PERF_RSS_TOL % (20) or 
+#                                  its output differs from the reference 
+#                                  by more than PERF_SNAP_TOL (1e-3)
+#   tools/perfcheck.sh -update   - store new baseline and snapshots
+#
+# The baseline depends on the machine and the compiler, it should be 
+# updated on the machine the checks are run on.
+
+top=$(pwd)
+dir=$top/tools/perfcheck
+work=${PERF_DIR:-perfcheck_run}
+tol=${PERF_TOL:-10}
+rsstol=${PERF_RSS_TOL:-20}
+snaptol=${PERF_SNAP_TOL:-1e-3}
+reps=${PERF_REPS:-5}
+update=0
+[ "$1" = "-update" ] && update=1
+
+# scenes and numbers of steps
+scenes="watercolumn2D:200 watercolumn3D:80 gutter3D:40"
+
+for f in yaps_sim yaps_cmp; do
+    if [ ! -x "$top/$f" ]; then
+        echo "Can't find $f, run make $f" >&2
+        exit 1
+    fi
+done
+
+failed=0
+newbase="$work/baseline.txt"
+mkdir -p "$work"
+echo "# scene  steps  updates_per_second  peak_rss_kb" > "$newbase"
+
+for s in $scenes; do
+    scene=${s%%:*}
+    steps=${s##*:}
+    run="$work/$scene"
+
+    # the last output file is written after the last step
+    rates=
+    rss=0
+    for r in $(seq $reps); do
+        rm -rf "$run" && mkdir -p "$run"
+        sed -e "s/^NSTEPS .*/NSTEPS         $steps/" \
+            -e "s/^OUT_FREQ .*/OUT_FREQ       $((steps - 1))/" \
+            -e "s/^CHKPT_FREQ .*/CHKPT_FREQ     0/" \
+            "$top/_$scene/input" > "$run/input"
+        if ! (cd "$run" && "$top/yaps_sim" > yaps_sim.log 2>&1) || \
+           [ ! -f "$run/timing.json" ]; then
+            echo "$scene : yaps_sim failed (built without YAPS_TIME?)"
+            failed=1
+            continue 2
+        fi
+        set -- $(awk -F'[:,]' '/^  "updates_per_second"/ { u = $2 } 
+                               /^  "peak_rss_kb"/ { m = $2 } 
+                               END { print u + 0, m + 0 }' \
+                 "$run/timing.json")
+        rates="$rates $1"
+        rss=$2
+    done
+    rate=$(echo $rates | tr ' ' '\n' | sort -g | \
+           awk '{ v[NR] = $1 } 
+                END { m = int( (NR + 1) / 2); 
+                      print (NR % 2) ? v[m] : (v[m] + v[m + 1]) / 2 }')
+    last=$(ls "$run"/output_*.bin | tail -1)
+    echo "$scene $steps $rate $rss" >> "$newbase"
+
+    if [ $update = 1 ]; then
+        cp "$last" "$dir/$scene.bin"
+        printf "%-14s %12.4g updates/s %8d KB  stored\n" $scene $rate $rss
+        continue
+    fi
+
+    # throughput and memory
+    set -- $(awk -v s=$scene '$1 == s { print $2, $3, $4 }' "$dir/baseline.txt")
+    if [ $# -ne 3 ]; then
+        echo "$scene : no baseline"
+        failed=1
+        continue
+    fi
+    if [ "$1" != "$steps" ]; then
+        echo "$scene : baseline is for $1 steps, update it"
+        failed=1
+        continue
+    fi
+    awk -v s=$scene -v u=$rate -v m=$rss -v bu=$2 -v bm=$3 \
+        -v tol=$tol -v rsstol=$rsstol 'BEGIN {
+        du = 100.0 * (u - bu) / bu
+        dm = (bm > 0) ? 100.0 * (m - bm) / bm : 0.0
+        ok = (du >= -tol && dm <= rsstol)
+        printf "%-14s %12.4g updates/s (%+6.1f %%) %8d KB (%+6.1f %%)  %s\n", 
+               s, u, du, m, dm, ok ? "ok" : "FAILED"
+        exit !ok
+    }' || failed=1
+
+    # physical output
+    (cd "$run" && "$top/yaps_cmp" "$(basename "$last")" "$dir/$scene.bin" \
+                    -tol $snaptol) || failed=1
+done
+
+if [ $update = 1 ]; then
+    cp "$newbase" "$dir/baseline.txt"
+    echo "perfcheck : baseline and snapshots updated"
+    exit 0
+fi
+if [ $failed = 1 ]; then
+    echo "perfcheck : FAILED"
+    exit 1
+fi
+echo "perfcheck : ok"
@@ -0,0 +1,200 @@
+#!/bin/sh
+# $Id$
+#
+# Strong and weak scaling of yaps_sim on generated dam-break scenes.
+#
+# Usage:
+#   tools/scaling.sh [-sim <yaps_sim>] [-dim <2|3>] [-n <particles>]
+#                    [-steps <n>] [-threads "<t1> <t2> ..."]
+#                    [-mode <strong|weak|both>] [-dir <work dir>]
+#   tools/scaling.sh -gen <dim> <particles> <input>
+#
+# A scene is a column of water (width : height = 1 : 2, as deep as 
+# it is wide in 3D) at the left wall of a tank four times as wide, the 
+# parameters are those of _watercolumn2D/_watercolumn3D. The number of 
+# particles is approximate, the actual one is reported.
+#
+# Strong scaling runs the scene of 'n' particles with each number of 
+# threads, efficiency is T(t1) * t1 / (T(t) * t). Weak scaling runs 
+# the scene of about n * t / t1 particles with t threads, efficiency 
+# is the ratio of the throughputs per thread (U(t) / t) / (U(t1) / t1), 
+# U in particle updates per second, so that it isn't biased by the 
+# difference of the actual numbers of particles. The throughput in pair interactions per second per 
+# thread is given too, the pairs are those inside of the cutoff of all 
+# the steps (pairs.csv). T is the time of the steps measured by 
+# yaps_sim (timing.json), so yaps_sim should be built with YAPS_TIME. 
+# The tables are printed and written to scaling.csv in the work 
+# directory.
+
+sim=./yaps_sim
+dim=2
+n=20000
+steps=20
+threads="1 2 4 8"
+mode=both
+dir=scaling
+
+# Write dam-break input for 'dim' and about 'n' particles to 'file'.
+gen()
+{
+    awk -v dim="$1" -v n="$2" 'BEGIN {
+        # particles along the width of the column
+        if ( dim == 2 ) {
+            d = 5.0; bd = 2.5; h = 18.0; r = 5.0; sos = 25; dt = 0.1; 
+            alpha = 0.01
+            nx = int( sqrt( n / 2.0) + 0.5)
+        } else {
+            d = 10.0; bd = 5.0; h = 16.0; r = 3.5; sos = 20; dt = 0.2; 
+            alpha = 0.05
+            nx = int( (n / 2.0) ^ (1.0 / 3.0) + 0.5)
+        }
+        if ( nx < 2 ) nx = 2
+        w = nx * d; hc = 2 * w
+        # tank
+        x0 = 50.0; x1 = x0 + 4 * w + d; y0 = 50.0; y1 = y0 + 1.5 * hc
+        z0 = 50.0; z1 = z0 + w + d
+        clip = ((x1 > y1) ? x1 : y1) + 50.0
+
+        print "$PARAMS"
+        printf "DIM            %d\n", dim
+        printf "PRTS_DISTR     %.1f\n", d
+        printf "BPRTS_DISTR    %.1f\n", bd
+        printf "PRADIUS        %.1f\n", r
+        printf "SOS            %d\n", sos
+        print  "KERNEL         SPLINE"
+        printf "SMOOTH_LEN     %.1f\n", h
+        print  "EOS            DESBRUN"
+        printf "VISC_ALPHA     %.2f\n", alpha
+        print  "VISC_BETA      0.0"
+        printf "TIME_STEP      %.1f\n", dt
+        print  "NSTEPS         100"
+        print  "OUT_FREQ       100000"
+        printf "CLIP_VOL       %.1f\n", clip
+        print  "$END"
+        print  ""
+        print  "$CLOUDS"
+        if ( dim == 2 )
+            printf "1  0.001  %.1f %.1f  %.1f 0.0  0.0 %.1f  0.0 0.0\n", 
+                   x0 + d, y0 + d, w, hc
+        else
+            printf "1  0.001  %.1f %.1f %.1f  %.1f 0.0 0.0  0.0 %.1f 0.0  " \
+                   "0.0 0.0 %.1f  0.0 0.0 0.0\n", x0 + d, y0 + d, z0 + d, 
+                   w, hc, w - d
+        print  "$END"
+        print  ""
+        print  "$OBSTACLES"
+        if ( dim == 2 ) {
+            printf "2  %.1f %.1f  %.1f %.1f\n", x0, y1, x0, y0
+            printf "2  %.1f %.1f  %.1f %.1f\n", x0, y0, x1, y0
+            printf "2  %.1f %.1f  %.1f %.1f\n", x1, y0, x1, y1
+        } else {
+            # floor, left, right, back and front walls (two triangles each)
+            tri( x0, y0, z0,  x1, y0, z0,  x1, y0, z1)
+            tri( x0, y0, z0,  x1, y0, z1,  x0, y0, z1)
+            tri( x0, y0, z0,  x0, y1, z0,  x0, y1, z1)
+            tri( x0, y0, z0,  x0, y1, z1,  x0, y0, z1)
+            tri( x1, y0, z0,  x1, y1, z0,  x1, y1, z1)
+            tri( x1, y0, z0,  x1, y1, z1,  x1, y0, z1)
+            tri( x0, y0, z0,  x1, y0, z0,  x1, y1, z0)
+            tri( x0, y0, z0,  x1, y1, z0,  x0, y1, z0)
+            tri( x0, y0, z1,  x1, y0, z1,  x1, y1, z1)
+            tri( x0, y0, z1,  x1, y1, z1,  x0, y1, z1)
+        }
+        print  "$END"
+    }
+    function tri( ax, ay, az, bx, by, bz, cx, cy, cz)
+    {
+        printf "2   %.1f %.1f %.1f  %.1f %.1f %.1f  %.1f %.1f %.1f\n", 
+               ax, ay, az, bx, by, bz, cx, cy, cz
+    }' > "$3"
+}
+
+# Run the scene of about 'n' particles with 't' threads in 'rundir', 
+# print "particles seconds updates_per_second pairs".
+run()
+{
+    mkdir -p "$3"
+    gen $dim $1 "$3/input"
+    sed -i.bak -e "s/^NSTEPS .*/NSTEPS         $steps/" "$3/input"
+    rm -f "$3/input.bak"
+    (cd "$3" && OMP_NUM_THREADS=$2 "$sim" > yaps_sim.log 2>&1) || {
+        echo "yaps_sim failed in $3" >&2
+        exit 1
+    }
+    if [ ! -f "$3/timing.json" ] || [ ! -f "$3/pairs.csv" ]; then
+        echo "no timing.json or pairs.csv in $3, build yaps_sim with YAPS_TIME" >&2
+        exit 1
+    fi
+    pairs=$(awk -F, 'NR > 1 { a += $3 } END { printf "%.0f", a }' "$3/pairs.csv")
+    awk -F'[:,]' -v pairs=$pairs '/^  "particles"/ { p = $2 } 
+                  /^  "seconds"/ { s = $2 } 
+                  /^  "updates_per_second"/ { u = $2 } 
+                  END { print p + 0, s + 0, u + 0, pairs }' "$3/timing.json"
+}
+
+# parse command line
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -gen)     gen "$2" "$3" "$4"; exit 0 ;;
+        -sim)     sim=$2; shift ;;
+        -dim)     dim=$2; shift ;;
+        -n)       n=$2; shift ;;
+        -steps)   steps=$2; shift ;;
+        -threads) threads=$2; shift ;;
+        -mode)    mode=$2; shift ;;
+        -dir)     dir=$2; shift ;;
+        *)        sed -n '4,12p' "$0" | sed 's/^# \{0,1\}//'; exit 1 ;;
+    esac
+    shift
+done
+
+case "$sim" in
+    /*) ;;
+    *)  sim="$(pwd)/$sim" ;;
+esac
+if [ ! -x "$sim" ]; then
+    echo "Can't find $sim" >&2
+    exit 1
+fi
+mkdir -p "$dir"
+csv="$dir/scaling.csv"
+echo "mode,threads,particles,seconds,updates_per_second,pairs_per_second_per_thread,speedup,efficiency" > "$csv"
+t1=${threads%% *}
+
+for m in strong weak; do
+    [ "$mode" = both ] || [ "$mode" = $m ] || continue
+    echo
+    echo "$m scaling, dimension $dim, $steps steps"
+    printf "%8s %10s %10s %12s %14s %8s %6s\n" threads particles seconds \
+           "updates/s" "pairs/s/thread" speedup eff
+    base=
+    ubase=
+    for t in $threads; do
+        if [ $m = strong ]; then
+            np=$n
+        else
+            np=$(awk -v n=$n -v t=$t -v t1=$t1 'BEGIN { print int( n * t / t1) }')
+        fi
+        out=$(run $np $t "$dir/${m}_$t") || exit 1
+        set -- $out
+        if [ $# -ne 4 ]; then
+            echo "can't read the timing of $dir/${m}_$t" >&2
+            exit 1
+        fi
+        [ -n "$base" ] || base=$2
+        [ -n "$ubase" ] || ubase=$3
+        awk -v m=$m -v t=$t -v t1=$t1 -v p=$1 -v s=$2 -v u=$3 -v b=$base \
+            -v ub=$ubase -v pairs=$4 -v csv="$csv" 'BEGIN {
+            pps = (s > 0) ? pairs / s / t : 0
+            sp = (s > 0) ? b / s : 0
+            if ( m == "strong" )
+                eff = sp * t1 / t
+            else
+                eff = (ub > 0) ? (u / t) / (ub / t1) : 0
+            printf "%8d %10d %10.3f %12.4g %14.4g %8.2f %5.0f%%\n", 
+                   t, p, s, u, pps, sp, 100 * eff
+            printf "%s,%d,%d,%.6f,%.6g,%.6g,%.4f,%.4f\n", 
+                   m, t, p, s, u, pps, sp, eff >> csv
+        }'
+    done
+done